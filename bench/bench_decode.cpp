@@ -0,0 +1,138 @@
+// 解码基准: 用每个已注册的后端解码 data/ 下所有图片, 输出 MB/s 与峰值 RSS
+// 用法: bench_decode [data_dir] [iterations]
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+
+#include "../io/image_decoder.h"
+
+#ifndef DATA_DIR
+#define DATA_DIR "./data"
+#endif
+
+struct ImageFile{
+    std::string path;
+    std::vector<unsigned char> bytes;
+};
+
+bool has_image_extension(const std::string& name){
+    size_t pos = name.find_last_of('.');
+    if(pos == std::string::npos)
+        return false;
+    std::string ext = name.substr(pos + 1);
+    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+    return ext == "png" || ext == "jpg" || ext == "jpeg";
+}
+
+void collect_images(const std::string& dir, std::vector<ImageFile>& files){
+    DIR* dp = opendir(dir.c_str());
+    if(!dp){
+        std::cout << "ERROR: open dir fail, path " << dir << std::endl;
+        return;
+    }
+    std::vector<std::string> names;
+    while(dirent* entry = readdir(dp)){
+        std::string name = entry->d_name;
+        if(name != "." && name != "..")
+            names.push_back(name);
+    }
+    closedir(dp);
+    std::sort(names.begin(), names.end());
+
+    for(const std::string& name : names){
+        const std::string path = dir + "/" + name;
+        DIR* sub = opendir(path.c_str());
+        if(sub){
+            closedir(sub);
+            collect_images(path, files);
+        }else if(has_image_extension(name)){
+            std::ifstream fp(path, std::ios::binary);
+            ImageFile file;
+            file.path = path;
+            file.bytes.assign(std::istreambuf_iterator<char>(fp), std::istreambuf_iterator<char>());
+            files.push_back(std::move(file));
+        }
+    }
+}
+
+long peak_rss_kb(){
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+// - 在子进程中运行, 让每个后端的峰值 RSS 互不影响
+void run_backend(const ImageDecoder& decoder, const std::vector<ImageFile>& files, const int iterations, const long baseline_kb){
+    double total_seconds = 0.0;
+    size_t total_in = 0, total_out = 0, decoded_files = 0;
+
+    for(const ImageFile& file : files){
+        if(!decoder.can_decode(file.bytes.data(), file.bytes.size()))
+            continue;
+
+        size_t out_bytes = 0;
+        bool ok = true;
+        auto start = std::chrono::steady_clock::now();
+        for(int i=0; i<iterations && ok; i++){
+            DecodedImage image;
+            ok = decoder.decode(file.bytes.data(), file.bytes.size(), 0, image);
+            out_bytes = image.pixels.size();
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if(!ok){
+            std::cout << std::left << std::setw(14) << decoder.name() << " FAIL " << file.path << std::endl;
+            continue;
+        }
+
+        total_seconds += seconds;
+        total_in += file.bytes.size() * iterations;
+        total_out += out_bytes * iterations;
+        decoded_files++;
+        std::cout << std::left << std::setw(14) << decoder.name() << std::right << std::fixed << std::setprecision(2)
+                  << std::setw(9) << seconds * 1000.0 / iterations << " ms"
+                  << std::setw(10) << file.bytes.size() * iterations / seconds / 1e6 << " MB/s in"
+                  << std::setw(10) << out_bytes * iterations / seconds / 1e6 << " MB/s out  "
+                  << file.path << std::endl;
+    }
+
+    std::cout << "TOTAL " << std::left << std::setw(14) << decoder.name() << std::right << std::fixed << std::setprecision(2)
+              << " files " << decoded_files
+              << ", " << (total_seconds > 0 ? total_in / total_seconds / 1e6 : 0.0) << " MB/s in"
+              << ", " << (total_seconds > 0 ? total_out / total_seconds / 1e6 : 0.0) << " MB/s out"
+              << ", peak_rss " << peak_rss_kb() << " KB (+" << std::max(0L, peak_rss_kb() - baseline_kb) << " KB)" << std::endl;
+}
+
+int main(int argc, char** argv){
+    const std::string data_dir = argc > 1 ? argv[1] : DATA_DIR;
+    const int iterations = argc > 2 ? std::max(1, atoi(argv[2])) : 3;
+
+    std::vector<ImageFile> files;
+    collect_images(data_dir, files);
+    std::cout << "images " << files.size() << " under " << data_dir << ", iterations " << iterations << std::endl;
+    if(files.empty())
+        return -1;
+
+    const long baseline_kb = peak_rss_kb();
+    for(const ImageDecoder* decoder : image_decoders()){
+        std::cout.flush();
+        pid_t pid = fork();
+        if(pid == 0){
+            run_backend(*decoder, files, iterations, baseline_kb);
+            std::cout.flush();
+            _exit(0);
+        }
+        int status;
+        waitpid(pid, &status, 0);
+    }
+    return 0;
+}
@@ -0,0 +1,166 @@
+// 网格编解码基准: nanosuit 各 mesh 与生成的大网格, 输出压缩率、编码耗时与解码吞吐
+// 用法: bench_mesh_codec [model_path] [iterations]
+
+#include <cmath>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+
+#include "../io/mesh_codec.h"
+
+#ifndef DATA_DIR
+#define DATA_DIR "./data"
+#endif
+
+struct BenchMesh{
+    std::string name;
+    std::vector<Vertex> vertices;
+    std::vector<unsigned int> indices;
+};
+
+// - 与 Model::process_mesh 相同的导入参数与属性
+void load_meshes(const std::string& path, std::vector<BenchMesh>& meshes){
+    Assimp::Importer importer;
+    const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
+    if(!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE){
+        std::cout << "ERROR: import fail, path " << path << std::endl;
+        return;
+    }
+    for(unsigned int m=0; m<scene->mNumMeshes; m++){
+        const aiMesh* ai_mesh = scene->mMeshes[m];
+        BenchMesh mesh;
+        mesh.name = "model:" + std::string(ai_mesh->mName.C_Str());
+        for(unsigned int i=0; i<ai_mesh->mNumVertices; i++){
+            Vertex vertex;
+            vertex.pos = glm::vec3(ai_mesh->mVertices[i].x, ai_mesh->mVertices[i].y, ai_mesh->mVertices[i].z);
+            if(ai_mesh->HasNormals())
+                vertex.normal = glm::vec3(ai_mesh->mNormals[i].x, ai_mesh->mNormals[i].y, ai_mesh->mNormals[i].z);
+            if(ai_mesh->mTextureCoords[0]){
+                vertex.tex_coord = glm::vec2(ai_mesh->mTextureCoords[0][i].x, ai_mesh->mTextureCoords[0][i].y);
+                vertex.tangent = glm::vec3(ai_mesh->mTangents[i].x, ai_mesh->mTangents[i].y, ai_mesh->mTangents[i].z);
+                vertex.bitangent = glm::vec3(ai_mesh->mBitangents[i].x, ai_mesh->mBitangents[i].y, ai_mesh->mBitangents[i].z);
+            }
+            mesh.vertices.push_back(vertex);
+        }
+        for(unsigned int f=0; f<ai_mesh->mNumFaces; f++){
+            for(unsigned int j=0; j<ai_mesh->mFaces[f].mNumIndices; j++)
+                mesh.indices.push_back(ai_mesh->mFaces[f].mIndices[j]);
+        }
+        meshes.push_back(std::move(mesh));
+    }
+}
+
+// - 带起伏的规则网格, 顶点按行优先, 三角形按行输出
+BenchMesh make_grid(const int size){
+    BenchMesh mesh;
+    mesh.name = "grid " + std::to_string(size) + "x" + std::to_string(size);
+    for(int y=0; y<=size; y++){
+        for(int x=0; x<=size; x++){
+            const float u = x / static_cast<float>(size), v = y / static_cast<float>(size);
+            const float h = 0.05f * std::sin(u * 40.0f) * std::cos(v * 40.0f);
+            Vertex vertex;
+            vertex.pos = glm::vec3(u * 10.0f, h, v * 10.0f);
+            vertex.normal = glm::normalize(glm::vec3(-2.0f * std::cos(u * 40.0f) * std::cos(v * 40.0f) * 0.1f, 1.0f,
+                                                     2.0f * std::sin(u * 40.0f) * std::sin(v * 40.0f) * 0.1f));
+            vertex.tex_coord = glm::vec2(u * 4.0f, v * 4.0f);
+            vertex.tangent = glm::vec3(1.0f, 0.0f, 0.0f);
+            vertex.bitangent = glm::vec3(0.0f, 0.0f, 1.0f);
+            mesh.vertices.push_back(vertex);
+        }
+    }
+    for(int y=0; y<size; y++){
+        for(int x=0; x<size; x++){
+            const unsigned int i0 = y * (size + 1) + x, i1 = i0 + 1, i2 = i0 + size + 1, i3 = i2 + 1;
+            mesh.indices.insert(mesh.indices.end(), {i0, i2, i1, i1, i2, i3});
+        }
+    }
+    return mesh;
+}
+
+// - FIFO 缓存模拟, 平均每个三角形的缓存未命中数
+double acmr(const std::vector<unsigned int>& indices, const size_t vertex_count, const unsigned int cache_size = 16){
+    std::vector<size_t> timestamp(vertex_count, 0);
+    size_t time = cache_size + 1, misses = 0;
+    for(unsigned int index : indices){
+        if(time - timestamp[index] > cache_size){
+            timestamp[index] = time++;
+            misses++;
+        }
+    }
+    return indices.empty() ? 0.0 : misses * 3.0 / indices.size();
+}
+
+void run_mesh(const BenchMesh& source, const int iterations){
+    BenchMesh mesh = source;
+    const size_t raw_bytes = mesh.vertices.size() * sizeof(Vertex) + mesh.indices.size() * sizeof(unsigned int);
+    const double acmr_before = acmr(mesh.indices, mesh.vertices.size());
+
+    std::vector<unsigned char> encoded;
+    auto start = std::chrono::steady_clock::now();
+    if(!encode_mesh(mesh.vertices, mesh.indices, encoded)){
+        std::cout << "FAIL encode " << source.name << std::endl;
+        return;
+    }
+    const double encode_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    // - 取最快一次, 排除首次缺页
+    std::vector<Vertex> vertices;
+    std::vector<unsigned int> indices;
+    double decode_s = 1e30, copy_s = 1e30;
+    std::vector<unsigned char> raw(raw_bytes), copy(raw_bytes);
+    for(int i=0; i<iterations; i++){
+        start = std::chrono::steady_clock::now();
+        if(!decode_mesh(encoded.data(), encoded.size(), vertices, indices)){
+            std::cout << "FAIL decode " << source.name << std::endl;
+            return;
+        }
+        decode_s = std::min(decode_s, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+
+        start = std::chrono::steady_clock::now();
+        std::memcpy(copy.data(), raw.data(), raw_bytes);
+        copy_s = std::min(copy_s, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+
+    float max_error = 0.0f;
+    for(size_t i=0; i<vertices.size(); i++){
+        for(int k=0; k<3; k++)
+            max_error = std::max(max_error, std::fabs(vertices[i].pos[k] - mesh.vertices[i].pos[k]));
+    }
+
+    std::cout << std::left << std::setw(28) << source.name.substr(0, 27) << std::right << std::fixed << std::setprecision(2)
+              << std::setw(9) << source.vertices.size() << std::setw(9) << source.indices.size() / 3
+              << std::setw(10) << raw_bytes / 1024.0 << std::setw(10) << encoded.size() / 1024.0
+              << std::setw(8) << static_cast<double>(raw_bytes) / encoded.size()
+              << std::setw(10) << encode_ms
+              << std::setw(9) << raw_bytes / decode_s / 1e9
+              << std::setw(9) << raw_bytes / copy_s / 1e9
+              << std::setw(7) << acmr_before << std::setw(7) << acmr(mesh.indices, mesh.vertices.size())
+              << std::scientific << std::setprecision(1) << std::setw(10) << max_error << std::endl;
+}
+
+int main(int argc, char** argv){
+    const std::string model_path = argc > 1 ? argv[1] : DATA_DIR "/nanosuit/nanosuit.obj";
+    const int iterations = argc > 2 ? std::max(1, atoi(argv[2])) : 5;
+
+    std::vector<BenchMesh> meshes;
+    load_meshes(model_path, meshes);
+    meshes.push_back(make_grid(256));
+    meshes.push_back(make_grid(1024));
+
+    // - decode / memcpy 吞吐都按未压缩的 Vertex + 索引字节数计
+    std::cout << std::left << std::setw(28) << "mesh" << std::right << std::setw(9) << "verts" << std::setw(9) << "tris"
+              << std::setw(10) << "raw KB" << std::setw(10) << "enc KB" << std::setw(8) << "ratio"
+              << std::setw(10) << "enc ms" << std::setw(9) << "dec GB/s" << std::setw(9) << "cpy GB/s"
+              << std::setw(7) << "acmr0" << std::setw(7) << "acmr1" << std::setw(10) << "pos err" << std::endl;
+    for(const BenchMesh& mesh : meshes)
+        run_mesh(mesh, iterations);
+    return 0;
+}
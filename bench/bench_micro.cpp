@@ -0,0 +1,467 @@
+// 加载与每帧热点的微基准(Google Benchmark), 输入固定, 优化前后结果可直接对比
+// - 加载: Model::process_mesh 顶点转换、Model::process_material 材质查找、每张图片的解码(stb 与已注册的后端)、
+//   二进制 PLY 的三角形 / 四边形面解码
+// - 每帧: Camera::compute_camera_mat4 / update_forward、模型矩阵的逆转置、每次绘制的 uniform 与纹理绑定
+// 用法: bench_micro [--benchmark_filter=<regex>] [--benchmark_out=<file> --benchmark_out_format=json]
+// 加载日志在 stdout, 需要可比较的结果时用 --benchmark_out 写 JSON
+// 需要 GL 的基准使用 surfaceless EGL context, 创建失败时跳过
+
+#include <map>
+#include <string>
+#include <vector>
+#include <memory>
+#include <fstream>
+#include <iostream>
+
+#include <benchmark/benchmark.h>
+
+#include <glad/glad.h>
+
+#include <assimp/scene.h>
+
+#include "../camera/camera.h"
+#include "../io/model.h"
+#include "../io/vfs.h"
+#include "../io/image_decoder.h"
+#include "../io/ply.h"
+#include "../shader/shader.h"
+#include "../render/ring_buffer.h"
+#include "../render/gl_handle.h"
+#include "./egl_context.h"
+
+#ifndef PROJECT_ROOT_DIR
+#define PROJECT_ROOT_DIR "."
+#endif
+
+// 与 shader 中 FrameBlock (std140) 布局一致
+struct FrameUniforms{
+    glm::mat4 model_mat;
+    glm::mat4 view_mat;
+    glm::mat4 projection_mat;
+    glm::mat4 normal_model_mat;
+    glm::vec4 light_pos;
+    glm::vec4 camera_pos;
+};
+const unsigned int kFrameBlockBinding = 0;
+
+// - 解码基准的固定输入: 小图与大图各一张, 加上法线 / 高光各一张
+const char* kImageFiles[] = {"glass_dif.png", "arm_dif.png", "arm_showroom_ddn.png", "arm_showroom_spec.png"};
+// - 材质中每种角色的贴图名, process_material 只走 loaded_texture 命中的路径
+const char* kMaterialTextures[][2] = {{"arm_dif.png", "diffuse"}, {"arm_showroom_spec.png", "specular"},
+                                      {"arm_showroom_ddn.png", "normal"}, {"arm_showroom_ddn.png", "height"}};
+
+/**
+ * 合成的单 mesh 场景: 边长 grid 的网格, 位置 / 法线 / UV / 切线齐全, 材质带四种贴图
+ * 按 assimp 的所有权用 new[] 分配; 同一 grid 只建一次, 进程内常驻, 不释放
+*/
+const aiScene* make_grid_scene(const unsigned int grid){
+    static std::map<unsigned int, const aiScene*> scenes;
+    if(scenes.count(grid))
+        return scenes[grid];
+
+    aiMesh* mesh = new aiMesh();
+    mesh->mNumVertices = grid * grid;
+    mesh->mVertices = new aiVector3D[mesh->mNumVertices];
+    mesh->mNormals = new aiVector3D[mesh->mNumVertices];
+    mesh->mTangents = new aiVector3D[mesh->mNumVertices];
+    mesh->mBitangents = new aiVector3D[mesh->mNumVertices];
+    mesh->mTextureCoords[0] = new aiVector3D[mesh->mNumVertices];
+    for(unsigned int y=0; y<grid; y++){
+        for(unsigned int x=0; x<grid; x++){
+            const unsigned int i = y * grid + x;
+            const float u = static_cast<float>(x) / (grid - 1), v = static_cast<float>(y) / (grid - 1);
+            mesh->mVertices[i] = aiVector3D{u, 0.0f, v};
+            mesh->mNormals[i] = aiVector3D{0.0f, 1.0f, 0.0f};
+            mesh->mTangents[i] = aiVector3D{1.0f, 0.0f, 0.0f};
+            mesh->mBitangents[i] = aiVector3D{0.0f, 0.0f, 1.0f};
+            mesh->mTextureCoords[0][i] = aiVector3D{u, v, 0.0f};
+        }
+    }
+    mesh->mNumFaces = (grid - 1) * (grid - 1) * 2;
+    mesh->mFaces = new aiFace[mesh->mNumFaces];
+    unsigned int face = 0;
+    for(unsigned int y=0; y+1<grid; y++){
+        for(unsigned int x=0; x+1<grid; x++){
+            const unsigned int i = y * grid + x;
+            const unsigned int quad[2][3] = {{i, i + grid, i + 1}, {i + 1, i + grid, i + grid + 1}};
+            for(const unsigned int* corners : quad){
+                mesh->mFaces[face].mNumIndices = 3;
+                mesh->mFaces[face].mIndices = new unsigned int[3]{corners[0], corners[1], corners[2]};
+                face++;
+            }
+        }
+    }
+
+    aiMaterial* material = new aiMaterial();
+    const aiTextureType types[] = {aiTextureType_DIFFUSE, aiTextureType_SPECULAR, aiTextureType_NORMALS, aiTextureType_HEIGHT};
+    for(int i=0; i<4; i++){
+        const aiString name(std::string(kMaterialTextures[i][0]));
+        material->AddProperty(&name, AI_MATKEY_TEXTURE(types[i], 0));
+    }
+
+    aiScene* scene = new aiScene();
+    scene->mNumMeshes = 1;
+    scene->mMeshes = new aiMesh*[1]{mesh};
+    scene->mNumMaterials = 1;
+    scene->mMaterials = new aiMaterial*[1]{material};
+    scene->mRootNode = new aiNode();
+    scenes[grid] = scene;
+    return scene;
+}
+
+// - 没有 mesh 的 Model, 贴图表预先填好, 不触发真正的纹理加载
+Model& bench_model(){
+    static const aiScene* empty_scene = [](){
+        aiScene* scene = new aiScene();
+        scene->mRootNode = new aiNode();
+        return scene;
+    }();
+    static Model model("data/bench/grid.obj", empty_scene);
+    if(model.loaded_texture.empty()){
+        for(const auto& texture : kMaterialTextures)
+            model.loaded_texture.insert({texture[0], Texture(0, texture[1], texture[0])});
+    }
+    return model;
+}
+
+void BM_ProcessMesh(benchmark::State& state){
+    const aiScene* scene = make_grid_scene(static_cast<unsigned int>(state.range(0)));
+    Model& model = bench_model();
+    for(auto _ : state){
+        Mesh mesh = model.process_mesh(scene->mMeshes[0], scene);
+        benchmark::DoNotOptimize(mesh.vertices_.data());
+    }
+    state.SetItemsProcessed(state.iterations() * scene->mMeshes[0]->mNumVertices);
+}
+BENCHMARK(BM_ProcessMesh)->Arg(16)->Arg(256);
+
+void BM_ProcessMaterial(benchmark::State& state){
+    const aiScene* scene = make_grid_scene(2);
+    Model& model = bench_model();
+    const aiTextureType types[] = {aiTextureType_DIFFUSE, aiTextureType_SPECULAR, aiTextureType_NORMALS, aiTextureType_HEIGHT};
+    for(auto _ : state){
+        for(const aiTextureType type : types){
+            std::vector<Texture> textures = model.process_material(scene->mMaterials[0], type);
+            benchmark::DoNotOptimize(textures.data());
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * 4);
+}
+BENCHMARK(BM_ProcessMaterial);
+
+/**
+ * 合成的二进制 PLY: 边长 grid 的网格, 每格一个四边形(sides 为 4)或两个三角形(sides 为 3)
+ * 面数超过 kPlyChunkRows, 快速路径会分多块并行; 同一参数只写一次
+*/
+const std::string& make_grid_ply(const unsigned int grid, const int sides){
+    static std::map<std::pair<unsigned int, int>, std::string> files;
+    const auto key = std::make_pair(grid, sides);
+    if(files.count(key))
+        return files[key];
+
+    const unsigned int cells = (grid - 1) * (grid - 1);
+    const unsigned int faces = sides == 4 ? cells : cells * 2;
+    const std::string path = "/tmp/bench_micro_grid_" + std::to_string(grid) + "_" + std::to_string(sides) + ".ply";
+    std::ofstream out(path, std::ios::binary);
+    out << "ply\nformat binary_little_endian 1.0\n"
+        << "element vertex " << grid * grid << "\nproperty float x\nproperty float y\nproperty float z\n"
+        << "element face " << faces << "\nproperty list uchar int vertex_indices\nend_header\n";
+    for(unsigned int y=0; y<grid; y++){
+        for(unsigned int x=0; x<grid; x++){
+            const float position[3] = {static_cast<float>(x), static_cast<float>(y), 0.0f};
+            out.write(reinterpret_cast<const char*>(position), sizeof(position));
+        }
+    }
+    auto write_face = [&out](std::initializer_list<int> indices){
+        const unsigned char count = static_cast<unsigned char>(indices.size());
+        out.write(reinterpret_cast<const char*>(&count), 1);
+        for(const int index : indices)
+            out.write(reinterpret_cast<const char*>(&index), sizeof(index));
+    };
+    for(unsigned int y=0; y+1<grid; y++){
+        for(unsigned int x=0; x+1<grid; x++){
+            const int a = y * grid + x, b = a + 1, c = a + grid + 1, d = a + grid;
+            if(sides == 4){
+                write_face({a, b, c, d});
+            }else{
+                write_face({a, b, c});
+                write_face({a, c, d});
+            }
+        }
+    }
+    files[key] = path;
+    return files[key];
+}
+
+// - 四边形文件走逐行的扇形拆分, 结果应与三角形文件的索引数相同
+void BM_PlyReadFaces(benchmark::State& state){
+    const unsigned int grid = 300;
+    const std::string& path = make_grid_ply(grid, static_cast<int>(state.range(0)));
+    const size_t expected = static_cast<size_t>(grid - 1) * (grid - 1) * 6;
+    for(auto _ : state){
+        PlyFile ply;
+        PlyData data;
+        if(!ply.open(path) || !ply.read(data)){
+            state.SkipWithError("PLY read fail");
+            break;
+        }
+        if(data.indices.size() != expected){
+            state.SkipWithError("PLY face count mismatch");
+            break;
+        }
+        benchmark::DoNotOptimize(data.indices.data());
+    }
+    state.SetItemsProcessed(state.iterations() * expected / 3);
+}
+BENCHMARK(BM_PlyReadFaces)->ArgName("sides")->Arg(3)->Arg(4)->Unit(benchmark::kMillisecond);
+
+/**
+ * 开头一个四边形, 之后全是三角形 {1, 2, 3}: 快速路径的后续块按三角形行长错位读取时,
+ * 读到的列表长度恰好是 3, 索引是越界的垃圾值; 应退回通用路径, 而不是报索引越界
+*/
+void BM_PlyReadMixedFaces(benchmark::State& state){
+    const unsigned int triangles = 1 << 20;
+    static const std::string path = [triangles](){
+        const std::string file = "/tmp/bench_micro_mixed.ply";
+        std::ofstream out(file, std::ios::binary);
+        out << "ply\nformat binary_little_endian 1.0\n"
+            << "element vertex 4\nproperty float x\nproperty float y\nproperty float z\n"
+            << "element face " << triangles + 1 << "\nproperty list uchar int vertex_indices\nend_header\n";
+        const float positions[12] = {0, 0, 0, 1, 0, 0, 1, 1, 0, 0, 1, 0};
+        out.write(reinterpret_cast<const char*>(positions), sizeof(positions));
+        const unsigned char quad_count = 4, triangle_count = 3;
+        const int quad[4] = {0, 1, 2, 3}, triangle[3] = {1, 2, 3};
+        out.write(reinterpret_cast<const char*>(&quad_count), 1);
+        out.write(reinterpret_cast<const char*>(quad), sizeof(quad));
+        for(unsigned int i=0; i<triangles; i++){
+            out.write(reinterpret_cast<const char*>(&triangle_count), 1);
+            out.write(reinterpret_cast<const char*>(triangle), sizeof(triangle));
+        }
+        return file;
+    }();
+    const size_t expected = (static_cast<size_t>(triangles) + 2) * 3;
+    for(auto _ : state){
+        PlyFile ply;
+        PlyData data;
+        if(!ply.open(path) || !ply.read(data)){
+            state.SkipWithError("PLY read fail");
+            break;
+        }
+        if(data.indices.size() != expected){
+            state.SkipWithError("PLY face count mismatch");
+            break;
+        }
+        benchmark::DoNotOptimize(data.indices.data());
+    }
+    state.SetItemsProcessed(state.iterations() * expected / 3);
+}
+BENCHMARK(BM_PlyReadMixedFaces)->Unit(benchmark::kMillisecond);
+
+// - 每个后端 x 每张图片注册一个基准, 文件先读入内存, 只测解码
+void register_decode_benchmarks(){
+    for(const char* file : kImageFiles){
+        MappedFile mapped = Vfs::instance().map(std::string("data/nanosuit/") + file);
+        if(!mapped.valid()){
+            std::cout << "WARN: bench image missing, path data/nanosuit/" << file << std::endl;
+            continue;
+        }
+        std::shared_ptr<std::vector<unsigned char>> bytes(
+            new std::vector<unsigned char>(mapped.data(), mapped.data() + mapped.size()));
+        for(const ImageDecoder* decoder : image_decoders()){
+            if(!decoder->can_decode(bytes->data(), bytes->size()))
+                continue;
+            const std::string name = std::string("BM_DecodeImage/") + decoder->name() + "/" + file;
+            benchmark::RegisterBenchmark(name.c_str(), [bytes, decoder](benchmark::State& state){
+                DecodedImage image;
+                for(auto _ : state){
+                    if(!decoder->decode(bytes->data(), bytes->size(), 0, image)){
+                        state.SkipWithError("decode fail");
+                        break;
+                    }
+                    benchmark::DoNotOptimize(image.pixels.data());
+                }
+                state.SetBytesProcessed(state.iterations() * bytes->size());
+                state.counters["pixels"] = image.width * image.height;
+            })->Unit(benchmark::kMillisecond);
+        }
+    }
+}
+
+void BM_CameraComputeMat4(benchmark::State& state){
+    Camera camera;
+    float yaw = 0.0f;
+    for(auto _ : state){
+        camera.yaw_ = yaw;
+        camera.compute_camera_mat4();
+        benchmark::DoNotOptimize(camera.camera_mat4_);
+        yaw += 0.01f;
+    }
+}
+BENCHMARK(BM_CameraComputeMat4);
+
+void BM_CameraUpdateForward(benchmark::State& state){
+    Camera camera;
+    camera.camera_pos_ = glm::vec3(0.0f, 5.0f, 10.0f);
+    float step = 0.01f;
+    for(auto _ : state){
+        camera.update_forward(step);
+        benchmark::DoNotOptimize(camera.view_mat4_);
+        step = -step;
+    }
+}
+BENCHMARK(BM_CameraUpdateForward);
+
+// - 主循环中每个对象的法线矩阵 transpose(inverse(model))
+void BM_NormalMatrix(benchmark::State& state){
+    float time = 0.0f;
+    for(auto _ : state){
+        const glm::mat4 model = glm::rotate(glm::mat4(1.0f), time, glm::vec3(0.0f, 1.0f, 0.0f));
+        glm::mat4 normal = glm::transpose(glm::inverse(model));
+        benchmark::DoNotOptimize(normal);
+        time += 0.001f;
+    }
+}
+BENCHMARK(BM_NormalMatrix);
+
+/**
+ * 每次绘制的 GL 状态: 1 个三角形的 mesh 与四张 1x1 贴图, 绘制本身几乎不花时间
+ * 第一次使用时创建 context; 失败时 GL 基准全部跳过
+*/
+struct DrawFixture{
+    bool ok{false};
+    std::unique_ptr<Shader> shader;
+    std::unique_ptr<RingBuffer> frame_ring;
+    int ubo_alignment{256};
+    Mesh mesh;
+    std::vector<unsigned int> textures;
+
+    // - 不析构: 其中的 GL 对象不能晚于 context 与 GlDeletionQueue 释放
+    static DrawFixture& instance(){
+        static DrawFixture* fixture = new DrawFixture();
+        return *fixture;
+    }
+
+private:
+    DrawFixture(){
+        if(!create_headless_context() || !create_framebuffer(64, 64))
+            return;
+        GlThreadQueue::instance().bind_current_thread();
+        shader.reset(new Shader(Shader::PathMap{{"vertex", "shader/object_shader_vertex.vs"},
+                                                {"frag", "shader/object_shader_fragment.fs"}}));
+        shader->bind_uniform_block("FrameBlock", kFrameBlockBinding);
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &ubo_alignment);
+        frame_ring.reset(new RingBuffer(GL_UNIFORM_BUFFER, 64 * 1024, 3));
+
+        mesh.vertices_.resize(3);
+        mesh.vertices_[1].pos = glm::vec3(1.0f, 0.0f, 0.0f);
+        mesh.vertices_[2].pos = glm::vec3(0.0f, 1.0f, 0.0f);
+        mesh.indices_ = {0, 1, 2};
+        mesh.setup_mesh();
+        const unsigned char pixel[4] = {255, 255, 255, 255};
+        for(const auto& texture : kMaterialTextures){
+            unsigned int id = 0;
+            glGenTextures(1, &id);
+            glBindTexture(GL_TEXTURE_2D, id);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixel);
+            textures.push_back(id);
+            mesh.textures_.push_back(Texture(id, texture[1], texture[0]));
+        }
+        // - 第一次绘制时驱动才编译 shader 变体, 不计入测量
+        shader->use();
+        mesh.draw(*shader);
+        GlDeletionQueue::instance().end_frame();
+        glFinish();
+        ok = glGetError() == GL_NO_ERROR;
+    }
+};
+
+// - Mesh::draw: 每张贴图拼 sampler 名、glGetUniformLocation、绑定, 再加一次绘制
+void BM_MeshDrawBindings(benchmark::State& state){
+    DrawFixture& fixture = DrawFixture::instance();
+    if(!fixture.ok){
+        state.SkipWithError("no GL context");
+        return;
+    }
+    fixture.shader->use();
+    int in_frame = 0;
+    for(auto _ : state){
+        fixture.mesh.draw(*fixture.shader);
+        // - 与主循环一样每帧处理一次延迟删除, 每 64 次绘制算一帧
+        if(++in_frame == 64){
+            GlDeletionQueue::instance().end_frame();
+            in_frame = 0;
+        }
+    }
+    GlDeletionQueue::instance().end_frame();
+    glFinish();
+}
+BENCHMARK(BM_MeshDrawBindings);
+
+// - 按名字设置 uniform: 每次调用一次 glGetUniformLocation
+void BM_ShaderSetUniformByName(benchmark::State& state){
+    DrawFixture& fixture = DrawFixture::instance();
+    if(!fixture.ok){
+        state.SkipWithError("no GL context");
+        return;
+    }
+    fixture.shader->use();
+    for(auto _ : state)
+        fixture.shader->set_int("tex_diffuse1", 0);
+    GlDeletionQueue::instance().end_frame();
+}
+BENCHMARK(BM_ShaderSetUniformByName);
+
+// - 主循环中每个绘制对象的 FrameBlock: 环形缓冲分配、写入、绑定范围
+void BM_FrameUniformsRing(benchmark::State& state){
+    DrawFixture& fixture = DrawFixture::instance();
+    if(!fixture.ok){
+        state.SkipWithError("no GL context");
+        return;
+    }
+    const glm::mat4 model = glm::rotate(glm::mat4(1.0f), 0.5f, glm::vec3(0.0f, 1.0f, 0.0f));
+    int in_frame = 0;
+    fixture.frame_ring->begin_frame();
+    for(auto _ : state){
+        // - 一段容量写满前换帧, 与每帧若干次绘制的用法一致
+        if(++in_frame == 64){
+            fixture.frame_ring->end_frame();
+            GlDeletionQueue::instance().end_frame();
+            fixture.frame_ring->begin_frame();
+            in_frame = 0;
+        }
+        size_t offset = 0;
+        FrameUniforms* uniforms = static_cast<FrameUniforms*>(
+            fixture.frame_ring->allocate(sizeof(FrameUniforms), fixture.ubo_alignment, offset));
+        if(!uniforms){
+            state.SkipWithError("ring buffer full");
+            break;
+        }
+        uniforms->model_mat = model;
+        uniforms->view_mat = model;
+        uniforms->projection_mat = model;
+        uniforms->normal_model_mat = model;
+        uniforms->light_pos = glm::vec4(10.0f, 10.0f, 10.0f, 1.0f);
+        uniforms->camera_pos = glm::vec4(0.0f, 5.0f, 10.0f, 1.0f);
+        fixture.frame_ring->flush();
+        glBindBufferRange(GL_UNIFORM_BUFFER, kFrameBlockBinding, fixture.frame_ring->buffer_id(), offset, sizeof(FrameUniforms));
+    }
+    fixture.frame_ring->end_frame();
+    GlDeletionQueue::instance().end_frame();
+    glFinish();
+}
+BENCHMARK(BM_FrameUniformsRing);
+
+int main(int argc, char** argv){
+    const char* root_env = std::getenv("TEST_OPENGL_ROOT");
+    const std::string root = root_env && *root_env ? root_env : PROJECT_ROOT_DIR;
+    Vfs::instance().mount("data", root + "/data");
+    Vfs::instance().mount("shader", root + "/shader");
+
+    register_decode_benchmarks();
+    benchmark::Initialize(&argc, argv);
+    if(benchmark::ReportUnrecognizedArguments(argc, argv))
+        return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,309 @@
+// 离屏渲染基准: surfaceless EGL context 渲染到 FBO, 沿固定相机路径绘制 N 帧, 不需要窗口与显示器
+// 输出帧时间 p50/p95/p99、每帧绘制调用与三角形数、三角形吞吐, 以及最后一帧的图像哈希(JSON)
+// 用法: bench_render [model_path] [frames] [still|orbit|dolly|replay:<camera.log>] [out.json]
+// replay 回放运行程序经 TEST_OPENGL_CAMERA_RECORD 录下的相机日志, 帧数取日志帧数与 frames 的较小值
+// 资源路径与运行程序一致(经 Vfs, TEST_OPENGL_ROOT 可覆盖根目录); 加载日志在 stdout, 结果默认写 bench_render.json
+
+#include <cmath>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <memory>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+
+#include <glad/glad.h>
+
+#include <json/json.h>
+
+#include "../camera/camera.h"
+#include "../camera/camera_log.h"
+#include "../io/model.h"
+#include "../io/vfs.h"
+#include "../shader/shader.h"
+#include "../render/ring_buffer.h"
+#include "./egl_context.h"
+
+#ifndef PROJECT_ROOT_DIR
+#define PROJECT_ROOT_DIR "."
+#endif
+
+// 与 shader 中 FrameBlock (std140) 布局一致
+struct FrameUniforms{
+    glm::mat4 model_mat;
+    glm::mat4 view_mat;
+    glm::mat4 projection_mat;
+    glm::mat4 normal_model_mat;
+    glm::vec4 light_pos;
+    glm::vec4 camera_pos;
+};
+const unsigned int kFrameBlockBinding = 0;
+
+// - 与运行程序的窗口尺寸相同, 结果可与交互运行对照
+const int kWidth = 800, kHeight = 600;
+// - 相机路径与模型旋转按固定步长推进, 与墙钟无关
+const float kFrameStep = 1.0f / 60.0f;
+const int kWarmupFrames = 10;
+
+enum class CameraPath{
+    STILL = 0,
+    ORBIT,      // 左右摆动偏航角, 并小幅俯仰
+    DOLLY,      // 沿视线前后移动
+    REPLAY      // 相机日志, 模型旋转也使用记录的帧时间
+};
+
+const std::string CameraPathStr(const CameraPath& path){
+    switch(path){
+        case CameraPath::STILL:
+            return "still";
+        case CameraPath::ORBIT:
+            return "orbit";
+        case CameraPath::DOLLY:
+            return "dolly";
+        case CameraPath::REPLAY:
+            return "replay";
+        default:
+            return "";
+    }
+}
+
+/**
+ * 第 frame 帧的相机增量, 经 Camera::update_camera / update_forward 施加
+ * 增量取路径函数相邻两帧之差, 累计结果与帧数一一对应, 同一帧号总是同一相机姿态
+*/
+void step_camera(Camera& camera, const CameraPath path, const int frame){
+    const float kPeriod = 240.0f;
+    const float phase = 2.0f * static_cast<float>(M_PI) / kPeriod;
+    const float delta_sin = std::sin(phase * (frame + 1)) - std::sin(phase * frame);
+    const float delta_cos = std::cos(phase * (frame + 1)) - std::cos(phase * frame);
+    switch(path){
+        case CameraPath::ORBIT:
+            camera.update_camera(15.0f * delta_cos, 60.0f * delta_sin);
+            break;
+        case CameraPath::DOLLY:
+            camera.update_forward(6.0f * delta_sin);
+            break;
+        default:
+            break;
+    }
+}
+
+Shader::PathMap get_path_map(const std::string& prefix){
+    return Shader::PathMap{{"vertex", "shader/" + prefix + "_shader_vertex.vs"},
+                           {"frag", "shader/" + prefix + "_shader_fragment.fs"}};
+}
+
+// - 最近秩分位数, values 已排序
+double percentile(const std::vector<double>& values, const double p){
+    if(values.empty())
+        return 0.0;
+    const size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * values.size()));
+    return values[std::min(values.size() - 1, rank > 0 ? rank - 1 : 0)];
+}
+
+Json::Value summarize(std::vector<double> values){
+    std::sort(values.begin(), values.end());
+    double sum = 0.0;
+    for(const double value : values)
+        sum += value;
+    Json::Value result;
+    result["mean"] = values.empty() ? 0.0 : sum / values.size();
+    result["min"] = values.empty() ? 0.0 : values.front();
+    result["p50"] = percentile(values, 50.0);
+    result["p95"] = percentile(values, 95.0);
+    result["p99"] = percentile(values, 99.0);
+    result["max"] = values.empty() ? 0.0 : values.back();
+    return result;
+}
+
+// - FNV-1a, 比较不同运行(或回放)最后一帧的画面是否一致
+uint64_t hash_pixels(const std::vector<unsigned char>& pixels){
+    uint64_t hash = 1469598103934665603ull;
+    for(const unsigned char byte : pixels){
+        hash ^= byte;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+int main(int argc, char** argv){
+    const std::string model_path = argc > 1 ? argv[1] : "data/nanosuit/nanosuit.obj";
+    int frames = argc > 2 ? std::max(1, std::atoi(argv[2])) : 600;
+    const std::string path_name = argc > 3 ? argv[3] : CameraPathStr(CameraPath::ORBIT);
+    const std::string out_path = argc > 4 ? argv[4] : "bench_render.json";
+
+    const std::string kReplayPrefix = CameraPathStr(CameraPath::REPLAY) + ":";
+    CameraPath path = CameraPath::STILL;
+    CameraReplay replay;
+    if(path_name.compare(0, kReplayPrefix.size(), kReplayPrefix) == 0){
+        path = CameraPath::REPLAY;
+        if(!replay.open(path_name.substr(kReplayPrefix.size())))
+            return -1;
+        if(replay.frame_count() == 0){
+            std::cout << "ERROR: camera log has no frames, path " << path_name.substr(kReplayPrefix.size()) << std::endl;
+            return -1;
+        }
+        frames = std::min<int>(frames, replay.frame_count());
+    }
+    else if(path_name == CameraPathStr(CameraPath::ORBIT))
+        path = CameraPath::ORBIT;
+    else if(path_name == CameraPathStr(CameraPath::DOLLY))
+        path = CameraPath::DOLLY;
+    else if(path_name != CameraPathStr(CameraPath::STILL)){
+        std::cout << "ERROR: unknown camera path " << path_name << ", expect still|orbit|dolly|replay:<camera.log>" << std::endl;
+        return -1;
+    }
+
+    const char* root_env = std::getenv("TEST_OPENGL_ROOT");
+    const std::string root = root_env && *root_env ? root_env : PROJECT_ROOT_DIR;
+    Vfs::instance().mount("data", root + "/data");
+    Vfs::instance().mount("shader", root + "/shader");
+
+    if(!create_headless_context())
+        return -1;
+    const unsigned int framebuffer = create_framebuffer(kWidth, kHeight);
+    if(!framebuffer)
+        return -1;
+    GlThreadQueue::instance().bind_current_thread();
+
+    // - 与运行程序相同的准备步骤: atlas、通道打包、上传、纹理数组
+    const auto load_start = std::chrono::steady_clock::now();
+    TextureManager::instance().keep_decoded(true);
+    Model model(model_path);
+    model.pack_small_textures();
+    std::vector<std::string> object_defines;
+    if(model.pack_material_channels() > 0)
+        object_defines.push_back("PACKED_CHANNELS");
+    model.setup_mesh();
+    Shader object_shader(get_path_map("object"), object_defines);
+    object_shader.bind_uniform_block("FrameBlock", kFrameBlockBinding);
+    std::unique_ptr<Shader> object_array_shader;
+    const bool use_texture_arrays = model.build_texture_arrays();
+    TextureManager::instance().keep_decoded(false);
+    if(use_texture_arrays){
+        object_array_shader.reset(new Shader(get_path_map("object_array")));
+        object_array_shader->bind_uniform_block("FrameBlock", kFrameBlockBinding);
+    }
+    glFinish();
+    const double load_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - load_start).count();
+
+    int ubo_alignment = 256;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &ubo_alignment);
+    std::unique_ptr<RingBuffer> frame_ring(new RingBuffer(GL_UNIFORM_BUFFER, 64 * 1024, 3));
+    glEnable(GL_DEPTH_TEST);
+
+    Camera camera;
+    camera.camera_pos_ = glm::vec3(0.0f, 5.0f, 10.0f);
+    camera.update_forward(0, 0);
+    if(replay.is_open())
+        replay.apply_initial(camera);
+    const glm::vec3 light_pos(10.0f, 10.0f, 10.0f);
+    const glm::mat4 projection = glm::perspective(glm::radians(90.0f), (float)kWidth / (float)kHeight, 0.1f, 200.0f);
+
+    std::vector<double> frame_ms, submit_ms;
+    frame_ms.reserve(frames);
+    submit_ms.reserve(frames);
+    uint64_t draw_calls = 0, triangles = 0;
+    const auto bench_start = std::chrono::steady_clock::now();
+    double measured_ms = 0.0;
+
+    // - 每帧以 glFinish 结束, 帧时间包含 GPU 执行; 前 kWarmupFrames 帧不计入
+    for(int i=-kWarmupFrames; i<frames; i++){
+        const int frame = std::max(0, i);
+        const auto start = std::chrono::steady_clock::now();
+        draw_stats() = DrawStats();
+
+        float time = frame * kFrameStep;
+        if(path == CameraPath::REPLAY){
+            // - 预热帧停在日志第一帧之前的状态
+            if(i >= 0)
+                replay.next_frame(camera, time);
+        }else if(i >= 0){
+            step_camera(camera, path, frame);
+        }
+        const glm::mat4 model_mat = glm::rotate(glm::mat4(1.0f), time, glm::vec3(0.0f, 1.0f, 0.0f));
+
+        glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        frame_ring->begin_frame();
+        size_t frame_offset = 0;
+        FrameUniforms* frame_uniforms = static_cast<FrameUniforms*>(
+                    frame_ring->allocate(sizeof(FrameUniforms), ubo_alignment, frame_offset));
+        if(frame_uniforms){
+            frame_uniforms->model_mat = model_mat;
+            frame_uniforms->view_mat = camera.view_mat4_;
+            frame_uniforms->projection_mat = projection;
+            frame_uniforms->normal_model_mat = glm::transpose(glm::inverse(model_mat));
+            frame_uniforms->light_pos = glm::vec4(light_pos, 1.0f);
+            frame_uniforms->camera_pos = glm::vec4(camera.camera_pos_, 1.0f);
+            frame_ring->flush();
+            glBindBufferRange(GL_UNIFORM_BUFFER, kFrameBlockBinding, frame_ring->buffer_id(), frame_offset, sizeof(FrameUniforms));
+        }
+        object_shader.use();
+        if(use_texture_arrays)
+            model.draw_batched(*object_array_shader, object_shader);
+        else
+            model.draw(object_shader);
+        frame_ring->end_frame();
+        GlDeletionQueue::instance().end_frame();
+        const auto submitted = std::chrono::steady_clock::now();
+        glFinish();
+        const auto end = std::chrono::steady_clock::now();
+
+        if(i < 0)
+            continue;
+        frame_ms.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+        submit_ms.push_back(std::chrono::duration<double, std::milli>(submitted - start).count());
+        measured_ms += frame_ms.back();
+        draw_calls += draw_stats().draw_calls;
+        triangles += draw_stats().triangles;
+    }
+    const double wall_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - bench_start).count();
+
+    std::vector<unsigned char> pixels(static_cast<size_t>(kWidth) * kHeight * 4);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, kWidth, kHeight, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+    const GLenum error = glGetError();
+
+    Json::Value root_json;
+    root_json["scene"] = model_path;
+    root_json["camera_path"] = CameraPathStr(path);
+    if(path == CameraPath::REPLAY)
+        root_json["camera_log"] = path_name.substr(kReplayPrefix.size());
+    root_json["frames"] = frames;
+    root_json["warmup_frames"] = kWarmupFrames;
+    root_json["width"] = kWidth;
+    root_json["height"] = kHeight;
+    root_json["renderer"] = reinterpret_cast<const char*>(glGetString(GL_RENDERER));
+    root_json["texture_arrays"] = use_texture_arrays;
+    root_json["load_ms"] = load_ms;
+    root_json["frame_ms"] = summarize(frame_ms);
+    root_json["submit_ms"] = summarize(submit_ms);
+    root_json["fps"] = measured_ms > 0.0 ? frames * 1000.0 / measured_ms : 0.0;
+    root_json["draw_calls_per_frame"] = static_cast<double>(draw_calls) / frames;
+    root_json["triangles_per_frame"] = static_cast<double>(triangles) / frames;
+    root_json["triangles_per_second"] = measured_ms > 0.0 ? triangles * 1000.0 / measured_ms : 0.0;
+    root_json["wall_ms"] = wall_ms;
+    root_json["image_hash"] = std::to_string(hash_pixels(pixels));
+    root_json["gl_error"] = static_cast<unsigned int>(error);
+
+    std::ofstream out(out_path);
+    if(!out){
+        std::cout << "ERROR: write bench result fail, path " << out_path << std::endl;
+        return -1;
+    }
+    Json::StreamWriterBuilder builder;
+    builder["indentation"] = "  ";
+    std::unique_ptr<Json::StreamWriter> writer(builder.newStreamWriter());
+    writer->write(root_json, &out);
+    out << std::endl;
+    std::cout << "OUT: bench_render " << CameraPathStr(path) << " " << frames << " frames, p50 " << root_json["frame_ms"]["p50"].asDouble()
+              << " ms, p95 " << root_json["frame_ms"]["p95"].asDouble() << " ms, p99 " << root_json["frame_ms"]["p99"].asDouble()
+              << " ms, " << root_json["triangles_per_frame"].asDouble() << " triangles / frame, result " << out_path << std::endl;
+
+    // - 环形缓冲持有 GL 对象, 须在 context 仍然当前时销毁
+    frame_ring.reset();
+    GlDeletionQueue::instance().flush();
+    return error == GL_NO_ERROR ? 0 : -1;
+}
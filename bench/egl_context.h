@@ -0,0 +1,69 @@
+#ifndef OPENGL_BENCH_EGL_CONTEXT_H_
+#define OPENGL_BENCH_EGL_CONTEXT_H_
+// 基准共用的无窗口 GL context 与离屏帧缓冲
+
+#include <iostream>
+
+#include <glad/glad.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+// - 不依赖窗口系统的 GL 3.3 core context; 优先 surfaceless 平台, 否则用默认 display
+inline bool create_headless_context(){
+    EGLDisplay display = EGL_NO_DISPLAY;
+    PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display =
+        reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+    if(get_platform_display)
+        display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    if(display == EGL_NO_DISPLAY)
+        display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    EGLint major = 0, minor = 0;
+    if(display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor)){
+        std::cout << "ERROR: EGL initialize fail" << std::endl;
+        return false;
+    }
+    if(!eglBindAPI(EGL_OPENGL_API)){
+        std::cout << "ERROR: EGL bind OpenGL API fail" << std::endl;
+        return false;
+    }
+    const EGLint context_attribs[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 3,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+    // - 不渲染到 surface, 不需要 config(EGL_KHR_no_config_context)
+    EGLContext context = eglCreateContext(display, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, context_attribs);
+    if(context == EGL_NO_CONTEXT || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)){
+        std::cout << "ERROR: EGL create surfaceless context fail, error " << std::hex << eglGetError() << std::dec << std::endl;
+        return false;
+    }
+    if(!gladLoadGLLoader(reinterpret_cast<GLADloadproc>(eglGetProcAddress))){
+        std::cout << "ERROR: Failed to initialize GLAD" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// - 颜色 + 深度的离屏目标, 代替默认帧缓冲
+inline unsigned int create_framebuffer(const int width, const int height){
+    unsigned int framebuffer = 0, color = 0, depth = 0;
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glGenRenderbuffers(1, &color);
+    glBindRenderbuffer(GL_RENDERBUFFER, color);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color);
+    glGenRenderbuffers(1, &depth);
+    glBindRenderbuffer(GL_RENDERBUFFER, depth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth);
+    if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE){
+        std::cout << "ERROR: offscreen framebuffer incomplete" << std::endl;
+        return 0;
+    }
+    glViewport(0, 0, width, height);
+    return framebuffer;
+}
+
+#endif
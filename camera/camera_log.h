@@ -0,0 +1,300 @@
+#ifndef OPENGL_CAMERA_LOG_H_
+#define OPENGL_CAMERA_LOG_H_
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iostream>
+
+#include "./camera.h"
+
+/**
+ * 相机输入日志: 记录施加到 Camera 的增量(而不是按键 / 鼠标状态), 回放时逐帧原样施加
+ * 文件格式(本机字节序):
+ *   头: "CAML", uint32 版本, 起始时的 CameraState
+ *   事件: uint8 类型 + 参数; FRAME 为一帧采样相机的时刻, 参数为该帧的时间(秒)
+ * 一帧内 FRAME 之前的事件在采样前施加; 之后的事件(例如 glfwPollEvents 中的滚轮)归下一帧, 与交互时一致
+ */
+enum class CameraEventType : uint8_t{
+    FRAME = 0,
+    ROTATE_CAMERA,      // update_camera(a, b)
+    ROTATE_OBJECT,      // update_object(a, b)
+    FORWARD,            // update_forward(a)
+    RESET
+};
+
+struct CameraEvent{
+    CameraEventType type{CameraEventType::FRAME};
+    float a{0.0f};
+    float b{0.0f};
+};
+
+// - 恢复相机所需的全部状态; 矩阵直接保存, update_forward 与 compute_camera_mat4 使用的 up 不同, 不能只存角度重算
+struct CameraState{
+    glm::vec3 camera_pos{0.0f};
+    glm::vec3 camera_front{0.0f, 0.0f, -1.0f};
+    float pitch{0.0f};
+    float yaw{0.0f};
+    float phi{0.0f};
+    float theta{0.0f};
+    glm::mat4 camera_mat4{1.0f};
+    glm::mat4 object_mat4{1.0f};
+
+    static CameraState capture(const Camera& camera);
+    void apply(Camera& camera) const;
+};
+
+/**
+ * 交互输入经它作用于相机: 总是施加, 打开日志时同时记录
+ */
+class CameraRecorder{
+public:
+    CameraRecorder(){}
+    ~CameraRecorder(){ close(); }
+
+    CameraRecorder(const CameraRecorder&) = delete;
+    CameraRecorder& operator=(const CameraRecorder&) = delete;
+
+    bool open(const std::string& path, const Camera& camera);
+    void close();
+    bool is_open() const { return out_.is_open(); }
+
+    void update_camera(Camera& camera, const float delta_pitch, const float delta_yaw);
+    void update_object(Camera& camera, const float delta_phi, const float delta_theta);
+    void update_forward(Camera& camera, const float delta_forward);
+    void reset(Camera& camera);
+
+    // - 本帧采样相机之前调用, time 为该帧使用的时间
+    void frame(const float time);
+
+private:
+    void write(const CameraEventType type, const float* values, const int count);
+
+private:
+    std::string path_;
+    std::ofstream out_;
+    uint64_t frames_{0};
+    uint64_t events_{0};
+    uint64_t bytes_{0};
+};
+
+/**
+ * 读取整个日志后逐帧回放
+ */
+class CameraReplay{
+public:
+    bool open(const std::string& path);
+
+    bool is_open() const { return opened_; }
+    size_t frame_count() const { return frame_count_; }
+    size_t frames_played() const { return frames_played_; }
+
+    // - 把相机恢复到记录开始时的状态, 回放之前调用
+    void apply_initial(Camera& camera) const { initial_.apply(camera); }
+
+    /**
+     * 施加到下一个 FRAME 为止的事件
+     *@ time: 输出该帧记录的时间
+     *@ return: 日志已结束时返回 false, 相机不变, time 为最后一帧的时间
+    */
+    bool next_frame(Camera& camera, float& time);
+
+private:
+    bool opened_{false};
+    CameraState initial_;
+    std::vector<CameraEvent> events_;
+    size_t cursor_{0};
+    size_t frame_count_{0};
+    size_t frames_played_{0};
+    float last_time_{0.0f};
+};
+
+
+const char kCameraLogMagic[4] = {'C', 'A', 'M', 'L'};
+const uint32_t kCameraLogVersion = 1;
+
+// - 各事件类型的 float 参数个数
+int camera_event_arity(const CameraEventType type){
+    switch(type){
+        case CameraEventType::FRAME:
+        case CameraEventType::FORWARD:
+            return 1;
+        case CameraEventType::ROTATE_CAMERA:
+        case CameraEventType::ROTATE_OBJECT:
+            return 2;
+        case CameraEventType::RESET:
+            return 0;
+        default:
+            return -1;
+    }
+}
+
+CameraState CameraState::capture(const Camera& camera){
+    CameraState state;
+    state.camera_pos = camera.camera_pos_;
+    state.camera_front = camera.camera_front_;
+    state.pitch = camera.pitch_;
+    state.yaw = camera.yaw_;
+    state.phi = camera.phi_;
+    state.theta = camera.theta_;
+    state.camera_mat4 = camera.camera_mat4_;
+    state.object_mat4 = camera.object_mat4_;
+    return state;
+}
+
+void CameraState::apply(Camera& camera) const{
+    camera.camera_pos_ = camera_pos;
+    camera.camera_front_ = camera_front;
+    camera.pitch_ = pitch;
+    camera.yaw_ = yaw;
+    camera.phi_ = phi;
+    camera.theta_ = theta;
+    camera.camera_mat4_ = camera_mat4;
+    camera.object_mat4_ = object_mat4;
+    camera.view_mat4_ = camera_mat4 * object_mat4;
+}
+
+bool CameraRecorder::open(const std::string& path, const Camera& camera){
+    close();
+    out_.open(path, std::ios::binary | std::ios::trunc);
+    if(!out_){
+        std::cout << "ERROR: open camera log fail, path " << path << std::endl;
+        return false;
+    }
+    path_ = path;
+    frames_ = events_ = 0;
+    const CameraState state = CameraState::capture(camera);
+    out_.write(kCameraLogMagic, sizeof(kCameraLogMagic));
+    out_.write(reinterpret_cast<const char*>(&kCameraLogVersion), sizeof(kCameraLogVersion));
+    out_.write(reinterpret_cast<const char*>(&state), sizeof(state));
+    bytes_ = sizeof(kCameraLogMagic) + sizeof(kCameraLogVersion) + sizeof(state);
+    return true;
+}
+
+void CameraRecorder::close(){
+    if(!out_.is_open())
+        return;
+    out_.close();
+    std::cout << "OUT: camera log " << frames_ << " frames, " << events_ << " events, "
+              << bytes_ << " bytes, path " << path_ << std::endl;
+}
+
+void CameraRecorder::write(const CameraEventType type, const float* values, const int count){
+    if(!out_.is_open())
+        return;
+    const uint8_t tag = static_cast<uint8_t>(type);
+    out_.write(reinterpret_cast<const char*>(&tag), sizeof(tag));
+    out_.write(reinterpret_cast<const char*>(values), count * sizeof(float));
+    bytes_ += sizeof(tag) + count * sizeof(float);
+    if(type == CameraEventType::FRAME)
+        frames_++;
+    else
+        events_++;
+}
+
+void CameraRecorder::update_camera(Camera& camera, const float delta_pitch, const float delta_yaw){
+    camera.update_camera(delta_pitch, delta_yaw);
+    const float values[2] = {delta_pitch, delta_yaw};
+    write(CameraEventType::ROTATE_CAMERA, values, 2);
+}
+
+void CameraRecorder::update_object(Camera& camera, const float delta_phi, const float delta_theta){
+    camera.update_object(delta_phi, delta_theta);
+    const float values[2] = {delta_phi, delta_theta};
+    write(CameraEventType::ROTATE_OBJECT, values, 2);
+}
+
+void CameraRecorder::update_forward(Camera& camera, const float delta_forward){
+    camera.update_forward(delta_forward);
+    write(CameraEventType::FORWARD, &delta_forward, 1);
+}
+
+void CameraRecorder::reset(Camera& camera){
+    camera.reset();
+    write(CameraEventType::RESET, nullptr, 0);
+}
+
+void CameraRecorder::frame(const float time){
+    write(CameraEventType::FRAME, &time, 1);
+}
+
+bool CameraReplay::open(const std::string& path){
+    opened_ = false;
+    events_.clear();
+    cursor_ = frame_count_ = frames_played_ = 0;
+    last_time_ = 0.0f;
+
+    std::ifstream in(path, std::ios::binary);
+    if(!in){
+        std::cout << "ERROR: open camera log fail, path " << path << std::endl;
+        return false;
+    }
+    std::vector<char> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    const size_t header_size = sizeof(kCameraLogMagic) + sizeof(uint32_t) + sizeof(CameraState);
+    uint32_t version = 0;
+    if(bytes.size() >= header_size)
+        std::memcpy(&version, bytes.data() + sizeof(kCameraLogMagic), sizeof(version));
+    if(bytes.size() < header_size || std::memcmp(bytes.data(), kCameraLogMagic, sizeof(kCameraLogMagic)) != 0 ||
+       version != kCameraLogVersion){
+        std::cout << "ERROR: not a camera log (or unsupported version), path " << path << std::endl;
+        return false;
+    }
+    std::memcpy(&initial_, bytes.data() + sizeof(kCameraLogMagic) + sizeof(uint32_t), sizeof(CameraState));
+
+    size_t offset = header_size;
+    while(offset < bytes.size()){
+        CameraEvent event;
+        event.type = static_cast<CameraEventType>(static_cast<uint8_t>(bytes[offset++]));
+        const int arity = camera_event_arity(event.type);
+        if(arity < 0 || offset + arity * sizeof(float) > bytes.size()){
+            // - 录制中断时末尾可能不完整, 保留之前完整的部分
+            std::cout << "WARN: camera log truncated at byte " << offset - 1 << ", path " << path << std::endl;
+            break;
+        }
+        float values[2] = {0.0f, 0.0f};
+        std::memcpy(values, bytes.data() + offset, arity * sizeof(float));
+        offset += arity * sizeof(float);
+        event.a = values[0];
+        event.b = values[1];
+        if(event.type == CameraEventType::FRAME)
+            frame_count_++;
+        events_.push_back(event);
+    }
+    opened_ = true;
+    std::cout << "OUT: camera replay " << frame_count_ << " frames, " << events_.size() - frame_count_
+              << " events, path " << path << std::endl;
+    return true;
+}
+
+bool CameraReplay::next_frame(Camera& camera, float& time){
+    if(frames_played_ >= frame_count_){
+        time = last_time_;
+        return false;
+    }
+    while(cursor_ < events_.size()){
+        const CameraEvent& event = events_[cursor_++];
+        switch(event.type){
+            case CameraEventType::FRAME:
+                time = last_time_ = event.a;
+                frames_played_++;
+                return true;
+            case CameraEventType::ROTATE_CAMERA:
+                camera.update_camera(event.a, event.b);
+                break;
+            case CameraEventType::ROTATE_OBJECT:
+                camera.update_object(event.a, event.b);
+                break;
+            case CameraEventType::FORWARD:
+                camera.update_forward(event.a);
+                break;
+            case CameraEventType::RESET:
+                camera.reset();
+                break;
+        }
+    }
+    return false;
+}
+
+#endif
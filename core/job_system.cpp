@@ -0,0 +1,258 @@
+#include "./job_system.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <algorithm>
+
+namespace{
+
+// - 当前线程所属的任务系统与 worker 序号, 用于决定任务放入自己的队列还是注入队列
+thread_local const JobSystem* tls_system = nullptr;
+thread_local unsigned int tls_index = 0;
+
+uint64_t now_ns(){
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+}
+
+JobSystem& JobSystem::instance(){
+    static JobSystem system([](){
+        unsigned int count = std::max(2u, std::thread::hardware_concurrency()) - 1;
+        if(const char* env = std::getenv("TEST_OPENGL_JOB_WORKERS"))
+            count = std::max(1, std::atoi(env));
+        return count;
+    }());
+    return system;
+}
+
+JobSystem::JobSystem(unsigned int worker_count){
+    worker_count = std::max(1u, worker_count);
+    for(unsigned int i=0; i<=worker_count; i++)
+        workers_.emplace_back(new Worker());
+    stats_start_ns_ = now_ns();
+    for(unsigned int i=0; i<worker_count; i++)
+        workers_[i]->thread = std::thread(&JobSystem::worker_loop, this, i);
+}
+
+JobSystem::~JobSystem(){
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        stop_ = true;
+    }
+    sleep_cv_.notify_all();
+    for(std::unique_ptr<Worker>& worker : workers_){
+        if(worker->thread.joinable())
+            worker->thread.join();
+    }
+}
+
+unsigned int JobSystem::current_index() const{
+    return tls_system == this ? tls_index : worker_count();
+}
+
+void JobSystem::push(JobTask&& task){
+    const unsigned int index = current_index();
+    if(index < worker_count()){
+        std::lock_guard<std::mutex> lock(workers_[index]->mutex);
+        workers_[index]->tasks.push_back(std::move(task));
+    }
+    else{
+        std::lock_guard<std::mutex> lock(inject_mutex_);
+        inject_.push_back(std::move(task));
+    }
+    // - 先计数再加锁通知, 休眠线程在锁内检查 queued_, 不会错过唤醒
+    queued_++;
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+    }
+    if(waiters_ > 0)
+        sleep_cv_.notify_all();
+    else
+        sleep_cv_.notify_one();
+}
+
+void JobSystem::run(Job job, JobCounter* counter, const char* name){
+    if(counter)
+        counter->value_.fetch_add(1, std::memory_order_acq_rel);
+    push(JobTask{std::move(job), counter, name});
+}
+
+void JobSystem::run_after(JobCounter& dependency, Job job, JobCounter* counter, const char* name){
+    if(counter)
+        counter->value_.fetch_add(1, std::memory_order_acq_rel);
+    JobTask task{std::move(job), counter, name};
+    {
+        // - 与 finish() 的递减在同一把锁内, 不会漏掉恰好归零的依赖
+        std::lock_guard<std::mutex> lock(dependency.mutex_);
+        if(dependency.value_.load(std::memory_order_acquire) != 0){
+            dependency.continuations_.push_back(std::move(task));
+            return;
+        }
+    }
+    push(std::move(task));
+}
+
+bool JobSystem::find_task(unsigned int index, JobTask& task){
+    if(queued_.load(std::memory_order_acquire) == 0)
+        return false;
+    const unsigned int count = worker_count();
+    if(index < count){
+        Worker& self = *workers_[index];
+        std::lock_guard<std::mutex> lock(self.mutex);
+        if(!self.tasks.empty()){
+            task = std::move(self.tasks.back());
+            self.tasks.pop_back();
+            queued_--;
+            return true;
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(inject_mutex_);
+        if(!inject_.empty()){
+            task = std::move(inject_.front());
+            inject_.pop_front();
+            queued_--;
+            return true;
+        }
+    }
+    // - 从相邻的 worker 开始偷, 分散竞争
+    for(unsigned int i=1; i<=count; i++){
+        const unsigned int victim = (index + i) % count;
+        if(victim == index)
+            continue;
+        Worker& other = *workers_[victim];
+        std::lock_guard<std::mutex> lock(other.mutex);
+        if(!other.tasks.empty()){
+            task = std::move(other.tasks.front());
+            other.tasks.pop_front();
+            queued_--;
+            workers_[index]->steals++;
+            return true;
+        }
+    }
+    return false;
+}
+
+void JobSystem::execute(unsigned int index, JobTask& task){
+    const uint64_t begin = now_ns();
+    task.job();
+    const uint64_t end = now_ns();
+
+    Worker& worker = *workers_[index];
+    worker.jobs++;
+    worker.busy_ns += end - begin;
+    if(trace_hook_)
+        trace_hook_(index, task.name, begin, end);
+
+    finish(task.counter);
+    if(waiters_ > 0){
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        sleep_cv_.notify_all();
+    }
+}
+
+void JobSystem::finish(JobCounter* counter){
+    if(!counter)
+        return;
+    std::vector<JobTask> continuations;
+    {
+        // - 递减在锁内: wait() 返回前会再取一次这把锁, 保证这里已不再访问 counter
+        std::lock_guard<std::mutex> lock(counter->mutex_);
+        if(counter->value_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            continuations.swap(counter->continuations_);
+    }
+    for(JobTask& task : continuations)
+        push(std::move(task));
+}
+
+void JobSystem::wait(JobCounter& counter){
+    help_until([&counter](){ return counter.done(); });
+    std::lock_guard<std::mutex> lock(counter.mutex_);
+}
+
+void JobSystem::help_until(const std::function<bool()>& done){
+    const unsigned int index = current_index();
+    while(!done()){
+        JobTask task;
+        if(find_task(index, task)){
+            execute(index, task);
+            continue;
+        }
+        // - 没有可执行的任务: 休眠到有新任务或任一任务结束; 条件与任务无关时以超时兜底
+        std::unique_lock<std::mutex> lock(sleep_mutex_);
+        waiters_++;
+        sleep_cv_.wait_for(lock, std::chrono::milliseconds(1), [this, &done](){
+            return queued_ > 0 || done();
+        });
+        waiters_--;
+    }
+}
+
+void JobSystem::parallel_for(size_t begin, size_t end, size_t grain, const std::function<void(size_t, size_t)>& body,
+                             const char* name){
+    if(begin >= end)
+        return;
+    grain = std::max<size_t>(1, grain);
+    if(end - begin <= grain){
+        body(begin, end);
+        return;
+    }
+    JobCounter counter;
+    // - 第一块留给调用线程, 其余提交; 之后调用线程在 wait 中继续执行剩余的块
+    for(size_t first=begin + grain; first<end; first+=grain){
+        const size_t last = std::min(end, first + grain);
+        run([&body, first, last](){ body(first, last); }, &counter, name);
+    }
+    body(begin, std::min(end, begin + grain));
+    wait(counter);
+}
+
+void JobSystem::worker_loop(unsigned int index){
+    tls_system = this;
+    tls_index = index;
+    while(true){
+        JobTask task;
+        if(find_task(index, task)){
+            execute(index, task);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleep_mutex_);
+        sleep_cv_.wait(lock, [this](){ return stop_ || queued_ > 0; });
+        if(stop_ && queued_ == 0)
+            return;
+    }
+}
+
+std::vector<JobSystem::WorkerStats> JobSystem::stats() const{
+    std::vector<WorkerStats> result(workers_.size());
+    for(size_t i=0; i<workers_.size(); i++){
+        result[i].jobs = workers_[i]->jobs;
+        result[i].busy_ns = workers_[i]->busy_ns;
+        result[i].steals = workers_[i]->steals;
+    }
+    return result;
+}
+
+void JobSystem::reset_stats(){
+    for(std::unique_ptr<Worker>& worker : workers_){
+        worker->jobs = 0;
+        worker->busy_ns = 0;
+        worker->steals = 0;
+    }
+    stats_start_ns_ = now_ns();
+}
+
+void JobSystem::info() const{
+    const double elapsed_ms = (now_ns() - stats_start_ns_) / 1e6;
+    std::cout << "OUT: JobSystem " << worker_count() << " workers, " << elapsed_ms << " ms" << std::endl;
+    const std::vector<WorkerStats> all = stats();
+    for(size_t i=0; i<all.size(); i++){
+        const double busy_ms = all[i].busy_ns / 1e6;
+        std::cout << "    " << (i < worker_count() ? "worker " + std::to_string(i) : std::string("caller"))
+                  << ": jobs " << all[i].jobs << ", busy " << busy_ms << " ms ("
+                  << (elapsed_ms > 0.0 ? busy_ms / elapsed_ms * 100.0 : 0.0) << "%), steals " << all[i].steals << std::endl;
+    }
+}
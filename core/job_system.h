@@ -0,0 +1,142 @@
+#ifndef OPENGL_CORE_JOB_SYSTEM_H_
+#define OPENGL_CORE_JOB_SYSTEM_H_
+
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <functional>
+#include <condition_variable>
+
+using Job = std::function<void()>;
+
+class JobCounter;
+
+struct JobTask{
+    Job job;
+    JobCounter* counter{nullptr};   // 完成时 -1
+    const char* name{"job"};
+};
+
+/**
+ * 一组任务的完成计数: 提交时 +1, 任务结束时 -1, 归零即全部完成
+ * 也是任务依赖的载体, JobSystem::run_after 注册的任务在计数归零时才提交
+ */
+class JobCounter{
+public:
+    JobCounter(){}
+
+    JobCounter(const JobCounter&) = delete;
+    JobCounter& operator=(const JobCounter&) = delete;
+
+    int value() const { return value_.load(std::memory_order_acquire); }
+    bool done() const { return value() == 0; }
+
+private:
+    friend class JobSystem;
+
+    std::atomic<int> value_{0};
+    std::mutex mutex_;
+    std::vector<JobTask> continuations_;
+};
+
+/**
+ * 全引擎共用的 work-stealing 任务系统
+ * - 每个 worker 一个双端队列: 自己从尾部取(LIFO, 缓存友好), 空闲时从其它 worker 头部偷(FIFO)
+ * - 非 worker 线程提交的任务进入共享的注入队列
+ * - wait() / help_until() 在等待期间由当前线程执行任务, 嵌套等待不会占死 worker
+ * - 每个 worker 统计任务数、忙碌时间与偷取次数, trace hook 可接入 profiler 输出时间线
+ */
+class JobSystem{
+public:
+    struct WorkerStats{
+        uint64_t jobs{0};
+        uint64_t busy_ns{0};
+        uint64_t steals{0};
+    };
+
+    // - 参数: 执行线程序号(worker_count() 表示非 worker 线程), 任务名, 起止时间(steady_clock ns)
+    using TraceHook = std::function<void(unsigned int, const char*, uint64_t, uint64_t)>;
+
+    // - 全局实例, worker 数为硬件线程数 - 1 (调用线程在等待时也会执行任务), 至少 1 个
+    //   环境变量 TEST_OPENGL_JOB_WORKERS 可覆盖
+    static JobSystem& instance();
+
+    explicit JobSystem(unsigned int worker_count);
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    void run(Job job, JobCounter* counter = nullptr, const char* name = "job");
+
+    /// @brief dependency 归零后才提交 job; 注册时 counter 即 +1, 等待 counter 也就覆盖了这个延后的任务
+    void run_after(JobCounter& dependency, Job job, JobCounter* counter = nullptr, const char* name = "job");
+
+    // - 等待 counter 归零, 期间当前线程执行任务
+    void wait(JobCounter& counter);
+
+    // - 直到 done() 为真, 期间当前线程执行任务; 用于等待任务之外的条件(例如结果队列非空)
+    void help_until(const std::function<bool()>& done);
+
+    /**
+     * 把 [begin, end) 按 grain 切块并行执行 body(chunk_begin, chunk_end), 返回时全部完成
+     *@ grain: 每块的元素数, 应使单块耗时远大于调度开销(约微秒级)
+    */
+    void parallel_for(size_t begin, size_t end, size_t grain, const std::function<void(size_t, size_t)>& body,
+                      const char* name = "parallel_for");
+
+    unsigned int worker_count() const { return static_cast<unsigned int>(workers_.size() - 1); }
+
+    // - 注意: 需在提交任务之前设置
+    void set_trace_hook(TraceHook hook) { trace_hook_ = std::move(hook); }
+
+    // - 下标 worker_count() 为非 worker 线程在等待时执行的部分
+    std::vector<WorkerStats> stats() const;
+    void reset_stats();
+
+    // - 输出各 worker 的任务数、利用率(忙碌时间 / 统计时长)与偷取次数
+    void info() const;
+
+private:
+    struct Worker{
+        std::mutex mutex;
+        std::deque<JobTask> tasks;
+        std::thread thread;
+        std::atomic<uint64_t> jobs{0};
+        std::atomic<uint64_t> busy_ns{0};
+        std::atomic<uint64_t> steals{0};
+    };
+
+    void worker_loop(unsigned int index);
+
+    void push(JobTask&& task);
+
+    // - index 为当前线程的 worker 序号, 非 worker 线程为 worker_count()
+    bool find_task(unsigned int index, JobTask& task);
+
+    void execute(unsigned int index, JobTask& task);
+
+    void finish(JobCounter* counter);
+
+    unsigned int current_index() const;
+
+private:
+    std::vector<std::unique_ptr<Worker>> workers_;   // 末尾多一个, 统计非 worker 线程
+    std::mutex inject_mutex_;
+    std::deque<JobTask> inject_;
+
+    std::mutex sleep_mutex_;
+    std::condition_variable sleep_cv_;
+    std::atomic<size_t> queued_{0};
+    std::atomic<unsigned int> waiters_{0};    // help_until 中休眠的线程数, 非零时每个任务结束都唤醒
+    std::atomic<bool> stop_{false};
+
+    TraceHook trace_hook_;
+    std::atomic<uint64_t> stats_start_ns_{0};
+};
+
+#endif
@@ -0,0 +1,223 @@
+#include "./profiler.h"
+
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <algorithm>
+
+#include "./job_system.h"
+
+namespace{
+
+thread_local void* tls_buffer = nullptr;
+
+// - zone 名一般是字面量, 仍转义引号与反斜杠保证输出是合法 JSON
+void write_json_string(std::ostream& out, const std::string& text){
+    out << '"';
+    for(const char c : text){
+        if(c == '"' || c == '\\')
+            out << '\\' << c;
+        else if(static_cast<unsigned char>(c) < 0x20)
+            out << ' ';
+        else
+            out << c;
+    }
+    out << '"';
+}
+
+}
+
+Profiler& Profiler::instance(){
+    static Profiler profiler;
+    return profiler;
+}
+
+Profiler::Profiler(): origin_ns_(now_ns()){
+    window_begin_ns_ = origin_ns_;
+}
+
+uint64_t Profiler::now_ns(){
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+Profiler::ThreadBuffer& Profiler::add_buffer_locked(const std::string& name){
+    threads_.emplace_back(new ThreadBuffer());
+    ThreadBuffer& buffer = *threads_.back();
+    buffer.tid = static_cast<unsigned int>(threads_.size());
+    buffer.name = name.empty() ? "thread " + std::to_string(buffer.tid) : name;
+    return buffer;
+}
+
+Profiler::ThreadBuffer& Profiler::register_thread(const std::string& name){
+    std::lock_guard<std::mutex> lock(threads_mutex_);
+    ThreadBuffer& buffer = add_buffer_locked(name);
+    tls_buffer = &buffer;
+    return buffer;
+}
+
+unsigned int Profiler::add_track(const std::string& name){
+    std::lock_guard<std::mutex> lock(threads_mutex_);
+    return add_buffer_locked(name).tid - 1;
+}
+
+Profiler::ThreadBuffer& Profiler::current_buffer(){
+    if(tls_buffer)
+        return *static_cast<ThreadBuffer*>(tls_buffer);
+    return register_thread("");
+}
+
+void Profiler::set_thread_name(const std::string& name){
+    if(!tls_buffer){
+        register_thread(name);
+        return;
+    }
+    std::lock_guard<std::mutex> lock(threads_mutex_);
+    static_cast<ThreadBuffer*>(tls_buffer)->name = name;
+}
+
+void Profiler::record(const char* name, const uint64_t begin_ns, const uint64_t end_ns){
+    if(!enabled())
+        return;
+    push(current_buffer(), name, begin_ns, end_ns);
+}
+
+void Profiler::record_track(const unsigned int track, const char* name, const uint64_t begin_ns, const uint64_t end_ns){
+    if(!enabled())
+        return;
+    ThreadBuffer* buffer = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(threads_mutex_);
+        if(track < threads_.size())
+            buffer = threads_[track].get();
+    }
+    if(buffer)
+        push(*buffer, name, begin_ns, end_ns);
+}
+
+void Profiler::push(ThreadBuffer& buffer, const char* name, const uint64_t begin_ns, const uint64_t end_ns){
+    const size_t head = buffer.head.load(std::memory_order_relaxed);
+    if(head - buffer.tail.load(std::memory_order_acquire) >= kRingCapacity){
+        buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    ProfileEvent& event = buffer.events[head % kRingCapacity];
+    event.name = name;
+    event.begin_ns = begin_ns;
+    event.end_ns = end_ns;
+    buffer.head.store(head + 1, std::memory_order_release);
+}
+
+void Profiler::attach(JobSystem& jobs){
+    const unsigned int worker_count = jobs.worker_count();
+    jobs.set_trace_hook([this, worker_count](unsigned int index, const char* name, uint64_t begin_ns, uint64_t end_ns){
+        // - worker 第一次执行任务时以序号命名, 与 JobSystem::info() 一致
+        if(!tls_buffer && index < worker_count)
+            register_thread("worker " + std::to_string(index));
+        record(name, begin_ns, end_ns);
+    });
+}
+
+void Profiler::collect(){
+    std::lock_guard<std::mutex> lock(collect_mutex_);
+    collect_locked();
+}
+
+void Profiler::collect_locked(){
+    std::vector<ThreadBuffer*> buffers;
+    {
+        std::lock_guard<std::mutex> lock(threads_mutex_);
+        for(std::unique_ptr<ThreadBuffer>& buffer : threads_)
+            buffers.push_back(buffer.get());
+    }
+    for(ThreadBuffer* buffer : buffers){
+        const size_t tail = buffer->tail.load(std::memory_order_relaxed);
+        const size_t head = buffer->head.load(std::memory_order_acquire);
+        for(size_t i=tail; i<head; i++){
+            const ProfileEvent& event = buffer->events[i % kRingCapacity];
+            const uint64_t duration = event.end_ns - event.begin_ns;
+            ZoneStats& stats = window_[event.name];
+            stats.count++;
+            stats.total_ns += duration;
+            stats.min_ns = std::min(stats.min_ns, duration);
+            stats.max_ns = std::max(stats.max_ns, duration);
+            if(trace_.size() < kMaxTraceEvents)
+                trace_.push_back({event, buffer->tid});
+            else
+                trace_dropped_++;
+        }
+        buffer->tail.store(head, std::memory_order_release);
+    }
+}
+
+void Profiler::info(const std::string& title){
+    std::lock_guard<std::mutex> lock(collect_mutex_);
+    collect_locked();
+
+    const uint64_t now = now_ns();
+    uint64_t dropped = 0;
+    {
+        std::lock_guard<std::mutex> lock(threads_mutex_);
+        for(std::unique_ptr<ThreadBuffer>& buffer : threads_)
+            dropped += buffer->dropped.load(std::memory_order_relaxed);
+    }
+    std::cout << "OUT: profiler " << title << ", " << (now - window_begin_ns_) / 1e6 << " ms";
+    if(dropped > 0)
+        std::cout << ", dropped " << dropped << " events (ring full)";
+    std::cout << std::endl;
+
+    // - 按总耗时从大到小
+    std::vector<std::pair<std::string, ZoneStats>> zones(window_.begin(), window_.end());
+    std::sort(zones.begin(), zones.end(), [](const auto& a, const auto& b){ return a.second.total_ns > b.second.total_ns; });
+    for(const auto& zone : zones){
+        const ZoneStats& stats = zone.second;
+        std::cout << "    " << std::left << std::setw(20) << zone.first << std::right
+                  << " count " << std::setw(7) << stats.count
+                  << ", total " << std::setw(9) << stats.total_ns / 1e6 << " ms"
+                  << ", avg " << std::setw(9) << stats.total_ns / 1e3 / stats.count << " us"
+                  << ", min " << std::setw(9) << stats.min_ns / 1e3 << " us"
+                  << ", max " << std::setw(9) << stats.max_ns / 1e3 << " us" << std::endl;
+    }
+    window_.clear();
+    window_begin_ns_ = now;
+}
+
+bool Profiler::write_chrome_trace(const std::string& path){
+    std::lock_guard<std::mutex> lock(collect_mutex_);
+    collect_locked();
+
+    std::ofstream out(path);
+    if(!out){
+        std::cout << "ERROR: write chrome trace fail, path " << path << std::endl;
+        return false;
+    }
+    // - "X" 为带时长的完整事件, 时间单位 us, 相对 profiler 创建时刻
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    bool first = true;
+    {
+        std::lock_guard<std::mutex> lock(threads_mutex_);
+        for(std::unique_ptr<ThreadBuffer>& buffer : threads_){
+            out << (first ? "" : ",\n") << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << buffer->tid
+                << ",\"args\":{\"name\":";
+            write_json_string(out, buffer->name);
+            out << "}}";
+            first = false;
+        }
+    }
+    out << std::fixed << std::setprecision(3);
+    for(const TraceEvent& item : trace_){
+        const uint64_t begin = item.event.begin_ns > origin_ns_ ? item.event.begin_ns - origin_ns_ : 0;
+        out << (first ? "" : ",\n") << "{\"ph\":\"X\",\"pid\":1,\"tid\":" << item.tid << ",\"name\":";
+        write_json_string(out, item.event.name);
+        out << ",\"ts\":" << begin / 1e3 << ",\"dur\":" << (item.event.end_ns - item.event.begin_ns) / 1e3 << "}";
+        first = false;
+    }
+    out << "\n]}" << std::endl;
+
+    std::cout << "OUT: chrome trace " << trace_.size() << " events, path " << path;
+    if(trace_dropped_ > 0)
+        std::cout << ", dropped " << trace_dropped_ << " (limit " << kMaxTraceEvents << ")";
+    std::cout << std::endl;
+    return true;
+}
@@ -0,0 +1,151 @@
+#ifndef OPENGL_CORE_PROFILER_H_
+#define OPENGL_CORE_PROFILER_H_
+
+#include <map>
+#include <mutex>
+#include <array>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+class JobSystem;
+
+struct ProfileEvent{
+    const char* name{nullptr};      // 须为字符串字面量等静态存储, 只记录指针
+    uint64_t begin_ns{0};           // steady_clock, 与 JobSystem trace hook 相同
+    uint64_t end_ns{0};
+};
+
+/**
+ * CPU 分区计时(profiling zone)
+ * - 每个线程一个单生产者 / 单消费者的无锁环形缓冲, 记录一次只有两次原子操作, 满时丢弃并计数
+ * - collect() 取出全部线程的记录, 累计到各区的滚动统计并保留为时间线
+ * - 时间线导出为 Chrome trace JSON(chrome://tracing 或 Perfetto 打开)
+ * 运行时默认关闭, 关闭时一个 zone 只有一次原子读; 编译时定义 DISABLE_PROFILER 则 PROFILE_* 宏为空
+ */
+class Profiler{
+public:
+    static Profiler& instance();
+
+    Profiler(const Profiler&) = delete;
+    Profiler& operator=(const Profiler&) = delete;
+
+    static uint64_t now_ns();
+
+    void set_enabled(const bool enabled) { enabled_.store(enabled, std::memory_order_relaxed); }
+    bool enabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+    // - 时间线中当前线程的名字, 应在线程开始时调用一次
+    void set_thread_name(const std::string& name);
+
+    // - 记录到当前线程的缓冲; 只由 ProfileScope 与 trace hook 调用
+    void record(const char* name, const uint64_t begin_ns, const uint64_t end_ns);
+
+    /**
+     * 不对应线程的时间线轨道, 例如 GPU; 时间需已换算到 steady_clock
+     *@ return: 轨道序号, 传给 record_track; 同一轨道只能由一个线程写入
+    */
+    unsigned int add_track(const std::string& name);
+    void record_track(const unsigned int track, const char* name, const uint64_t begin_ns, const uint64_t end_ns);
+
+    // - 把 JobSystem 执行的每个任务记为以任务名命名的 zone; 需在提交任务之前调用
+    void attach(JobSystem& jobs);
+
+    // - 取出各线程缓冲中的记录; 应定期调用(例如每帧), 否则缓冲写满后丢弃
+    void collect();
+
+    /**
+     * 输出上次 info() 之后各区的次数、平均 / 最小 / 最大耗时, 之后清空这一段的统计
+     *@ title: 输出的标题, 例如 "last 5 s"
+    */
+    void info(const std::string& title);
+
+    /// @brief 先 collect(), 再把保留的时间线写为 Chrome trace JSON
+    bool write_chrome_trace(const std::string& path);
+
+private:
+    Profiler();
+
+    static constexpr size_t kRingCapacity = 1 << 14;
+    static constexpr size_t kMaxTraceEvents = 1 << 20;
+
+    struct ThreadBuffer{
+        unsigned int tid{0};
+        std::string name;
+        std::atomic<size_t> head{0};    // 生产者(所属线程)写
+        std::atomic<size_t> tail{0};    // 消费者(collect)写
+        std::atomic<uint64_t> dropped{0};
+        std::array<ProfileEvent, kRingCapacity> events;
+    };
+
+    struct TraceEvent{
+        ProfileEvent event;
+        unsigned int tid{0};
+    };
+
+    struct ZoneStats{
+        uint64_t count{0};
+        uint64_t total_ns{0};
+        uint64_t min_ns{UINT64_MAX};
+        uint64_t max_ns{0};
+    };
+
+    ThreadBuffer& current_buffer();
+    ThreadBuffer& register_thread(const std::string& name);
+    ThreadBuffer& add_buffer_locked(const std::string& name);
+
+    void push(ThreadBuffer& buffer, const char* name, const uint64_t begin_ns, const uint64_t end_ns);
+
+    void collect_locked();
+
+private:
+    const uint64_t origin_ns_;
+    std::atomic<bool> enabled_{false};
+
+    std::mutex threads_mutex_;
+    std::vector<std::unique_ptr<ThreadBuffer>> threads_;   // 线程与 add_track 的轨道, 下标 + 1 为 tid
+
+    std::mutex collect_mutex_;
+    std::vector<TraceEvent> trace_;
+    uint64_t trace_dropped_{0};
+    std::map<std::string, ZoneStats> window_;
+    uint64_t window_begin_ns_{0};
+};
+
+/**
+ * 作用域内的一个 zone, 析构时记录
+ * 不要跨越 co_await: 协程可能在另一线程恢复, 记录会落到错误的线程
+ */
+class ProfileScope{
+public:
+    explicit ProfileScope(const char* name): name_(name){
+        if(Profiler::instance().enabled())
+            begin_ns_ = Profiler::now_ns();
+    }
+    ~ProfileScope(){
+        if(begin_ns_ != 0)
+            Profiler::instance().record(name_, begin_ns_, Profiler::now_ns());
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    const char* name_;
+    uint64_t begin_ns_{0};
+};
+
+#define PROFILE_CONCAT_IMPL(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_IMPL(a, b)
+
+#ifndef DISABLE_PROFILER
+#define PROFILE_ZONE(name) ProfileScope PROFILE_CONCAT(profile_zone_, __LINE__)(name)
+#define PROFILE_THREAD(name) Profiler::instance().set_thread_name(name)
+#else
+#define PROFILE_ZONE(name) ((void)0)
+#define PROFILE_THREAD(name) ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,94 @@
+#include "./startup_timeline.h"
+
+#include <memory>
+#include <fstream>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+
+#include <json/json.h>
+
+StartupTimeline& StartupTimeline::instance(){
+    static StartupTimeline timeline;
+    return timeline;
+}
+
+StartupTimeline::StartupTimeline(): origin_(std::chrono::steady_clock::now()){
+}
+
+double StartupTimeline::elapsed_ms() const{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - origin_).count();
+}
+
+StartupTimeline::Stage& StartupTimeline::stage_locked(const std::string& name){
+    for(Stage& stage : stages_){
+        if(stage.name == name)
+            return stage;
+    }
+    stages_.push_back(Stage());
+    stages_.back().name = name;
+    return stages_.back();
+}
+
+void StartupTimeline::begin(const std::string& stage){
+    const double now = elapsed_ms();
+    std::lock_guard<std::mutex> lock(mutex_);
+    stage_locked(stage).begin_ms = now;
+}
+
+void StartupTimeline::end(const std::string& stage){
+    const double now = elapsed_ms();
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stage& item = stage_locked(stage);
+    if(item.begin_ms < 0.0)
+        item.begin_ms = now;
+    item.end_ms = now;
+}
+
+void StartupTimeline::first_frame(){
+    const double now = elapsed_ms();
+    std::lock_guard<std::mutex> lock(mutex_);
+    if(reported_)
+        return;
+    reported_ = true;
+
+    std::cout << "OUT: startup time to first frame " << now << " ms" << std::endl;
+    for(const Stage& stage : stages_){
+        std::cout << "    " << std::left << std::setw(16) << stage.name << std::right
+                  << " begin " << std::setw(8) << stage.begin_ms << " ms, end ";
+        if(stage.end_ms < 0.0)
+            std::cout << std::setw(8) << "-" << "    (unfinished)" << std::endl;
+        else
+            std::cout << std::setw(8) << stage.end_ms << " ms, " << stage.end_ms - stage.begin_ms << " ms" << std::endl;
+    }
+
+    const char* report_env = std::getenv("TEST_OPENGL_STARTUP_REPORT");
+    if(report_env && *report_env)
+        write_json(report_env, now);
+}
+
+void StartupTimeline::write_json(const std::string& path, const double first_frame_ms) const{
+    Json::Value root;
+    root["time_to_first_frame_ms"] = first_frame_ms;
+    Json::Value& stages = root["stages"];
+    stages = Json::Value(Json::arrayValue);
+    for(const Stage& stage : stages_){
+        Json::Value item;
+        item["name"] = stage.name;
+        item["begin_ms"] = stage.begin_ms;
+        item["end_ms"] = stage.end_ms;
+        item["duration_ms"] = stage.end_ms < 0.0 ? -1.0 : stage.end_ms - stage.begin_ms;
+        stages.append(item);
+    }
+
+    std::ofstream out(path);
+    if(!out){
+        std::cout << "ERROR: write startup report fail, path " << path << std::endl;
+        return;
+    }
+    Json::StreamWriterBuilder builder;
+    builder["indentation"] = "  ";
+    std::unique_ptr<Json::StreamWriter> writer(builder.newStreamWriter());
+    writer->write(root, &out);
+    out << std::endl;
+}
@@ -0,0 +1,51 @@
+#ifndef OPENGL_CORE_STARTUP_TIMELINE_H_
+#define OPENGL_CORE_STARTUP_TIMELINE_H_
+
+#include <mutex>
+#include <chrono>
+#include <string>
+#include <vector>
+
+/**
+ * 启动阶段计时, 用于冷启动的首帧时间(time to first frame)
+ * - 各阶段可以重叠(窗口创建与模型导入并行), 分别记录相对起点的开始与结束时间
+ * - 起点为第一次调用 instance(), 应在 main 的第一行
+ * - first_frame() 输出一次汇总; 环境变量 TEST_OPENGL_STARTUP_REPORT 指定路径时另写一份 JSON
+ * 可在任意线程调用
+ */
+class StartupTimeline{
+public:
+    static StartupTimeline& instance();
+
+    StartupTimeline(const StartupTimeline&) = delete;
+    StartupTimeline& operator=(const StartupTimeline&) = delete;
+
+    void begin(const std::string& stage);
+    void end(const std::string& stage);
+
+    // - 第一帧已提交(SwapBuffers 返回)时调用
+    void first_frame();
+
+    double elapsed_ms() const;
+
+private:
+    StartupTimeline();
+
+    struct Stage{
+        std::string name;
+        double begin_ms{-1.0};
+        double end_ms{-1.0};
+    };
+
+    Stage& stage_locked(const std::string& name);
+
+    void write_json(const std::string& path, const double first_frame_ms) const;
+
+private:
+    const std::chrono::steady_clock::time_point origin_;
+    mutable std::mutex mutex_;
+    std::vector<Stage> stages_;     // 按第一次 begin 的顺序
+    bool reported_{false};
+};
+
+#endif
@@ -0,0 +1,28 @@
+#include "./task.h"
+
+GlThreadQueue& GlThreadQueue::instance(){
+    static GlThreadQueue queue;
+    return queue;
+}
+
+void GlThreadQueue::push(std::coroutine_handle<> handle){
+    std::lock_guard<std::mutex> lock(mutex_);
+    handles_.push_back(handle);
+}
+
+size_t GlThreadQueue::pump(){
+    std::vector<std::coroutine_handle<>> handles;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        handles.swap(handles_);
+    }
+    // - 恢复的协程可能再次入队, 留到下一次 pump
+    for(std::coroutine_handle<> handle : handles)
+        handle.resume();
+    return handles.size();
+}
+
+bool GlThreadQueue::pending() const{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return !handles_.empty();
+}
@@ -0,0 +1,268 @@
+#ifndef OPENGL_CORE_TASK_H_
+#define OPENGL_CORE_TASK_H_
+
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <utility>
+#include <optional>
+#include <exception>
+#include <coroutine>
+
+#include "./job_system.h"
+
+template<typename T>
+class Task;
+
+namespace task_detail{
+
+struct PromiseBase{
+    std::coroutine_handle<> continuation{std::noop_coroutine()};
+    std::atomic<bool> finished{false};
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+
+    // - 结束时转到等待者; 先取出 continuation 再置 finished, 之后不再访问协程帧
+    struct FinalAwaiter{
+        bool await_ready() noexcept { return false; }
+        template<typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept{
+            std::coroutine_handle<> next = handle.promise().continuation;
+            handle.promise().finished.store(true, std::memory_order_release);
+            return next;
+        }
+        void await_resume() noexcept {}
+    };
+    FinalAwaiter final_suspend() noexcept { return {}; }
+
+    // - 与加载失败时 exit(-1) 的处理一致, 不跨协程传递异常
+    void unhandled_exception() { std::terminate(); }
+};
+
+template<typename T>
+struct Promise : PromiseBase{
+    std::optional<T> value;
+
+    Task<T> get_return_object();
+    template<typename U>
+    void return_value(U&& result) { value.emplace(std::forward<U>(result)); }
+};
+
+template<>
+struct Promise<void> : PromiseBase{
+    Task<void> get_return_object();
+    void return_void() {}
+};
+
+}
+
+/**
+ * 惰性启动的协程任务: 被 co_await 或 start() 时才开始执行, 结束后恢复等待者
+ * - 协程在哪个线程恢复由其中 co_await 的 awaitable 决定(schedule_on_jobs / resume_on_gl_thread)
+ * - 只可移动; 一个任务只能被启动一次
+ */
+template<typename T = void>
+class Task{
+public:
+    using promise_type = task_detail::Promise<T>;
+    using Handle = std::coroutine_handle<promise_type>;
+
+    Task(){}
+    explicit Task(Handle handle): handle_(handle){}
+    ~Task(){
+        if(handle_)
+            handle_.destroy();
+    }
+
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    Task(Task&& other) noexcept: handle_(std::exchange(other.handle_, {})), started_(other.started_){}
+    Task& operator=(Task&& other) noexcept{
+        if(this != &other){
+            if(handle_)
+                handle_.destroy();
+            handle_ = std::exchange(other.handle_, {});
+            started_ = other.started_;
+        }
+        return *this;
+    }
+
+    // - 以"不等待结果"的方式启动, 之后用 done() 轮询或 sync_wait 等待
+    void start(){
+        if(handle_ && !started_){
+            started_ = true;
+            handle_.resume();
+        }
+    }
+
+    bool done() const { return !handle_ || handle_.promise().finished.load(std::memory_order_acquire); }
+
+    // - done() 之后取结果
+    auto result(){
+        if constexpr(!std::is_void_v<T>)
+            return std::move(*handle_.promise().value);
+    }
+
+    // - 只等待完成, 结果留在任务中(when_all 使用)
+    auto when_ready(){
+        struct Awaiter{
+            Task* task;
+            bool await_ready() const { return task->done(); }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting){
+                task->handle_.promise().continuation = awaiting;
+                task->started_ = true;
+                return task->handle_;
+            }
+            void await_resume() {}
+        };
+        return Awaiter{this};
+    }
+
+    auto operator co_await(){
+        struct Awaiter{
+            Task* task;
+            bool await_ready() const { return task->done(); }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting){
+                task->handle_.promise().continuation = awaiting;
+                task->started_ = true;
+                return task->handle_;
+            }
+            auto await_resume() { return task->result(); }
+        };
+        return Awaiter{this};
+    }
+
+private:
+    Handle handle_;
+    bool started_{false};
+};
+
+namespace task_detail{
+
+template<typename T>
+Task<T> Promise<T>::get_return_object(){
+    return Task<T>(std::coroutine_handle<Promise<T>>::from_promise(*this));
+}
+
+inline Task<void> Promise<void>::get_return_object(){
+    return Task<void>(std::coroutine_handle<Promise<void>>::from_promise(*this));
+}
+
+// - 立即执行、结束即销毁的协程, 只用于 when_all 内部
+struct Detached{
+    struct promise_type{
+        Detached get_return_object() { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+struct WhenAllState{
+    std::atomic<size_t> remaining{0};
+    std::coroutine_handle<> awaiting;
+};
+
+template<typename T>
+Detached when_all_item(Task<T>& task, WhenAllState& state){
+    co_await task.when_ready();
+    if(state.remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        state.awaiting.resume();
+}
+
+}
+
+/**
+ * 同时启动一组任务, 全部完成后恢复; 结果用 tasks[i].result() 取
+ * 各任务的 I/O、解码与上传步骤因此在不同资源之间流水重叠
+ */
+template<typename T>
+auto when_all(std::vector<Task<T>>& tasks){
+    struct Awaiter{
+        std::vector<Task<T>>& tasks;
+        task_detail::WhenAllState state;
+
+        bool await_ready() const { return tasks.empty(); }
+        bool await_suspend(std::coroutine_handle<> awaiting){
+            state.awaiting = awaiting;
+            // - 多计一次, 防止启动途中全部完成而提前恢复
+            state.remaining = tasks.size() + 1;
+            for(Task<T>& task : tasks)
+                task_detail::when_all_item(task, state);
+            return state.remaining.fetch_sub(1, std::memory_order_acq_rel) != 1;
+        }
+        void await_resume() {}
+    };
+    return Awaiter{tasks, {}};
+}
+
+// - co_await schedule_on_jobs(): 之后的代码在 JobSystem worker 上执行, 用于读文件、解码等 CPU / 阻塞工作
+inline auto schedule_on_jobs(const char* name = "coroutine"){
+    struct Awaiter{
+        const char* name;
+        bool await_ready() const { return false; }
+        void await_suspend(std::coroutine_handle<> handle){
+            JobSystem::instance().run([handle](){ handle.resume(); }, nullptr, name);
+        }
+        void await_resume() {}
+    };
+    return Awaiter{name};
+}
+
+/**
+ * 持有 GL context 的线程上待恢复的协程
+ * GL 线程调用 bind_current_thread() 后, 每帧(或 sync_wait 中)调用 pump() 恢复它们
+ */
+class GlThreadQueue{
+public:
+    static GlThreadQueue& instance();
+
+    GlThreadQueue(const GlThreadQueue&) = delete;
+    GlThreadQueue& operator=(const GlThreadQueue&) = delete;
+
+    // - 在 context 就绪后调用; 之前 resume_on_gl_thread 的协程都排队等待
+    void bind_current_thread() { gl_thread_ = std::this_thread::get_id(); }
+    bool on_gl_thread() const { return std::this_thread::get_id() == gl_thread_.load(); }
+
+    void push(std::coroutine_handle<> handle);
+
+    // - 恢复当前排队的协程, 返回恢复的个数; 需在 GL 线程调用
+    size_t pump();
+
+    bool pending() const;
+
+private:
+    GlThreadQueue(){}
+
+private:
+    mutable std::mutex mutex_;
+    std::vector<std::coroutine_handle<>> handles_;
+    std::atomic<std::thread::id> gl_thread_;
+};
+
+// - co_await resume_on_gl_thread(): 之后的代码在 GL 线程执行, 用于上传与创建 GL 对象; 已在 GL 线程时不挂起
+inline auto resume_on_gl_thread(){
+    struct Awaiter{
+        bool await_ready() const { return GlThreadQueue::instance().on_gl_thread(); }
+        void await_suspend(std::coroutine_handle<> handle) { GlThreadQueue::instance().push(handle); }
+        void await_resume() {}
+    };
+    return Awaiter{};
+}
+
+// - 在 GL 线程上启动任务并等待完成, 期间恢复 GL 线程上的协程并执行 JobSystem 任务
+template<typename T>
+void sync_wait(Task<T>& task){
+    task.start();
+    GlThreadQueue& gl_queue = GlThreadQueue::instance();
+    while(!task.done()){
+        gl_queue.pump();
+        if(!task.done())
+            JobSystem::instance().help_until([&task, &gl_queue](){ return task.done() || gl_queue.pending(); });
+    }
+}
+
+#endif
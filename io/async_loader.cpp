@@ -0,0 +1,63 @@
+#include "./async_loader.h"
+
+#include <iostream>
+
+#include "./image_decoder.h"
+#include "../texture/texture_manager.h"
+#include "../render/gl_upload_thread.h"
+#include "../core/profiler.h"
+
+Task<MappedFile> read_file_async(std::string path){
+    co_await schedule_on_jobs("read_file");
+    MappedFile file = Vfs::instance().map(path);
+    if(!file.valid())
+        std::cout << "ERROR: read file fail, path " << path << std::endl;
+    co_return std::move(file);
+}
+
+Task<unsigned int> load_texture_async(std::string img_path){
+    MappedFile file = co_await read_file_async(img_path);
+    if(!file.valid())
+        co_return 0;
+
+    // - read_file 在 worker 上恢复, 哈希与解码也留在 worker; 同内容的纹理已存在时跳过解码
+    // - zone 不跨越 co_await, 各自限定在同一线程执行的块内
+    // - file 保留到登记之后, 哈希命中时要逐字节比较
+    uint64_t hash = 0;
+    DecodedImage image;
+    {
+        PROFILE_ZONE("decode_texture");
+        hash = TextureManager::content_hash(file.data(), file.size());
+        if(!TextureManager::instance().contains(hash, file.data(), file.size()))
+            decode_image(file.data(), file.size(), 0, image);
+    }
+
+    // - 有上传线程时在那里上传, fence 完成后才把 id 交给 GL 线程
+    co_await resume_on_upload_thread();
+    unsigned int texture_id = 0;
+    {
+        PROFILE_ZONE("upload_texture");
+        texture_id = TextureManager::instance().acquire_decoded(img_path, hash, file.data(), file.size(), image);
+    }
+    file = MappedFile();
+    co_await publish_to_gl_thread();
+    co_return texture_id;
+}
+
+Task<std::unique_ptr<Shader>> load_shader_async(Shader::PathMap path_map, std::vector<std::string> defines){
+    std::vector<Task<MappedFile>> reads;
+    reads.push_back(read_file_async(path_map.at("vertex")));
+    reads.push_back(read_file_async(path_map.at("frag")));
+    co_await when_all(reads);
+
+    auto source = [&defines](MappedFile file){
+        return Shader::add_defines(std::string(reinterpret_cast<const char*>(file.data()), file.size()), defines);
+    };
+    const std::string vertex_source = source(reads[0].result());
+    const std::string frag_source = source(reads[1].result());
+
+    co_await resume_on_gl_thread();
+    std::unique_ptr<Shader> shader(new Shader());
+    shader->compile(vertex_source, frag_source);
+    co_return shader;
+}
@@ -0,0 +1,28 @@
+#ifndef OPENGL_IO_ASYNC_LOADER_H_
+#define OPENGL_IO_ASYNC_LOADER_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../core/task.h"
+#include "../shader/shader.h"
+#include "./vfs.h"
+
+/**
+ * 协程形式的资源加载, 每一步在合适的线程上执行:
+ * 读文件与解码在 JobSystem worker, 上传与创建 GL 对象在 GL 线程 (GlThreadQueue::pump)
+ * 多个资源用 when_all 同时启动, 各自的 I/O、解码与上传自然流水重叠
+ * 模型见 Model::load_async
+ */
+
+// - 在 worker 上经 Vfs mmap 打开文件, 失败时返回的 MappedFile 无效
+Task<MappedFile> read_file_async(std::string path);
+
+// - 读取、哈希、解码在 worker, 上传在 GlUploadThread (未启动时在 GL 线程), 结果登记到 TextureManager(引用计数 +1), 失败返回 0
+Task<unsigned int> load_texture_async(std::string img_path);
+
+// - 两个源文件并行读取, 编译链接在 GL 线程
+Task<std::unique_ptr<Shader>> load_shader_async(Shader::PathMap path_map, std::vector<std::string> defines = {});
+
+#endif
@@ -0,0 +1,353 @@
+#include "./batch_reader.h"
+
+#include <deque>
+#include <algorithm>
+#include <mutex>
+#include <chrono>
+#include <thread>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+
+#include "./vfs.h"
+#include "../core/job_system.h"
+
+// - 直接使用系统调用, 不依赖 liburing
+struct BatchReader::Ring{
+    int fd{-1};
+    unsigned int entries{0};
+
+    void* sq_ptr{nullptr};
+    size_t sq_size{0};
+    void* cq_ptr{nullptr};
+    size_t cq_size{0};
+    io_uring_sqe* sqes{nullptr};
+    size_t sqes_size{0};
+
+    unsigned* sq_head{nullptr};
+    unsigned* sq_tail{nullptr};
+    unsigned* sq_mask{nullptr};
+    unsigned* sq_array{nullptr};
+    unsigned* cq_head{nullptr};
+    unsigned* cq_tail{nullptr};
+    unsigned* cq_mask{nullptr};
+    io_uring_cqe* cqes{nullptr};
+};
+
+namespace {
+
+int io_uring_setup(unsigned entries, io_uring_params* params){
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int io_uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags){
+    return static_cast<int>(syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+// - 单个文件的读取状态
+struct FileRead{
+    int fd{-1};
+    size_t size{0};
+    size_t offset{0};
+    iovec iov;
+    ReadResult result;
+};
+
+bool open_for_read(const std::string& path, FileRead& read){
+    const std::string real_path = Vfs::instance().resolve(path);
+    read.fd = open(real_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if(read.fd < 0)
+        return false;
+    struct stat file_stat;
+    if(fstat(read.fd, &file_stat) != 0 || !S_ISREG(file_stat.st_mode)){
+        close(read.fd);
+        read.fd = -1;
+        return false;
+    }
+    read.size = file_stat.st_size;
+    read.result.bytes.resize(read.size);
+    return true;
+}
+
+}
+
+BatchReader::BatchReader(const unsigned int queue_depth):
+    queue_depth_(queue_depth){
+    ring_ = create_ring(queue_depth_);
+    if(!ring_)
+        std::cout << "WARN: io_uring unavailable, BatchReader uses job system" << std::endl;
+}
+
+BatchReader::~BatchReader(){
+    destroy_ring(ring_);
+}
+
+BatchReader::Ring* BatchReader::create_ring(const unsigned int queue_depth){
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    int fd = io_uring_setup(queue_depth, &params);
+    if(fd < 0)
+        return nullptr;
+
+    Ring* ring = new Ring();
+    ring->fd = fd;
+    ring->entries = params.sq_entries;
+    ring->sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring->cq_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+    const bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if(single_mmap)
+        ring->sq_size = ring->cq_size = std::max(ring->sq_size, ring->cq_size);
+
+    ring->sq_ptr = mmap(nullptr, ring->sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if(ring->sq_ptr == MAP_FAILED){
+        ring->sq_ptr = nullptr;
+        destroy_ring(ring);
+        return nullptr;
+    }
+    if(single_mmap){
+        ring->cq_ptr = ring->sq_ptr;
+    }else{
+        ring->cq_ptr = mmap(nullptr, ring->cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        if(ring->cq_ptr == MAP_FAILED){
+            ring->cq_ptr = nullptr;
+            destroy_ring(ring);
+            return nullptr;
+        }
+    }
+
+    ring->sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+    void* sqes = mmap(nullptr, ring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if(sqes == MAP_FAILED){
+        destroy_ring(ring);
+        return nullptr;
+    }
+    ring->sqes = static_cast<io_uring_sqe*>(sqes);
+
+    char* sq = static_cast<char*>(ring->sq_ptr);
+    ring->sq_head = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    ring->sq_tail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    ring->sq_mask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    ring->sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+
+    char* cq = static_cast<char*>(ring->cq_ptr);
+    ring->cq_head = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    ring->cq_tail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    ring->cq_mask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    ring->cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+    return ring;
+}
+
+void BatchReader::destroy_ring(Ring* ring){
+    if(!ring)
+        return;
+    if(ring->sqes)
+        munmap(ring->sqes, ring->sqes_size);
+    if(ring->cq_ptr && ring->cq_ptr != ring->sq_ptr)
+        munmap(ring->cq_ptr, ring->cq_size);
+    if(ring->sq_ptr)
+        munmap(ring->sq_ptr, ring->sq_size);
+    if(ring->fd >= 0)
+        close(ring->fd);
+    delete ring;
+}
+
+void BatchReader::read_all(const std::vector<std::string>& paths, const std::function<void(ReadResult&&)>& on_complete){
+    if(ring_)
+        read_all_uring(paths, on_complete);
+    else
+        read_all_jobs(paths, on_complete);
+}
+
+void BatchReader::read_all_uring(const std::vector<std::string>& paths, const std::function<void(ReadResult&&)>& on_complete){
+    std::vector<FileRead> reads(paths.size());
+    std::vector<bool> finished(paths.size(), false);
+    std::deque<size_t> pending;
+
+    auto finish = [&](size_t index, bool ok){
+        FileRead& read = reads[index];
+        if(read.fd >= 0)
+            close(read.fd);
+        read.fd = -1;
+        read.result.ok = ok;
+        if(!ok)
+            read.result.bytes.clear();
+        finished[index] = true;
+        on_complete(std::move(read.result));
+    };
+
+    // - 打开文件并分配目标缓冲, 空文件或打开失败直接完成
+    for(size_t i=0; i<paths.size(); i++){
+        reads[i].result.index = i;
+        reads[i].result.path = paths[i];
+        if(!open_for_read(paths[i], reads[i])){
+            std::cout << "ERROR: BatchReader open fail, path " << paths[i] << std::endl;
+            finish(i, false);
+        }else if(reads[i].size == 0){
+            finish(i, true);
+        }else{
+            pending.push_back(i);
+        }
+    }
+
+    Ring& ring = *ring_;
+    size_t in_flight = 0;
+    // - io_uring_enter 出错后不再提交, 只等已提交的请求完成: 内核可能仍在写 reads 中的缓冲与 iovec
+    bool failed = false;
+    while((!failed && !pending.empty()) || in_flight > 0){
+        // - 填充提交队列; 上次未被内核取走的 SQE 仍在队列中, 一并计入本次提交
+        unsigned tail = *ring.sq_tail;
+        const unsigned head = __atomic_load_n(ring.sq_head, __ATOMIC_ACQUIRE);
+        while(!failed && !pending.empty() && tail - head < ring.entries && in_flight + (tail - head) < queue_depth_){
+            const size_t index = pending.front();
+            pending.pop_front();
+            FileRead& read = reads[index];
+            read.iov.iov_base = read.result.bytes.data() + read.offset;
+            read.iov.iov_len = read.size - read.offset;
+
+            const unsigned slot = tail & *ring.sq_mask;
+            io_uring_sqe* sqe = &ring.sqes[slot];
+            std::memset(sqe, 0, sizeof(*sqe));
+            sqe->opcode = IORING_OP_READV;
+            sqe->fd = read.fd;
+            sqe->addr = reinterpret_cast<unsigned long long>(&read.iov);
+            sqe->len = 1;
+            sqe->off = read.offset;
+            sqe->user_data = index;
+            ring.sq_array[slot] = slot;
+            tail++;
+        }
+        __atomic_store_n(ring.sq_tail, tail, __ATOMIC_RELEASE);
+        const unsigned to_submit = tail - head;
+
+        int ret = io_uring_enter(ring.fd, to_submit, 1, IORING_ENTER_GETEVENTS);
+        if(ret < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY){
+            if(!failed){
+                std::cout << "ERROR: io_uring_enter fail, " << std::strerror(errno) << std::endl;
+                // - 未使用 SQPOLL, 内核只在 io_uring_enter 中读取提交队列, 撤回未取走的 SQE 是安全的
+                __atomic_store_n(ring.sq_tail, __atomic_load_n(ring.sq_head, __ATOMIC_ACQUIRE), __ATOMIC_RELEASE);
+                failed = true;
+            }else{
+                // - 等待也失败时轮询完成队列, 完成事件不需要 io_uring_enter 也会写入
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+        if(ret > 0)
+            in_flight += ret;
+
+        // - 收割完成队列
+        unsigned cq_head = *ring.cq_head;
+        const unsigned cq_tail = __atomic_load_n(ring.cq_tail, __ATOMIC_ACQUIRE);
+        while(cq_head != cq_tail){
+            const io_uring_cqe& cqe = ring.cqes[cq_head & *ring.cq_mask];
+            const size_t index = cqe.user_data;
+            const int res = cqe.res;
+            cq_head++;
+            in_flight--;
+
+            FileRead& read = reads[index];
+            if(res == -EINTR || res == -EAGAIN){
+                pending.push_back(index);
+            }else if(res < 0){
+                std::cout << "ERROR: BatchReader read fail, path " << read.result.path << ", " << std::strerror(-res) << std::endl;
+                finish(index, false);
+            }else if(res == 0){
+                // - 文件在读取中被截断
+                read.result.bytes.resize(read.offset);
+                finish(index, true);
+            }else{
+                read.offset += res;
+                if(read.offset < read.size)
+                    pending.push_back(index);   // 短读, 继续读剩余部分
+                else
+                    finish(index, true);
+            }
+        }
+        __atomic_store_n(ring.cq_head, cq_head, __ATOMIC_RELEASE);
+    }
+
+    // - io_uring_enter 出错时, 所有未完成的请求(含撤回的与读了一部分的)交给任务系统路径重新整读
+    std::vector<std::string> rest;
+    std::vector<size_t> rest_index;
+    for(size_t index=0; index<reads.size(); index++){
+        if(finished[index])
+            continue;
+        close(reads[index].fd);
+        reads[index].fd = -1;
+        rest.push_back(paths[index]);
+        rest_index.push_back(index);
+    }
+    if(!rest.empty()){
+        read_all_jobs(rest, [&](ReadResult&& result){
+            result.index = rest_index[result.index];
+            on_complete(std::move(result));
+        });
+    }
+}
+
+void BatchReader::read_all_jobs(const std::vector<std::string>& paths, const std::function<void(ReadResult&&)>& on_complete){
+    JobSystem& jobs = JobSystem::instance();
+    JobCounter counter;
+    std::mutex mutex;
+    std::deque<ReadResult> done;
+
+    for(size_t i=0; i<paths.size(); i++){
+        jobs.run([&, i](){
+            FileRead read;
+            read.result.index = i;
+            read.result.path = paths[i];
+            bool ok = open_for_read(paths[i], read);
+            while(ok && read.offset < read.size){
+                ssize_t n = pread(read.fd, read.result.bytes.data() + read.offset, read.size - read.offset, read.offset);
+                if(n < 0 && errno == EINTR)
+                    continue;
+                if(n <= 0){
+                    ok = n == 0;
+                    read.result.bytes.resize(read.offset);
+                    break;
+                }
+                read.offset += n;
+            }
+            if(read.fd >= 0)
+                close(read.fd);
+            read.result.ok = ok;
+
+            std::lock_guard<std::mutex> lock(mutex);
+            done.push_back(std::move(read.result));
+        }, &counter, "batch_read");
+    }
+
+    // - 回调留在调用线程, 等待期间调用线程也执行读取任务
+    for(size_t completed = 0; completed < paths.size(); completed++){
+        jobs.help_until([&](){
+            std::lock_guard<std::mutex> lock(mutex);
+            return !done.empty();
+        });
+        std::unique_lock<std::mutex> lock(mutex);
+        ReadResult result = std::move(done.front());
+        done.pop_front();
+        lock.unlock();
+        if(!result.ok)
+            std::cout << "ERROR: BatchReader read fail, path " << result.path << std::endl;
+        on_complete(std::move(result));
+    }
+    // - 最后一个任务可能还未从 push 返回, 它引用着本函数的局部变量
+    jobs.wait(counter);
+}
+
+void BatchReader::drop_cache(const std::string& path){
+    int fd = open(Vfs::instance().resolve(path).c_str(), O_RDONLY | O_CLOEXEC);
+    if(fd < 0)
+        return;
+    fdatasync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+}
@@ -0,0 +1,52 @@
+#ifndef OPENGL_IO_BATCH_READER_H_
+#define OPENGL_IO_BATCH_READER_H_
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+
+struct ReadResult{
+    size_t index{0};                    // 在请求列表中的序号
+    std::string path;
+    std::vector<unsigned char> bytes;
+    bool ok{false};
+};
+
+/**
+ * 批量整文件读取
+ * - Linux io_uring: 一次提交全部读请求, 按完成顺序回调, 冷缓存 / 网络文件系统下 I/O 并发而非串行
+ * - 内核不支持(或被 seccomp 禁用)时退回 JobSystem 任务中 pread
+ * 路径经 Vfs 解析
+ */
+class BatchReader{
+public:
+    explicit BatchReader(const unsigned int queue_depth = 64);
+    ~BatchReader();
+
+    BatchReader(const BatchReader&) = delete;
+    BatchReader& operator=(const BatchReader&) = delete;
+
+    bool uses_io_uring() const { return ring_ != nullptr; }
+
+    /// @brief 读取全部文件, on_complete 在调用线程中按完成顺序执行
+    void read_all(const std::vector<std::string>& paths, const std::function<void(ReadResult&&)>& on_complete);
+
+    // - 丢弃文件的 page cache(只影响干净页), 用于测量冷缓存加载时间
+    static void drop_cache(const std::string& path);
+
+private:
+    struct Ring;
+
+    static Ring* create_ring(const unsigned int queue_depth);
+    static void destroy_ring(Ring* ring);
+
+    void read_all_uring(const std::vector<std::string>& paths, const std::function<void(ReadResult&&)>& on_complete);
+    void read_all_jobs(const std::vector<std::string>& paths, const std::function<void(ReadResult&&)>& on_complete);
+
+private:
+    Ring* ring_{nullptr};
+    unsigned int queue_depth_;
+};
+
+#endif
@@ -0,0 +1,297 @@
+#include "./bundle.h"
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#include <zlib.h>
+#ifdef HAVE_LZ4
+#include <lz4.h>
+#include <lz4hc.h>
+#endif
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+const char* bundle_codec_name(const BundleCodec codec){
+    switch(codec){
+        case BUNDLE_CODEC_NONE:
+            return "none";
+        case BUNDLE_CODEC_LZ4:
+            return "lz4";
+        case BUNDLE_CODEC_ZSTD:
+            return "zstd";
+        case BUNDLE_CODEC_DEFLATE:
+            return "deflate";
+        default:
+            return "unknown";
+    }
+}
+
+bool bundle_codec_from_name(const std::string& name, BundleCodec& codec){
+    const BundleCodec codecs[] = {BUNDLE_CODEC_NONE, BUNDLE_CODEC_LZ4, BUNDLE_CODEC_ZSTD, BUNDLE_CODEC_DEFLATE};
+    for(BundleCodec item : codecs){
+        if(name == bundle_codec_name(item)){
+            codec = item;
+            return bundle_codec_available(item);
+        }
+    }
+    return false;
+}
+
+bool bundle_codec_available(const BundleCodec codec){
+    switch(codec){
+        case BUNDLE_CODEC_NONE:
+        case BUNDLE_CODEC_DEFLATE:
+            return true;
+#ifdef HAVE_LZ4
+        case BUNDLE_CODEC_LZ4:
+            return true;
+#endif
+#ifdef HAVE_ZSTD
+        case BUNDLE_CODEC_ZSTD:
+            return true;
+#endif
+        default:
+            return false;
+    }
+}
+
+BundleCodec bundle_default_codec(){
+#if defined(HAVE_ZSTD)
+    return BUNDLE_CODEC_ZSTD;
+#elif defined(HAVE_LZ4)
+    return BUNDLE_CODEC_LZ4;
+#else
+    return BUNDLE_CODEC_DEFLATE;
+#endif
+}
+
+bool bundle_compress(const BundleCodec codec, const int level, const unsigned char* data, const size_t size,
+                     std::vector<unsigned char>& out){
+    switch(codec){
+        case BUNDLE_CODEC_NONE:
+            out.assign(data, data + size);
+            return true;
+        case BUNDLE_CODEC_DEFLATE:{
+            uLongf packed_size = compressBound(size);
+            out.resize(packed_size);
+            if(compress2(out.data(), &packed_size, data, size, level > 0 ? level : Z_DEFAULT_COMPRESSION) != Z_OK)
+                return false;
+            out.resize(packed_size);
+            return true;
+        }
+#ifdef HAVE_LZ4
+        case BUNDLE_CODEC_LZ4:{
+            if(size > static_cast<size_t>(LZ4_MAX_INPUT_SIZE))
+                return false;
+            out.resize(LZ4_compressBound(static_cast<int>(size)));
+            // - level > 0 时用 HC, 压缩慢但解压速度不变
+            int packed_size = level > 0
+                ? LZ4_compress_HC(reinterpret_cast<const char*>(data), reinterpret_cast<char*>(out.data()),
+                                  static_cast<int>(size), static_cast<int>(out.size()), level)
+                : LZ4_compress_default(reinterpret_cast<const char*>(data), reinterpret_cast<char*>(out.data()),
+                                       static_cast<int>(size), static_cast<int>(out.size()));
+            if(packed_size <= 0)
+                return false;
+            out.resize(packed_size);
+            return true;
+        }
+#endif
+#ifdef HAVE_ZSTD
+        case BUNDLE_CODEC_ZSTD:{
+            out.resize(ZSTD_compressBound(size));
+            size_t packed_size = ZSTD_compress(out.data(), out.size(), data, size, level);  // 0: zstd 默认级别
+            if(ZSTD_isError(packed_size))
+                return false;
+            out.resize(packed_size);
+            return true;
+        }
+#endif
+        default:
+            return false;
+    }
+}
+
+bool bundle_decompress(const BundleCodec codec, const unsigned char* data, const size_t size,
+                       unsigned char* out, const size_t raw_size){
+    switch(codec){
+        case BUNDLE_CODEC_NONE:
+            if(size != raw_size)
+                return false;
+            std::memcpy(out, data, size);
+            return true;
+        case BUNDLE_CODEC_DEFLATE:{
+            uLongf out_size = raw_size;
+            return uncompress(out, &out_size, data, size) == Z_OK && out_size == raw_size;
+        }
+#ifdef HAVE_LZ4
+        case BUNDLE_CODEC_LZ4:
+            return LZ4_decompress_safe(reinterpret_cast<const char*>(data), reinterpret_cast<char*>(out),
+                                       static_cast<int>(size), static_cast<int>(raw_size)) == static_cast<int>(raw_size);
+#endif
+#ifdef HAVE_ZSTD
+        case BUNDLE_CODEC_ZSTD:
+            return ZSTD_decompress(out, raw_size, data, size) == raw_size;
+#endif
+        default:
+            std::cout << "ERROR: bundle codec " << bundle_codec_name(codec) << " not compiled in" << std::endl;
+            return false;
+    }
+}
+
+
+BundleWriter::BundleWriter(const BundleCodec codec, const int level):
+    codec_(codec), level_(level){}
+
+BundleWriter::~BundleWriter(){
+    if(file_)
+        fclose(file_);
+}
+
+bool BundleWriter::open(const std::string& real_path){
+    file_ = fopen(real_path.c_str(), "wb");
+    if(!file_){
+        std::cout << "ERROR: open bundle fail, path " << real_path << std::endl;
+        return false;
+    }
+    // - 先占位, close 时回填
+    BundleHeader header;
+    std::memset(&header, 0, sizeof(header));
+    if(fwrite(&header, sizeof(header), 1, file_) != 1)
+        return false;
+    offset_ = sizeof(header);
+    return true;
+}
+
+bool BundleWriter::add(const std::string& name, const BundleChunkKind kind, const std::vector<unsigned char>& data, const uint64_t hash){
+    if(!file_)
+        return false;
+
+    BundleEntry entry;
+    entry.name = name;
+    entry.kind = kind;
+    entry.codec = codec_;
+    entry.offset = offset_;
+    entry.raw_size = data.size();
+    entry.hash = hash;
+
+    std::vector<unsigned char> packed;
+    if(!bundle_compress(codec_, level_, data.data(), data.size(), packed)){
+        std::cout << "ERROR: bundle compress fail, chunk " << name << std::endl;
+        return false;
+    }
+    const std::vector<unsigned char>* payload = &packed;
+    if(packed.size() >= data.size()){
+        entry.codec = BUNDLE_CODEC_NONE;
+        payload = &data;
+    }
+    entry.packed_size = payload->size();
+
+    if(!payload->empty() && fwrite(payload->data(), 1, payload->size(), file_) != payload->size()){
+        std::cout << "ERROR: write bundle fail, chunk " << name << std::endl;
+        return false;
+    }
+    offset_ += entry.packed_size;
+    raw_bytes_ += entry.raw_size;
+    packed_bytes_ += entry.packed_size;
+    entries_.push_back(entry);
+    return true;
+}
+
+bool BundleWriter::close(){
+    if(!file_)
+        return false;
+
+    bool ok = true;
+    for(const BundleEntry& entry : entries_){
+        BundleEntryRecord record;
+        std::memset(&record, 0, sizeof(record));
+        record.kind = entry.kind;
+        record.codec = entry.codec;
+        record.offset = entry.offset;
+        record.packed_size = entry.packed_size;
+        record.raw_size = entry.raw_size;
+        record.hash = entry.hash;
+        record.name_length = static_cast<uint32_t>(entry.name.size());
+        ok = ok && fwrite(&record, sizeof(record), 1, file_) == 1;
+        ok = ok && fwrite(entry.name.data(), 1, entry.name.size(), file_) == entry.name.size();
+    }
+
+    BundleHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, kBundleMagic, sizeof(header.magic));
+    header.version = kBundleVersion;
+    header.entry_count = static_cast<uint32_t>(entries_.size());
+    header.index_offset = offset_;
+    ok = ok && fseek(file_, 0, SEEK_SET) == 0;
+    ok = ok && fwrite(&header, sizeof(header), 1, file_) == 1;
+    ok = fclose(file_) == 0 && ok;
+    file_ = nullptr;
+    if(!ok)
+        std::cout << "ERROR: write bundle index fail" << std::endl;
+    return ok;
+}
+
+
+bool BundleReader::open(const std::string& path){
+    file_ = Vfs::instance().map(path);
+    entries_.clear();
+    if(!file_.valid() || file_.size() < sizeof(BundleHeader)){
+        std::cout << "ERROR: open bundle fail, path " << path << std::endl;
+        return false;
+    }
+
+    BundleHeader header;
+    std::memcpy(&header, file_.data(), sizeof(header));
+    if(std::memcmp(header.magic, kBundleMagic, sizeof(header.magic)) != 0 || header.version != kBundleVersion){
+        std::cout << "ERROR: not a bundle (or version mismatch), path " << path << std::endl;
+        return false;
+    }
+
+    size_t offset = header.index_offset;
+    for(uint32_t i=0; i<header.entry_count; i++){
+        BundleEntryRecord record;
+        if(offset + sizeof(record) > file_.size())
+            break;
+        std::memcpy(&record, file_.data() + offset, sizeof(record));
+        offset += sizeof(record);
+        if(offset + record.name_length > file_.size() || record.offset + record.packed_size > header.index_offset)
+            break;
+
+        BundleEntry entry;
+        entry.name.assign(reinterpret_cast<const char*>(file_.data() + offset), record.name_length);
+        offset += record.name_length;
+        entry.kind = static_cast<BundleChunkKind>(record.kind);
+        entry.codec = static_cast<BundleCodec>(record.codec);
+        entry.offset = record.offset;
+        entry.packed_size = record.packed_size;
+        entry.raw_size = record.raw_size;
+        entry.hash = record.hash;
+        entries_.push_back(entry);
+    }
+    if(entries_.size() != header.entry_count){
+        std::cout << "ERROR: bundle index corrupt, path " << path << std::endl;
+        entries_.clear();
+        return false;
+    }
+    return true;
+}
+
+const BundleEntry* BundleReader::find(const std::string& name) const{
+    for(const BundleEntry& entry : entries_){
+        if(entry.name == name)
+            return &entry;
+    }
+    return nullptr;
+}
+
+bool BundleReader::read(const BundleEntry& entry, std::vector<unsigned char>& out) const{
+    out.resize(entry.raw_size);
+    if(!bundle_decompress(entry.codec, file_.data() + entry.offset, entry.packed_size, out.data(), out.size())){
+        std::cout << "ERROR: bundle decompress fail, chunk " << entry.name << std::endl;
+        out.clear();
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,137 @@
+#ifndef OPENGL_IO_BUNDLE_H_
+#define OPENGL_IO_BUNDLE_H_
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "./vfs.h"
+
+/**
+ * 资源包格式(小端)
+ *   BundleHeader
+ *   chunk 数据 ...           每块独立压缩, 可并行解压
+ *   index                    entry_count 个 { BundleEntryRecord, name }
+ * index 放在文件尾, 打包时可流式写入 chunk
+ */
+const char kBundleMagic[4] = {'T', 'O', 'G', 'B'};
+const uint32_t kBundleVersion = 1;
+
+enum BundleCodec : uint32_t{
+    BUNDLE_CODEC_NONE = 0,
+    BUNDLE_CODEC_LZ4 = 1,
+    BUNDLE_CODEC_ZSTD = 2,
+    BUNDLE_CODEC_DEFLATE = 3
+};
+
+enum BundleChunkKind : uint32_t{
+    BUNDLE_CHUNK_MODEL = 0,     // 模型清单
+    BUNDLE_CHUNK_MESH = 1,      // 预处理好的顶点 / 索引
+    BUNDLE_CHUNK_TEXTURE = 2    // 预生成的完整 mip 链
+};
+
+struct BundleHeader{
+    char magic[4];
+    uint32_t version;
+    uint32_t entry_count;
+    uint32_t reserved;
+    uint64_t index_offset;
+};
+
+struct BundleEntryRecord{
+    uint32_t kind;
+    uint32_t codec;
+    uint64_t offset;
+    uint64_t packed_size;
+    uint64_t raw_size;
+    uint64_t hash;          // 源文件内容哈希, 纹理按此与散文件加载的纹理去重
+    uint32_t name_length;
+    uint32_t reserved;
+};
+
+struct BundleEntry{
+    std::string name;
+    BundleChunkKind kind;
+    BundleCodec codec;
+    uint64_t offset;
+    uint64_t packed_size;
+    uint64_t raw_size;
+    uint64_t hash;
+};
+
+// - 纹理块开头, 后接 levels 层紧密排列的像素
+struct BundleTextureHeader{
+    uint32_t width;
+    uint32_t height;
+    uint32_t channels;
+    uint32_t levels;
+};
+
+const char* bundle_codec_name(const BundleCodec codec);
+
+// - 按名字解析, 编译时不可用的编码返回 false
+bool bundle_codec_from_name(const std::string& name, BundleCodec& codec);
+
+bool bundle_codec_available(const BundleCodec codec);
+
+// - 可用编码中压缩率与解压速度综合最好的
+BundleCodec bundle_default_codec();
+
+bool bundle_compress(const BundleCodec codec, const int level, const unsigned char* data, const size_t size,
+                     std::vector<unsigned char>& out);
+
+bool bundle_decompress(const BundleCodec codec, const unsigned char* data, const size_t size,
+                       unsigned char* out, const size_t raw_size);
+
+
+class BundleWriter{
+public:
+    BundleWriter(const BundleCodec codec, const int level = 0);
+    ~BundleWriter();
+
+    BundleWriter(const BundleWriter&) = delete;
+    BundleWriter& operator=(const BundleWriter&) = delete;
+
+    bool open(const std::string& real_path);
+
+    // - 压缩后立即写出, 压缩后不变小的块原样存储
+    bool add(const std::string& name, const BundleChunkKind kind, const std::vector<unsigned char>& data, const uint64_t hash = 0);
+
+    // - 写 index 并回填文件头
+    bool close();
+
+    uint64_t raw_bytes() const { return raw_bytes_; }
+    uint64_t packed_bytes() const { return packed_bytes_; }
+
+private:
+    FILE* file_{nullptr};
+    BundleCodec codec_;
+    int level_;
+    std::vector<BundleEntry> entries_;
+    uint64_t offset_{0};
+    uint64_t raw_bytes_{0};
+    uint64_t packed_bytes_{0};
+};
+
+
+/**
+ * 只读资源包, 整个文件 mmap
+ * read 只读映射内存, 可在多个线程同时调用
+ */
+class BundleReader{
+public:
+    bool open(const std::string& path);
+
+    const std::vector<BundleEntry>& entries() const { return entries_; }
+
+    const BundleEntry* find(const std::string& name) const;
+
+    bool read(const BundleEntry& entry, std::vector<unsigned char>& out) const;
+
+private:
+    MappedFile file_;
+    std::vector<BundleEntry> entries_;
+};
+
+#endif
@@ -0,0 +1,509 @@
+#include "./gltf.h"
+
+#include <cmath>
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <iostream>
+
+#include <json/json.h>
+
+namespace {
+
+const uint32_t kGlbMagic = 0x46546C67;       // "glTF"
+const uint32_t kGlbChunkJson = 0x4E4F534A;   // "JSON"
+const uint32_t kGlbChunkBin = 0x004E4942;    // "BIN\0"
+
+int type_components(const std::string& type){
+    if(type == "SCALAR") return 1;
+    if(type == "VEC2") return 2;
+    if(type == "VEC3") return 3;
+    if(type == "VEC4") return 4;
+    if(type == "MAT2") return 4;
+    if(type == "MAT3") return 9;
+    if(type == "MAT4") return 16;
+    return 0;
+}
+
+// - 读一个索引元素, 分量类型不是无符号整数时返回 false
+bool read_index(const unsigned char* element, const int component_type, unsigned int& out){
+    if(component_type == kGltfUnsignedByte){
+        out = element[0];
+    }else if(component_type == kGltfUnsignedShort){
+        uint16_t v;
+        std::memcpy(&v, element, 2);
+        out = v;
+    }else if(component_type == kGltfUnsignedInt){
+        uint32_t v;
+        std::memcpy(&v, element, 4);
+        out = v;
+    }else{
+        return false;
+    }
+    return true;
+}
+
+bool decode_base64(const std::string& text, std::vector<unsigned char>& out){
+    auto value_of = [](char c) -> int{
+        if(c >= 'A' && c <= 'Z') return c - 'A';
+        if(c >= 'a' && c <= 'z') return c - 'a' + 26;
+        if(c >= '0' && c <= '9') return c - '0' + 52;
+        if(c == '+') return 62;
+        if(c == '/') return 63;
+        return -1;
+    };
+    out.clear();
+    out.reserve(text.size() / 4 * 3);
+    unsigned int bits = 0;
+    int bit_count = 0;
+    for(char c : text){
+        if(c == '=')
+            break;
+        int value = value_of(c);
+        if(value < 0)
+            return false;
+        bits = (bits << 6) | value;
+        bit_count += 6;
+        if(bit_count >= 8){
+            bit_count -= 8;
+            out.push_back(static_cast<unsigned char>(bits >> bit_count));
+        }
+    }
+    return true;
+}
+
+// - "data:[<mime>];base64,<data>", buffer 与 image 共用
+bool decode_data_uri(const std::string& uri, std::vector<unsigned char>& out){
+    const size_t comma = uri.find(',');
+    return comma != std::string::npos && decode_base64(uri.substr(comma + 1), out);
+}
+
+bool is_data_uri(const std::string& uri){
+    return uri.compare(0, 5, "data:") == 0;
+}
+
+// - T * R * S, 列主序
+void compose_trs(const float t[3], const float q[4], const float s[3], float m[16]){
+    const float x = q[0], y = q[1], z = q[2], w = q[3];
+    const float r[9] = {1 - 2 * (y * y + z * z), 2 * (x * y + z * w),     2 * (x * z - y * w),
+                        2 * (x * y - z * w),     1 - 2 * (x * x + z * z), 2 * (y * z + x * w),
+                        2 * (x * z + y * w),     2 * (y * z - x * w),     1 - 2 * (x * x + y * y)};
+    for(int col=0; col<3; col++){
+        for(int row=0; row<3; row++)
+            m[col * 4 + row] = r[col * 3 + row] * s[col];
+        m[col * 4 + 3] = 0.0f;
+    }
+    m[12] = t[0];
+    m[13] = t[1];
+    m[14] = t[2];
+    m[15] = 1.0f;
+}
+
+}
+
+std::vector<GltfMeshInstance> GltfAsset::mesh_instances() const{
+    std::vector<GltfMeshInstance> instances;
+    struct Item{
+        int node;
+        std::array<float, 16> parent;
+        size_t depth;
+    };
+    std::array<float, 16> identity{};
+    identity[0] = identity[5] = identity[10] = identity[15] = 1.0f;
+
+    std::vector<Item> stack;
+    for(auto it = scene_roots_.rbegin(); it != scene_roots_.rend(); ++it)
+        stack.push_back({*it, identity, 0});
+    while(!stack.empty()){
+        Item item = stack.back();
+        stack.pop_back();
+        // - 深度超过节点数说明有环
+        if(item.node < 0 || item.node >= static_cast<int>(nodes_.size()) || item.depth > nodes_.size())
+            continue;
+        const GltfNode& node = nodes_[item.node];
+        std::array<float, 16> world;
+        for(int col=0; col<4; col++){
+            for(int row=0; row<4; row++){
+                float sum = 0.0f;
+                for(int k=0; k<4; k++)
+                    sum += item.parent[k * 4 + row] * node.matrix[col * 4 + k];
+                world[col * 4 + row] = sum;
+            }
+        }
+        if(node.mesh >= 0 && node.mesh < static_cast<int>(meshes_.size()))
+            instances.push_back({node.mesh, world});
+        for(auto it = node.children.rbegin(); it != node.children.rend(); ++it)
+            stack.push_back({*it, world, item.depth + 1});
+    }
+    return instances;
+}
+
+bool GltfAsset::is_identity(const std::array<float, 16>& matrix){
+    for(int i=0; i<16; i++){
+        if(std::fabs(matrix[i] - (i % 5 == 0 ? 1.0f : 0.0f)) > 1e-6f)
+            return false;
+    }
+    return true;
+}
+
+size_t GltfAsset::component_size(const int component_type){
+    switch(component_type){
+        case kGltfByte:
+        case kGltfUnsignedByte:
+            return 1;
+        case kGltfShort:
+        case kGltfUnsignedShort:
+            return 2;
+        case kGltfUnsignedInt:
+        case kGltfFloat:
+            return 4;
+        default:
+            return 0;
+    }
+}
+
+bool GltfAsset::load(const std::string& path){
+    path_ = path;
+    directory_ = path.substr(0, path.find_last_of("/"));
+    file_ = Vfs::instance().map(path);
+    if(!file_.valid() || file_.size() < 12){
+        std::cout << "ERROR: open glTF fail, path " << path << std::endl;
+        return false;
+    }
+
+    const unsigned char* data = file_.data();
+    uint32_t magic;
+    std::memcpy(&magic, data, sizeof(magic));
+    if(magic != kGlbMagic){
+        // - .gltf 文本
+        const char* text = reinterpret_cast<const char*>(data);
+        return parse_json(text, text + file_.size(), nullptr, 0);
+    }
+
+    // - GLB: 12 字节头, 之后依次是 JSON chunk 与可选的 BIN chunk
+    uint32_t header[3];
+    std::memcpy(header, data, sizeof(header));
+    if(header[1] != 2 || header[2] > file_.size()){
+        std::cout << "ERROR: unsupported GLB, path " << path << std::endl;
+        return false;
+    }
+    const char* json_begin = nullptr;
+    size_t json_size = 0;
+    const unsigned char* bin = nullptr;
+    size_t bin_size = 0;
+    size_t offset = 12;
+    while(offset + 8 <= header[2]){
+        uint32_t chunk[2];
+        std::memcpy(chunk, data + offset, sizeof(chunk));
+        offset += 8;
+        if(offset + chunk[0] > header[2])
+            break;
+        if(chunk[1] == kGlbChunkJson && !json_begin){
+            json_begin = reinterpret_cast<const char*>(data + offset);
+            json_size = chunk[0];
+        }else if(chunk[1] == kGlbChunkBin && !bin){
+            bin = data + offset;
+            bin_size = chunk[0];
+        }
+        offset += (chunk[0] + 3) & ~3u;
+    }
+    if(!json_begin){
+        std::cout << "ERROR: GLB without JSON chunk, path " << path << std::endl;
+        return false;
+    }
+    return parse_json(json_begin, json_begin + json_size, bin, bin_size);
+}
+
+bool GltfAsset::parse_json(const char* begin, const char* end, const unsigned char* bin, const size_t bin_size){
+    Json::Value root;
+    std::string errors;
+    Json::CharReaderBuilder builder;
+    std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+    if(!reader->parse(begin, end, &root, &errors)){
+        std::cout << "ERROR: parse glTF json fail, " << errors << std::endl;
+        return false;
+    }
+    if(root["asset"]["version"].asString().compare(0, 1, "2") != 0){
+        std::cout << "ERROR: only glTF 2.0 is supported, path " << path_ << std::endl;
+        return false;
+    }
+
+    for(const Json::Value& item : root["buffers"]){
+        Buffer buffer;
+        const std::string uri = item["uri"].asString();
+        if(uri.empty()){
+            // - GLB 内嵌
+            buffer.data = bin;
+            buffer.size = bin_size;
+        }else if(is_data_uri(uri)){
+            if(!decode_data_uri(uri, buffer.owned)){
+                std::cout << "ERROR: bad data uri in glTF buffer" << std::endl;
+                return false;
+            }
+            buffer.data = buffer.owned.data();
+            buffer.size = buffer.owned.size();
+        }else{
+            buffer.file = Vfs::instance().map(directory_ + "/" + uri);
+            if(!buffer.file.valid()){
+                std::cout << "ERROR: open glTF buffer fail, " << uri << std::endl;
+                return false;
+            }
+            buffer.data = buffer.file.data();
+            buffer.size = buffer.file.size();
+        }
+        if(buffer.size < item["byteLength"].asUInt64()){
+            std::cout << "ERROR: glTF buffer shorter than byteLength" << std::endl;
+            return false;
+        }
+        buffers_.push_back(std::move(buffer));
+    }
+
+    for(const Json::Value& item : root["bufferViews"]){
+        GltfBufferView view;
+        view.buffer = item["buffer"].asInt();
+        view.byte_offset = item["byteOffset"].asUInt64();
+        view.byte_length = item["byteLength"].asUInt64();
+        view.byte_stride = item["byteStride"].asUInt64();
+        if(view.buffer < 0 || view.buffer >= static_cast<int>(buffers_.size())
+           || view.byte_offset + view.byte_length > buffers_[view.buffer].size){
+            std::cout << "ERROR: glTF bufferView out of range" << std::endl;
+            return false;
+        }
+        views_.push_back(view);
+    }
+
+    for(const Json::Value& item : root["accessors"]){
+        GltfAccessor accessor;
+        accessor.buffer_view = item.get("bufferView", -1).asInt();
+        accessor.byte_offset = item["byteOffset"].asUInt64();
+        accessor.component_type = item["componentType"].asInt();
+        accessor.normalized = item["normalized"].asBool();
+        accessor.count = item["count"].asUInt64();
+        accessor.components = type_components(item["type"].asString());
+        accessor.sparse = item.isMember("sparse");
+        if(accessor.buffer_view >= static_cast<int>(views_.size()) || component_size(accessor.component_type) == 0
+           || accessor.components == 0){
+            std::cout << "ERROR: bad glTF accessor" << std::endl;
+            return false;
+        }
+        // - 最后一个元素须落在 bufferView 内
+        if(accessor.buffer_view >= 0 && accessor.count > 0){
+            const GltfBufferView& view = views_[accessor.buffer_view];
+            const size_t element = component_size(accessor.component_type) * accessor.components;
+            const size_t last = accessor.byte_offset + (accessor.count - 1) * accessor_stride(accessor) + element;
+            if(last > view.byte_length){
+                std::cout << "ERROR: glTF accessor out of range" << std::endl;
+                return false;
+            }
+        }
+        accessors_.push_back(accessor);
+    }
+
+    for(const Json::Value& item : root["meshes"]){
+        GltfMesh mesh;
+        mesh.name = item["name"].asString();
+        for(const Json::Value& prim : item["primitives"]){
+            GltfPrimitive primitive;
+            for(const std::string& name : prim["attributes"].getMemberNames())
+                primitive.attributes[name] = prim["attributes"][name].asInt();
+            primitive.indices = prim.get("indices", -1).asInt();
+            primitive.material = prim.get("material", -1).asInt();
+            primitive.mode = prim.get("mode", kGltfTriangles).asInt();
+            mesh.primitives.push_back(primitive);
+        }
+        meshes_.push_back(mesh);
+    }
+
+    for(const Json::Value& item : root["materials"]){
+        GltfMaterial material;
+        material.base_color_texture = item["pbrMetallicRoughness"]["baseColorTexture"].get("index", -1).asInt();
+        material.normal_texture = item["normalTexture"].get("index", -1).asInt();
+        material.specular_texture = item["extensions"]["KHR_materials_specular"]["specularTexture"].get("index", -1).asInt();
+        materials_.push_back(material);
+    }
+
+    for(const Json::Value& item : root["textures"])
+        texture_sources_.push_back(item.get("source", -1).asInt());
+
+    for(const Json::Value& item : root["images"]){
+        GltfImage image;
+        image.uri = item["uri"].asString();
+        image.buffer_view = item.get("bufferView", -1).asInt();
+        if(is_data_uri(image.uri)){
+            // - 与 bufferView 图片一样按内嵌数据处理
+            if(!decode_data_uri(image.uri, image.data))
+                std::cout << "ERROR: bad data uri in glTF image " << images_.size() << std::endl;
+            image.uri.clear();
+        }
+        images_.push_back(image);
+    }
+
+    for(const Json::Value& item : root["nodes"]){
+        GltfNode node;
+        node.mesh = item.get("mesh", -1).asInt();
+        for(const Json::Value& child : item["children"])
+            node.children.push_back(child.asInt());
+        if(item.isMember("matrix") && item["matrix"].size() == 16){
+            for(int i=0; i<16; i++)
+                node.matrix[i] = item["matrix"][i].asFloat();
+        }else{
+            float t[3] = {0.0f, 0.0f, 0.0f}, r[4] = {0.0f, 0.0f, 0.0f, 1.0f}, s[3] = {1.0f, 1.0f, 1.0f};
+            for(int i=0; i<3 && i<static_cast<int>(item["translation"].size()); i++)
+                t[i] = item["translation"][i].asFloat();
+            for(int i=0; i<4 && i<static_cast<int>(item["rotation"].size()); i++)
+                r[i] = item["rotation"][i].asFloat();
+            for(int i=0; i<3 && i<static_cast<int>(item["scale"].size()); i++)
+                s[i] = item["scale"][i].asFloat();
+            compose_trs(t, r, s, node.matrix);
+        }
+        nodes_.push_back(node);
+    }
+
+    // - 默认场景的根节点; 没有 scenes 时取所有不是子节点的节点
+    const Json::Value& scenes = root["scenes"];
+    if(scenes.size() > 0){
+        // - scene 越界(含负数)时取第 0 个场景
+        int scene_index = root.get("scene", 0).asInt();
+        if(scene_index < 0 || scene_index >= static_cast<int>(scenes.size())){
+            std::cout << "WARN: glTF scene " << scene_index << " out of range, use scene 0" << std::endl;
+            scene_index = 0;
+        }
+        const Json::Value& scene = scenes[scene_index];
+        for(const Json::Value& node : scene["nodes"])
+            scene_roots_.push_back(node.asInt());
+    }else{
+        std::vector<bool> is_child(nodes_.size(), false);
+        for(const GltfNode& node : nodes_){
+            for(int child : node.children){
+                if(child >= 0 && child < static_cast<int>(nodes_.size()))
+                    is_child[child] = true;
+            }
+        }
+        for(size_t i=0; i<nodes_.size(); i++){
+            if(!is_child[i])
+                scene_roots_.push_back(static_cast<int>(i));
+        }
+    }
+    return true;
+}
+
+const unsigned char* GltfAsset::view_data(const int view) const{
+    if(view < 0 || view >= static_cast<int>(views_.size()))
+        return nullptr;
+    const GltfBufferView& buffer_view = views_[view];
+    return buffers_[buffer_view.buffer].data + buffer_view.byte_offset;
+}
+
+const unsigned char* GltfAsset::image_data(const int image, size_t& size) const{
+    size = 0;
+    if(image < 0 || image >= static_cast<int>(images_.size()))
+        return nullptr;
+    const GltfImage& item = images_[image];
+    if(!item.data.empty()){
+        size = item.data.size();
+        return item.data.data();
+    }
+    const unsigned char* data = view_data(item.buffer_view);
+    if(data)
+        size = views_[item.buffer_view].byte_length;
+    return data;
+}
+
+const unsigned char* GltfAsset::accessor_data(const GltfAccessor& accessor) const{
+    const unsigned char* data = view_data(accessor.buffer_view);
+    return data ? data + accessor.byte_offset : nullptr;
+}
+
+size_t GltfAsset::accessor_stride(const GltfAccessor& accessor) const{
+    if(accessor.buffer_view >= 0 && views_[accessor.buffer_view].byte_stride > 0)
+        return views_[accessor.buffer_view].byte_stride;
+    return component_size(accessor.component_type) * accessor.components;
+}
+
+bool GltfAsset::read_floats(const int index, std::vector<float>& out) const{
+    if(index < 0 || index >= static_cast<int>(accessors_.size()))
+        return false;
+    const GltfAccessor& accessor = accessors_[index];
+    const unsigned char* data = accessor_data(accessor);
+    if(accessor.sparse || !data)
+        return false;
+
+    const size_t stride = accessor_stride(accessor);
+    out.resize(accessor.count * accessor.components);
+    for(size_t i=0; i<accessor.count; i++){
+        const unsigned char* element = data + i * stride;
+        for(int c=0; c<accessor.components; c++){
+            float value = 0.0f;
+            switch(accessor.component_type){
+                case kGltfFloat:{
+                    std::memcpy(&value, element + c * 4, 4);
+                    break;
+                }
+                case kGltfUnsignedByte:
+                    value = element[c];
+                    if(accessor.normalized) value /= 255.0f;
+                    break;
+                case kGltfByte:
+                    value = static_cast<signed char>(element[c]);
+                    if(accessor.normalized) value = std::max(value / 127.0f, -1.0f);
+                    break;
+                case kGltfUnsignedShort:{
+                    uint16_t v;
+                    std::memcpy(&v, element + c * 2, 2);
+                    value = accessor.normalized ? v / 65535.0f : v;
+                    break;
+                }
+                case kGltfShort:{
+                    int16_t v;
+                    std::memcpy(&v, element + c * 2, 2);
+                    value = accessor.normalized ? std::max(v / 32767.0f, -1.0f) : v;
+                    break;
+                }
+                case kGltfUnsignedInt:{
+                    uint32_t v;
+                    std::memcpy(&v, element + c * 4, 4);
+                    value = static_cast<float>(v);
+                    break;
+                }
+            }
+            out[i * accessor.components + c] = value;
+        }
+    }
+    return true;
+}
+
+bool GltfAsset::read_indices(const int index, std::vector<unsigned int>& out) const{
+    if(index < 0 || index >= static_cast<int>(accessors_.size()))
+        return false;
+    const GltfAccessor& accessor = accessors_[index];
+    const unsigned char* data = accessor_data(accessor);
+    if(accessor.sparse || !data || accessor.components != 1)
+        return false;
+
+    const size_t stride = accessor_stride(accessor);
+    out.resize(accessor.count);
+    for(size_t i=0; i<accessor.count; i++){
+        if(!read_index(data + i * stride, accessor.component_type, out[i]))
+            return false;
+    }
+    return true;
+}
+
+bool GltfAsset::max_index(const int index, unsigned int& max) const{
+    max = 0;
+    if(index < 0 || index >= static_cast<int>(accessors_.size()))
+        return false;
+    const GltfAccessor& accessor = accessors_[index];
+    const unsigned char* data = accessor_data(accessor);
+    if(accessor.sparse || !data || accessor.components != 1)
+        return false;
+
+    const size_t stride = accessor_stride(accessor);
+    for(size_t i=0; i<accessor.count; i++){
+        unsigned int value = 0;
+        if(!read_index(data + i * stride, accessor.component_type, value))
+            return false;
+        max = std::max(max, value);
+    }
+    return true;
+}
@@ -0,0 +1,134 @@
+#ifndef OPENGL_IO_GLTF_H_
+#define OPENGL_IO_GLTF_H_
+
+#include <map>
+#include <array>
+#include <string>
+#include <vector>
+
+#include "./vfs.h"
+
+// - glTF 常量
+const int kGltfByte = 5120;
+const int kGltfUnsignedByte = 5121;
+const int kGltfShort = 5122;
+const int kGltfUnsignedShort = 5123;
+const int kGltfUnsignedInt = 5125;
+const int kGltfFloat = 5126;
+const int kGltfTriangles = 4;
+
+struct GltfBufferView{
+    int buffer{-1};
+    size_t byte_offset{0};
+    size_t byte_length{0};
+    size_t byte_stride{0};     // 0 表示紧密排列
+};
+
+struct GltfAccessor{
+    int buffer_view{-1};
+    size_t byte_offset{0};
+    int component_type{kGltfFloat};
+    bool normalized{false};
+    size_t count{0};
+    int components{1};         // SCALAR 1, VEC2 2, VEC3 3, VEC4 4, MAT4 16
+    bool sparse{false};
+};
+
+struct GltfPrimitive{
+    std::map<std::string, int> attributes;   // POSITION / NORMAL / TEXCOORD_0 ... -> accessor
+    int indices{-1};
+    int material{-1};
+    int mode{kGltfTriangles};
+};
+
+struct GltfMesh{
+    std::string name;
+    std::vector<GltfPrimitive> primitives;
+};
+
+// - 只取 Phong shader 能用上的贴图, 值为 texture 序号
+struct GltfMaterial{
+    int base_color_texture{-1};
+    int normal_texture{-1};
+    int specular_texture{-1};  // KHR_materials_specular
+};
+
+struct GltfImage{
+    std::string uri;                    // 外部文件; data URI 解码到 data 后置空
+    int buffer_view{-1};
+    std::vector<unsigned char> data;
+};
+
+// - 场景中的一次 mesh 引用及其世界矩阵(列主序)
+struct GltfMeshInstance{
+    int mesh{-1};
+    std::array<float, 16> matrix;
+};
+
+struct GltfNode{
+    int mesh{-1};
+    std::vector<int> children;
+    float matrix[16];          // 列主序, TRS 已合成
+};
+
+/**
+ * glTF 2.0 / GLB 解析
+ * - GLB 的 BIN chunk 与外部 .bin 都经 Vfs mmap, 不拷贝; 只有 data URI(buffer 与 image)会解码到内存
+ * - 只解析场景结构与访问器, 不涉及 GL, 上传由 Model 负责
+ */
+class GltfAsset{
+public:
+    bool load(const std::string& path);
+
+    // - bufferView 起始地址, 失败返回 nullptr
+    const unsigned char* view_data(const int view) const;
+
+    // - 内嵌图片(bufferView 或 data URI)的编码数据, 外部文件图片返回 nullptr
+    const unsigned char* image_data(const int image, size_t& size) const;
+
+    // - 访问器第一个元素的地址与元素间距
+    const unsigned char* accessor_data(const GltfAccessor& accessor) const;
+    size_t accessor_stride(const GltfAccessor& accessor) const;
+
+    // - 任意分量类型读为 float(按 normalized 归一化), 稀疏访问器不支持
+    bool read_floats(const int accessor, std::vector<float>& out) const;
+    bool read_indices(const int accessor, std::vector<unsigned int>& out) const;
+
+    // - 原地扫描索引访问器的最大值, 不拷贝; 不是合法的索引访问器时返回 false
+    bool max_index(const int accessor, unsigned int& max) const;
+
+    // - 从默认场景根节点遍历, 累乘节点矩阵
+    std::vector<GltfMeshInstance> mesh_instances() const;
+
+    static size_t component_size(const int component_type);
+
+    static bool is_identity(const std::array<float, 16>& matrix);
+
+public:
+    std::string path_;
+    std::string directory_;
+    std::vector<GltfBufferView> views_;
+    std::vector<GltfAccessor> accessors_;
+    std::vector<GltfMesh> meshes_;
+    std::vector<GltfMaterial> materials_;
+    std::vector<int> texture_sources_;      // texture -> image
+    std::vector<GltfImage> images_;
+    std::vector<GltfNode> nodes_;
+    std::vector<int> scene_roots_;
+
+private:
+    struct Buffer{
+        MappedFile file;
+        std::vector<unsigned char> owned;
+        const unsigned char* data{nullptr};
+        size_t size{0};
+    };
+
+    bool parse_json(const char* begin, const char* end, const unsigned char* bin, const size_t bin_size);
+
+private:
+    MappedFile file_;
+    std::vector<Buffer> buffers_;
+};
+
+#endif
@@ -0,0 +1,342 @@
+#include "./image_decoder.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <csetjmp>
+#include <new>
+#include <iostream>
+#include <algorithm>
+
+#include "./vfs.h"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "./stb_image.h"
+
+#ifdef HAVE_SPNG
+#include <spng.h>
+#endif
+
+#ifdef HAVE_LIBJPEG_TURBO
+#include <cstdio>
+#include <jpeglib.h>
+#endif
+
+namespace {
+
+bool is_png(const unsigned char* data, const size_t size){
+    static const unsigned char kSignature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+    return size >= 8 && std::memcmp(data, kSignature, 8) == 0;
+}
+
+bool is_jpeg(const unsigned char* data, const size_t size){
+    return size >= 3 && data[0] == 0xff && data[1] == 0xd8 && data[2] == 0xff;
+}
+
+
+class StbImageDecoder : public ImageDecoder{
+public:
+    const char* name() const override { return "stb"; }
+
+    bool can_decode(const unsigned char* data, const size_t size) const override{
+        int width, height, channels;
+        return stbi_info_from_memory(data, size, &width, &height, &channels) != 0;
+    }
+
+    bool decode(const unsigned char* data, const size_t size, const int desired_channels,
+                DecodedImage& image) const override{
+        int channels;
+        unsigned char* pixels = stbi_load_from_memory(data, size, &image.width, &image.height, &channels, desired_channels);
+        if(!pixels)
+            return false;
+        image.channels = desired_channels ? desired_channels : channels;
+        image.pixels.adopt(pixels, static_cast<size_t>(image.width) * image.height * image.channels, stbi_image_free);
+        return true;
+    }
+};
+
+
+#ifdef HAVE_SPNG
+class SpngDecoder : public ImageDecoder{
+public:
+    const char* name() const override { return "spng"; }
+
+    bool can_decode(const unsigned char* data, const size_t size) const override{
+        return is_png(data, size);
+    }
+
+    bool decode(const unsigned char* data, const size_t size, const int desired_channels,
+                DecodedImage& image) const override{
+        spng_ctx* ctx = spng_ctx_new(0);
+        if(!ctx)
+            return false;
+        spng_set_png_buffer(ctx, data, size);
+
+        struct spng_ihdr ihdr;
+        if(spng_get_ihdr(ctx, &ihdr)){
+            spng_ctx_free(ctx);
+            return false;
+        }
+
+        // - 输出通道数与 stb 一致(文件中的分量数), 纹理格式不随后端变化: 调色板无 tRNS 为 3, 有 tRNS 为 4
+        const bool indexed = ihdr.color_type == SPNG_COLOR_TYPE_INDEXED;
+        struct spng_trns trns;
+        const bool palette_alpha = indexed && spng_get_trns(ctx, &trns) == 0;
+        int file_channels = 4;
+        if(ihdr.color_type == SPNG_COLOR_TYPE_GRAYSCALE)
+            file_channels = 1;
+        else if(ihdr.color_type == SPNG_COLOR_TYPE_GRAYSCALE_ALPHA)
+            file_channels = 2;
+        else if(ihdr.color_type == SPNG_COLOR_TYPE_TRUECOLOR || (indexed && !palette_alpha))
+            file_channels = 3;
+
+        // - 8bit 灰度直接输出 G8, RGB 与无透明的调色板输出 RGB8, 其余解为 RGBA8 后再转换
+        int format = SPNG_FMT_RGBA8;
+        int channels = 4;
+        if(ihdr.color_type == SPNG_COLOR_TYPE_GRAYSCALE && ihdr.bit_depth <= 8){
+            format = SPNG_FMT_G8;
+            channels = 1;
+        }else if(file_channels == 3){
+            format = SPNG_FMT_RGB8;
+            channels = 3;
+        }
+
+        size_t out_size = 0;
+        bool ok = spng_decoded_image_size(ctx, format, &out_size) == 0;
+        if(ok){
+            image.pixels.resize(out_size);
+            ok = spng_decode_image(ctx, image.pixels.data(), out_size, format, SPNG_DECODE_TRNS) == 0;
+        }
+        spng_ctx_free(ctx);
+        if(!ok)
+            return false;
+
+        image.width = ihdr.width;
+        image.height = ihdr.height;
+        image.channels = channels;
+        convert_channels(image, desired_channels ? desired_channels : file_channels);
+        return true;
+    }
+};
+#endif
+
+
+#ifdef HAVE_LIBJPEG_TURBO
+struct JpegErrorManager{
+    jpeg_error_mgr base;
+    std::jmp_buf jump;
+};
+
+void jpeg_error_exit(j_common_ptr cinfo){
+    JpegErrorManager* error = reinterpret_cast<JpegErrorManager*>(cinfo->err);
+    std::longjmp(error->jump, 1);
+}
+
+class JpegTurboDecoder : public ImageDecoder{
+public:
+    const char* name() const override { return "libjpeg-turbo"; }
+
+    bool can_decode(const unsigned char* data, const size_t size) const override{
+        return is_jpeg(data, size);
+    }
+
+    bool decode(const unsigned char* data, const size_t size, const int desired_channels,
+                DecodedImage& image) const override{
+        jpeg_decompress_struct cinfo;
+        JpegErrorManager error;
+        cinfo.err = jpeg_std_error(&error.base);
+        error.base.error_exit = jpeg_error_exit;
+        // - libjpeg 默认出错直接 exit, 用 longjmp 转成返回值
+        if(setjmp(error.jump)){
+            jpeg_destroy_decompress(&cinfo);
+            return false;
+        }
+
+        jpeg_create_decompress(&cinfo);
+        jpeg_mem_src(&cinfo, const_cast<unsigned char*>(data), size);
+        jpeg_read_header(&cinfo, TRUE);
+
+        int channels = cinfo.num_components == 1 ? 1 : 3;
+        cinfo.out_color_space = channels == 1 ? JCS_GRAYSCALE : JCS_RGB;
+#ifdef JCS_EXTENSIONS
+        if(desired_channels == 4 && channels == 3){
+            cinfo.out_color_space = JCS_EXT_RGBA;
+            channels = 4;
+        }
+#endif
+        jpeg_start_decompress(&cinfo);
+
+        image.width = cinfo.output_width;
+        image.height = cinfo.output_height;
+        image.channels = channels;
+        const size_t stride = static_cast<size_t>(image.width) * channels;
+        image.pixels.resize(stride * image.height);
+        while(cinfo.output_scanline < cinfo.output_height){
+            JSAMPROW row = image.pixels.data() + stride * cinfo.output_scanline;
+            jpeg_read_scanlines(&cinfo, &row, 1);
+        }
+        jpeg_finish_decompress(&cinfo);
+        jpeg_destroy_decompress(&cinfo);
+
+        if(desired_channels)
+            convert_channels(image, desired_channels);
+        return true;
+    }
+};
+#endif
+
+}
+
+
+const std::vector<const ImageDecoder*>& image_decoders(){
+    static std::vector<const ImageDecoder*> decoders = [](){
+        std::vector<const ImageDecoder*> list;
+#ifdef HAVE_SPNG
+        static SpngDecoder spng;
+        list.push_back(&spng);
+#endif
+#ifdef HAVE_LIBJPEG_TURBO
+        static JpegTurboDecoder jpeg_turbo;
+        list.push_back(&jpeg_turbo);
+#endif
+        static StbImageDecoder stb;
+        list.push_back(&stb);
+        return list;
+    }();
+    return decoders;
+}
+
+PixelBuffer& PixelBuffer::operator=(const PixelBuffer& other){
+    if(this != &other)
+        assign(other.data_, other.data_ + other.size_);
+    return *this;
+}
+
+PixelBuffer::PixelBuffer(PixelBuffer&& other) noexcept:
+    data_(other.data_), size_(other.size_), deleter_(other.deleter_){
+    other.data_ = nullptr;
+    other.size_ = 0;
+    other.deleter_ = nullptr;
+}
+
+PixelBuffer& PixelBuffer::operator=(PixelBuffer&& other) noexcept{
+    if(this != &other){
+        reset();
+        data_ = other.data_;
+        size_ = other.size_;
+        deleter_ = other.deleter_;
+        other.data_ = nullptr;
+        other.size_ = 0;
+        other.deleter_ = nullptr;
+    }
+    return *this;
+}
+
+void PixelBuffer::adopt(unsigned char* data, const size_t size, Deleter deleter){
+    reset();
+    data_ = data;
+    size_ = size;
+    deleter_ = deleter;
+}
+
+void PixelBuffer::resize(const size_t size){
+    if(size == size_)
+        return;
+    unsigned char* data = size ? static_cast<unsigned char*>(std::malloc(size)) : nullptr;
+    if(size && !data)
+        throw std::bad_alloc();
+    if(data_ && data)
+        std::memcpy(data, data_, std::min(size, size_));
+    adopt(data, size, std::free);
+}
+
+void PixelBuffer::assign(const unsigned char* first, const unsigned char* last){
+    const size_t size = last - first;
+    unsigned char* data = size ? static_cast<unsigned char*>(std::malloc(size)) : nullptr;
+    if(size && !data)
+        throw std::bad_alloc();
+    if(data)
+        std::memcpy(data, first, size);
+    adopt(data, size, std::free);
+}
+
+void PixelBuffer::reset(){
+    if(data_ && deleter_)
+        deleter_(data_);
+    data_ = nullptr;
+    size_ = 0;
+    deleter_ = nullptr;
+}
+
+const ImageDecoder& select_image_decoder(const unsigned char* data, const size_t size){
+    const std::vector<const ImageDecoder*>& decoders = image_decoders();
+    for(const ImageDecoder* decoder : decoders){
+        if(decoder->can_decode(data, size))
+            return *decoder;
+    }
+    return *decoders.back();
+}
+
+bool decode_image(const unsigned char* data, const size_t size, const int desired_channels, DecodedImage& image){
+    const ImageDecoder& decoder = select_image_decoder(data, size);
+    if(decoder.decode(data, size, desired_channels, image))
+        return true;
+
+    // - 快速后端失败(不支持的子格式等)时退回 stb
+    const ImageDecoder& fallback = *image_decoders().back();
+    if(&decoder != &fallback){
+        std::cout << "WARN: " << decoder.name() << " decode fail, fallback to " << fallback.name() << std::endl;
+        return fallback.decode(data, size, desired_channels, image);
+    }
+    return false;
+}
+
+bool decode_image_file(const std::string& img_path, const int desired_channels, DecodedImage& image){
+    MappedFile file = Vfs::instance().map(img_path);
+    if(!file.valid() || file.size() == 0)
+        return false;
+    return decode_image(file.data(), file.size(), desired_channels, image);
+}
+
+bool image_info(const unsigned char* data, const size_t size, int& width, int& height, int& channels){
+    return stbi_info_from_memory(data, static_cast<int>(size), &width, &height, &channels) != 0;
+}
+
+void convert_channels(DecodedImage& image, const int desired_channels){
+    const int src_channels = image.channels;
+    if(desired_channels == src_channels || desired_channels < 1 || desired_channels > 4)
+        return;
+
+    const size_t count = static_cast<size_t>(image.width) * image.height;
+    PixelBuffer out;
+    out.resize(count * desired_channels);
+    for(size_t i=0; i<count; i++){
+        const unsigned char* src = &image.pixels[i * src_channels];
+        unsigned char r, g, b, a = 255;
+        if(src_channels <= 2){
+            r = g = b = src[0];
+            if(src_channels == 2)
+                a = src[1];
+        }else{
+            r = src[0];
+            g = src[1];
+            b = src[2];
+            if(src_channels == 4)
+                a = src[3];
+        }
+
+        unsigned char* dst = &out[i * desired_channels];
+        if(desired_channels <= 2){
+            dst[0] = src_channels <= 2 ? r : static_cast<unsigned char>((r * 77 + g * 150 + b * 29) >> 8);
+            if(desired_channels == 2)
+                dst[1] = a;
+        }else{
+            dst[0] = r;
+            dst[1] = g;
+            dst[2] = b;
+            if(desired_channels == 4)
+                dst[3] = a;
+        }
+    }
+    image.pixels = std::move(out);
+    image.channels = desired_channels;
+}
@@ -0,0 +1,89 @@
+#ifndef OPENGL_IO_IMAGE_DECODER_H_
+#define OPENGL_IO_IMAGE_DECODER_H_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * 像素缓冲, 可直接接管解码库分配的内存(stb_image), 省去一次整图拷贝
+ * 自行分配的内存用 malloc / free
+ */
+class PixelBuffer{
+public:
+    using Deleter = void (*)(void*);
+
+    PixelBuffer(){}
+    ~PixelBuffer(){ reset(); }
+
+    PixelBuffer(const PixelBuffer& other){ assign(other.data_, other.data_ + other.size_); }
+    PixelBuffer& operator=(const PixelBuffer& other);
+    PixelBuffer(PixelBuffer&& other) noexcept;
+    PixelBuffer& operator=(PixelBuffer&& other) noexcept;
+
+    // - 接管 data, 析构时以 deleter 释放
+    void adopt(unsigned char* data, const size_t size, Deleter deleter);
+
+    // - 保留前 min(size, 原大小) 字节, 新增部分未初始化
+    void resize(const size_t size);
+    void assign(const unsigned char* first, const unsigned char* last);
+
+    unsigned char* data(){ return data_; }
+    const unsigned char* data() const { return data_; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    unsigned char& operator[](const size_t index){ return data_[index]; }
+    const unsigned char& operator[](const size_t index) const { return data_[index]; }
+
+private:
+    void reset();
+
+private:
+    unsigned char* data_{nullptr};
+    size_t size_{0};
+    Deleter deleter_{nullptr};
+};
+
+struct DecodedImage{
+    int width{0};
+    int height{0};
+    int channels{0};
+    PixelBuffer pixels;
+};
+
+/**
+ * 图片解码后端接口
+ * 构建时按可用的库注册更快的后端(libspng / libjpeg-turbo), stb_image 总是作为兜底
+ */
+class ImageDecoder{
+public:
+    virtual ~ImageDecoder(){}
+
+    virtual const char* name() const = 0;
+
+    // - 根据文件头判断能否解码
+    virtual bool can_decode(const unsigned char* data, const size_t size) const = 0;
+
+    /// @param desired_channels 0 表示保持原始通道数, 否则输出 1~4 通道
+    virtual bool decode(const unsigned char* data, const size_t size, const int desired_channels,
+                        DecodedImage& image) const = 0;
+};
+
+// - 已注册的全部后端, 优先级从高到低, 最后一个为 stb
+const std::vector<const ImageDecoder*>& image_decoders();
+
+// - 选择第一个能解码的后端
+const ImageDecoder& select_image_decoder(const unsigned char* data, const size_t size);
+
+bool decode_image(const unsigned char* data, const size_t size, const int desired_channels, DecodedImage& image);
+
+// - 经 Vfs mmap 读文件并解码
+bool decode_image_file(const std::string& img_path, const int desired_channels, DecodedImage& image);
+
+// - 只读文件头取宽高与原始通道数, 不解码
+bool image_info(const unsigned char* data, const size_t size, int& width, int& height, int& channels);
+
+// - 8bit 通道数转换, 规则与 stb_image 一致(灰度取加权亮度, 缺省 alpha 为 255)
+void convert_channels(DecodedImage& image, const int desired_channels);
+
+#endif
@@ -0,0 +1,33 @@
+#include "./memory_stats.h"
+
+#include <cstdio>
+#include <unistd.h>
+#include <sys/resource.h>
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+size_t process_rss_bytes(){
+    FILE* file = std::fopen("/proc/self/statm", "r");
+    if(!file)
+        return 0;
+    unsigned long size = 0, resident = 0;
+    const int read = std::fscanf(file, "%lu %lu", &size, &resident);
+    std::fclose(file);
+    if(read != 2)
+        return 0;
+    return static_cast<size_t>(resident) * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+
+size_t process_peak_rss_bytes(){
+    struct rusage usage;
+    if(getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+    return static_cast<size_t>(usage.ru_maxrss) * 1024;
+}
+
+void trim_heap(){
+#if defined(__GLIBC__)
+    malloc_trim(0);
+#endif
+}
@@ -0,0 +1,15 @@
+#ifndef OPENGL_IO_MEMORY_STATS_H_
+#define OPENGL_IO_MEMORY_STATS_H_
+
+#include <cstddef>
+
+// - 进程当前常驻内存(/proc/self/statm), 读取失败返回 0
+size_t process_rss_bytes();
+
+// - 进程峰值常驻内存(getrusage)
+size_t process_peak_rss_bytes();
+
+// - 把已 free 的堆内存还给系统, 大块释放后 RSS 才会随之下降
+void trim_heap();
+
+#endif
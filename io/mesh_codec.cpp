@@ -0,0 +1,552 @@
+#include "./mesh_codec.h"
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+const uint32_t kMeshCodecMagic = 0x434d4f54;   // "TOMC"
+const uint32_t kMeshCodecVersion = 1;
+const uint32_t kMeshCodecHasBones = 1u << 0;
+
+const size_t kBlockSize = 16;
+const int kVertexCacheSize = 32;
+
+// - 位置 3, 法线 3, uv 2, 切线 3, 副切线 3
+const size_t kBaseStreamCount = 14;
+const size_t kBoneStreamCount = 2 * MAX_BONE_INFLUENCE;
+const uint16_t kBoneNone = 0xffff;   // 骨骼 id -1 的编码
+
+struct MeshCodecHeader{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t vertex_count;
+    uint32_t index_count;
+    uint32_t flags;
+    uint32_t reserved;
+    float pos_min[3];
+    float pos_scale[3];
+    float uv_min[2];
+    float uv_scale[2];
+};
+
+inline uint16_t zigzag16(const uint16_t delta){
+    return static_cast<uint16_t>((delta << 1) ^ static_cast<uint16_t>(static_cast<int16_t>(delta) >> 15));
+}
+
+inline uint16_t unzigzag16(const uint16_t value){
+    return static_cast<uint16_t>((value >> 1) ^ (0u - (value & 1u)));
+}
+
+inline uint16_t quantize_unorm(const float value, const float min, const float scale){
+    if(scale <= 0.0f)
+        return 0;
+    const float q = (value - min) / scale + 0.5f;
+    return static_cast<uint16_t>(std::min(65535.0f, std::max(0.0f, q)));
+}
+
+inline uint16_t quantize_snorm(const float value){
+    const float q = std::min(1.0f, std::max(-1.0f, value)) * 32767.0f;
+    return static_cast<uint16_t>(static_cast<int16_t>(q >= 0.0f ? q + 0.5f : q - 0.5f));
+}
+
+inline float dequantize_snorm(const uint16_t value){
+    return std::max(-1.0f, static_cast<int16_t>(value) * (1.0f / 32767.0f));
+}
+
+// - Forsyth 顶点得分: 缓存中越靠前越高, 剩余三角形越少越高(尽快消耗掉孤立顶点)
+float vertex_score(const int cache_position, const unsigned int remaining){
+    if(remaining == 0)
+        return -1.0f;
+    float score = 0.0f;
+    if(cache_position >= 0){
+        if(cache_position < 3)
+            score = 0.75f;
+        else
+            score = std::pow(1.0f - (cache_position - 3) / static_cast<float>(kVertexCacheSize - 3), 1.5f);
+    }
+    return score + 2.0f / std::sqrt(static_cast<float>(remaining));
+}
+
+void append_varint(std::vector<unsigned char>& out, uint32_t value){
+    while(value >= 0x80){
+        out.push_back(static_cast<unsigned char>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<unsigned char>(value));
+}
+
+#if defined(__SSE2__)
+// - 8 个 16 位 zigzag 差分 -> 前缀和, carry 为上一组最后一个值(广播)
+inline __m128i decode_lanes(__m128i x, __m128i& carry){
+    const __m128i one = _mm_set1_epi16(1);
+    x = _mm_xor_si128(_mm_srli_epi16(x, 1), _mm_sub_epi16(_mm_setzero_si128(), _mm_and_si128(x, one)));
+    x = _mm_add_epi16(x, _mm_slli_si128(x, 2));
+    x = _mm_add_epi16(x, _mm_slli_si128(x, 4));
+    x = _mm_add_epi16(x, _mm_slli_si128(x, 8));
+    x = _mm_add_epi16(x, carry);
+    const __m128i last = _mm_shufflehi_epi16(x, _MM_SHUFFLE(3, 3, 3, 3));
+    carry = _mm_unpackhi_epi64(last, last);
+    return x;
+}
+#endif
+
+}
+
+void optimize_vertex_cache(std::vector<unsigned int>& indices, const size_t vertex_count){
+    const size_t triangle_count = indices.size() / 3;
+    if(triangle_count == 0)
+        return;
+
+    // - 顶点 -> 相邻三角形
+    std::vector<unsigned int> remaining(vertex_count, 0);
+    for(unsigned int index : indices)
+        remaining[index]++;
+    std::vector<unsigned int> adjacency_offset(vertex_count + 1, 0);
+    for(size_t v=0; v<vertex_count; v++)
+        adjacency_offset[v + 1] = adjacency_offset[v] + remaining[v];
+    std::vector<unsigned int> adjacency(indices.size());
+    std::vector<unsigned int> fill(adjacency_offset.begin(), adjacency_offset.end() - 1);
+    for(size_t t=0; t<triangle_count; t++){
+        for(int k=0; k<3; k++)
+            adjacency[fill[indices[t * 3 + k]]++] = static_cast<unsigned int>(t);
+    }
+
+    std::vector<int> cache_position(vertex_count, -1);
+    std::vector<float> score(vertex_count);
+    for(size_t v=0; v<vertex_count; v++)
+        score[v] = vertex_score(-1, remaining[v]);
+    std::vector<float> triangle_score(triangle_count);
+    for(size_t t=0; t<triangle_count; t++)
+        triangle_score[t] = score[indices[t * 3]] + score[indices[t * 3 + 1]] + score[indices[t * 3 + 2]];
+
+    std::vector<char> emitted(triangle_count, 0);
+    std::vector<unsigned int> result;
+    result.reserve(indices.size());
+    std::vector<unsigned int> cache, next_cache;
+    cache.reserve(kVertexCacheSize + 3);
+    next_cache.reserve(kVertexCacheSize + 3);
+
+    size_t scan_cursor = 0;
+    long best = -1;
+    for(size_t emitted_count=0; emitted_count<triangle_count; emitted_count++){
+        // - 缓存相邻三角形都已用完时, 从头找下一个未输出的三角形
+        if(best < 0){
+            while(emitted[scan_cursor])
+                scan_cursor++;
+            best = static_cast<long>(scan_cursor);
+        }
+        const unsigned int* tri = &indices[best * 3];
+        result.insert(result.end(), tri, tri + 3);
+        emitted[best] = 1;
+
+        for(int k=0; k<3; k++){
+            const unsigned int v = tri[k];
+            // - 从邻接表中移除该三角形
+            unsigned int* begin = &adjacency[adjacency_offset[v]];
+            unsigned int* end = begin + remaining[v];
+            unsigned int* it = std::find(begin, end, static_cast<unsigned int>(best));
+            if(it != end){
+                *it = *(end - 1);
+                remaining[v]--;
+            }
+        }
+
+        // - 新三角形的顶点放到缓存最前, 其余依次后移
+        next_cache.assign(tri, tri + 3);
+        for(unsigned int v : cache){
+            if(v != tri[0] && v != tri[1] && v != tri[2])
+                next_cache.push_back(v);
+        }
+        for(size_t i=0; i<next_cache.size(); i++)
+            cache_position[next_cache[i]] = i < static_cast<size_t>(kVertexCacheSize) ? static_cast<int>(i) : -1;
+
+        // - 更新受影响顶点与其三角形的得分, 同时找下一个最佳三角形
+        best = -1;
+        float best_score = -1.0f;
+        for(unsigned int v : next_cache){
+            score[v] = vertex_score(cache_position[v], remaining[v]);
+        }
+        for(unsigned int v : next_cache){
+            const unsigned int* begin = &adjacency[adjacency_offset[v]];
+            for(unsigned int i=0; i<remaining[v]; i++){
+                const unsigned int t = begin[i];
+                const float s = score[indices[t * 3]] + score[indices[t * 3 + 1]] + score[indices[t * 3 + 2]];
+                triangle_score[t] = s;
+                if(s > best_score){
+                    best_score = s;
+                    best = t;
+                }
+            }
+        }
+        if(next_cache.size() > static_cast<size_t>(kVertexCacheSize))
+            next_cache.resize(kVertexCacheSize);
+        cache.swap(next_cache);
+    }
+    indices.swap(result);
+}
+
+void optimize_vertex_fetch(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices){
+    std::vector<unsigned int> remap(vertices.size(), ~0u);
+    std::vector<Vertex> reordered;
+    reordered.reserve(vertices.size());
+    for(unsigned int& index : indices){
+        if(remap[index] == ~0u){
+            remap[index] = static_cast<unsigned int>(reordered.size());
+            reordered.push_back(vertices[index]);
+        }
+        index = remap[index];
+    }
+    vertices.swap(reordered);
+}
+
+void encode_u16_stream(const uint16_t* values, const size_t count, std::vector<unsigned char>& out){
+    const size_t block_count = (count + kBlockSize - 1) / kBlockSize;
+    const size_t header_offset = out.size();
+    out.resize(out.size() + (block_count + 3) / 4, 0);
+
+    uint16_t prev = 0;
+    uint16_t block[kBlockSize];
+    for(size_t b=0; b<block_count; b++){
+        uint16_t max_value = 0;
+        for(size_t i=0; i<kBlockSize; i++){
+            const size_t index = b * kBlockSize + i;
+            // - 尾部补 0 差分
+            const uint16_t value = index < count ? values[index] : prev;
+            block[i] = zigzag16(static_cast<uint16_t>(value - prev));
+            prev = value;
+            max_value = std::max(max_value, block[i]);
+        }
+        const unsigned int width = max_value == 0 ? 0 : (max_value < 256 ? 1 : 2);
+        out[header_offset + b / 4] |= static_cast<unsigned char>(width << ((b % 4) * 2));
+        if(width == 1){
+            for(size_t i=0; i<kBlockSize; i++)
+                out.push_back(static_cast<unsigned char>(block[i]));
+        }else if(width == 2){
+            for(size_t i=0; i<kBlockSize; i++){
+                out.push_back(static_cast<unsigned char>(block[i] & 0xff));
+                out.push_back(static_cast<unsigned char>(block[i] >> 8));
+            }
+        }
+    }
+}
+
+namespace {
+
+// - 单个流的解码状态, 按 16 个值一块推进
+struct StreamDecoder{
+    const unsigned char* header{nullptr};
+    const unsigned char* p{nullptr};
+#if defined(__SSE2__)
+    __m128i carry;
+#else
+    uint16_t carry{0};
+#endif
+};
+
+// - 先扫描块宽度得到流的总长度, 之后逐块解码无需再做越界检查
+bool init_stream(StreamDecoder& decoder, const unsigned char* data, const size_t size, const size_t count, size_t& used){
+    const size_t block_count = (count + kBlockSize - 1) / kBlockSize;
+    const size_t header_size = (block_count + 3) / 4;
+    if(size < header_size)
+        return false;
+    size_t data_size = 0;
+    for(size_t b=0; b<block_count; b++){
+        const unsigned int width = (data[b / 4] >> ((b % 4) * 2)) & 3;
+        if(width == 3)
+            return false;
+        data_size += width * kBlockSize;
+    }
+    used = header_size + data_size;
+    if(used > size)
+        return false;
+    decoder.header = data;
+    decoder.p = data + header_size;
+#if defined(__SSE2__)
+    decoder.carry = _mm_setzero_si128();
+#else
+    decoder.carry = 0;
+#endif
+    return true;
+}
+
+inline void decode_block(StreamDecoder& decoder, const size_t block, uint16_t* out){
+    const unsigned int width = (decoder.header[block / 4] >> ((block % 4) * 2)) & 3;
+#if defined(__SSE2__)
+    __m128i x0, x1;
+    if(width == 0){
+        x0 = x1 = _mm_setzero_si128();
+    }else if(width == 1){
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(decoder.p));
+        x0 = _mm_unpacklo_epi8(bytes, _mm_setzero_si128());
+        x1 = _mm_unpackhi_epi8(bytes, _mm_setzero_si128());
+    }else{
+        x0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(decoder.p));
+        x1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(decoder.p + 16));
+    }
+    x0 = decode_lanes(x0, decoder.carry);
+    x1 = decode_lanes(x1, decoder.carry);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out), x0);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 8), x1);
+#else
+    for(size_t i=0; i<kBlockSize; i++){
+        uint16_t zz = 0;
+        if(width == 1)
+            zz = decoder.p[i];
+        else if(width == 2)
+            zz = static_cast<uint16_t>(decoder.p[i * 2] | (decoder.p[i * 2 + 1] << 8));
+        decoder.carry = static_cast<uint16_t>(decoder.carry + unzigzag16(zz));
+        out[i] = decoder.carry;
+    }
+#endif
+    decoder.p += width * kBlockSize;
+}
+
+}
+
+size_t decode_u16_stream(const unsigned char* data, const size_t size, uint16_t* values, const size_t count){
+    StreamDecoder decoder;
+    size_t used = 0;
+    if(!init_stream(decoder, data, size, count, used))
+        return 0;
+    const size_t block_count = (count + kBlockSize - 1) / kBlockSize;
+    uint16_t tail[kBlockSize];
+    for(size_t b=0; b<block_count; b++){
+        if((b + 1) * kBlockSize <= count){
+            decode_block(decoder, b, values + b * kBlockSize);
+        }else{
+            decode_block(decoder, b, tail);
+            std::memcpy(values + b * kBlockSize, tail, (count - b * kBlockSize) * sizeof(uint16_t));
+        }
+    }
+    return used;
+}
+
+void encode_index_buffer(const unsigned int* indices, const size_t count, std::vector<unsigned char>& out){
+    // - 与下一个新顶点序号的距离: 新顶点为 0, 缓存中刚用过的顶点为小的负数
+    uint32_t next = 0;
+    for(size_t i=0; i<count; i++){
+        const int32_t delta = static_cast<int32_t>(indices[i] - next);
+        append_varint(out, (static_cast<uint32_t>(delta) << 1) ^ static_cast<uint32_t>(delta >> 31));
+        next = std::max(next, indices[i] + 1);
+    }
+}
+
+size_t decode_index_buffer(const unsigned char* data, const size_t size, unsigned int* indices, const size_t count){
+    uint32_t next = 0;
+    size_t offset = 0;
+    for(size_t i=0; i<count; i++){
+        uint32_t value = 0;
+        int shift = 0;
+        while(true){
+            if(offset >= size || shift > 28)
+                return 0;
+            const unsigned char byte = data[offset++];
+            value |= static_cast<uint32_t>(byte & 0x7f) << shift;
+            if(!(byte & 0x80))
+                break;
+            shift += 7;
+        }
+        const uint32_t index = next + ((value >> 1) ^ (0u - (value & 1u)));
+        indices[i] = index;
+        next = std::max(next, index + 1);
+    }
+    return offset;
+}
+
+bool encode_mesh(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices, std::vector<unsigned char>& out,
+                 const bool optimize){
+    for(unsigned int index : indices){
+        if(index >= vertices.size())
+            return false;
+    }
+    // - 骨骼 id 只能是 -1(无骨骼)或 uint16 能表示的序号, 其它值不编码, 调用方保留未压缩的数据
+    for(const Vertex& vertex : vertices){
+        for(int k=0; k<MAX_BONE_INFLUENCE; k++){
+            if(vertex.bone_ids[k] < -1 || vertex.bone_ids[k] >= kBoneNone)
+                return false;
+        }
+    }
+    if(optimize){
+        optimize_vertex_cache(indices, vertices.size());
+        optimize_vertex_fetch(vertices, indices);
+    }
+
+    const size_t vertex_count = vertices.size();
+    MeshCodecHeader header;
+    std::memset(&header, 0, sizeof(header));
+    header.magic = kMeshCodecMagic;
+    header.version = kMeshCodecVersion;
+    header.vertex_count = static_cast<uint32_t>(vertex_count);
+    header.index_count = static_cast<uint32_t>(indices.size());
+
+    // - 量化范围
+    float pos_max[3], uv_max[2];
+    for(int k=0; k<3; k++){
+        header.pos_min[k] = vertex_count ? vertices[0].pos[k] : 0.0f;
+        pos_max[k] = header.pos_min[k];
+    }
+    for(int k=0; k<2; k++){
+        header.uv_min[k] = vertex_count ? vertices[0].tex_coord[k] : 0.0f;
+        uv_max[k] = header.uv_min[k];
+    }
+    for(const Vertex& vertex : vertices){
+        for(int k=0; k<3; k++){
+            header.pos_min[k] = std::min(header.pos_min[k], vertex.pos[k]);
+            pos_max[k] = std::max(pos_max[k], vertex.pos[k]);
+        }
+        for(int k=0; k<2; k++){
+            header.uv_min[k] = std::min(header.uv_min[k], vertex.tex_coord[k]);
+            uv_max[k] = std::max(uv_max[k], vertex.tex_coord[k]);
+        }
+        for(int k=0; k<MAX_BONE_INFLUENCE; k++){
+            if(vertex.bone_ids[k] != 0 || vertex.weights[k] != 0.0f)
+                header.flags |= kMeshCodecHasBones;
+        }
+    }
+    for(int k=0; k<3; k++)
+        header.pos_scale[k] = (pos_max[k] - header.pos_min[k]) / 65535.0f;
+    for(int k=0; k<2; k++)
+        header.uv_scale[k] = (uv_max[k] - header.uv_min[k]) / 65535.0f;
+
+    const size_t stream_count = kBaseStreamCount + (header.flags & kMeshCodecHasBones ? kBoneStreamCount : 0);
+    std::vector<uint16_t> streams(stream_count * vertex_count);
+    for(size_t i=0; i<vertex_count; i++){
+        const Vertex& vertex = vertices[i];
+        uint16_t q[kBaseStreamCount + kBoneStreamCount];
+        for(int k=0; k<3; k++){
+            q[k] = quantize_unorm(vertex.pos[k], header.pos_min[k], header.pos_scale[k]);
+            q[3 + k] = quantize_snorm(vertex.normal[k]);
+            q[8 + k] = quantize_snorm(vertex.tangent[k]);
+            q[11 + k] = quantize_snorm(vertex.bitangent[k]);
+        }
+        for(int k=0; k<2; k++)
+            q[6 + k] = quantize_unorm(vertex.tex_coord[k], header.uv_min[k], header.uv_scale[k]);
+        for(int k=0; k<MAX_BONE_INFLUENCE; k++){
+            q[kBaseStreamCount + k] = vertex.bone_ids[k] < 0 ? kBoneNone : static_cast<uint16_t>(vertex.bone_ids[k]);
+            q[kBaseStreamCount + MAX_BONE_INFLUENCE + k] = quantize_unorm(vertex.weights[k], 0.0f, 1.0f / 65535.0f);
+        }
+        for(size_t s=0; s<stream_count; s++)
+            streams[s * vertex_count + i] = q[s];
+    }
+
+    out.clear();
+    out.resize(sizeof(header));
+    std::memcpy(out.data(), &header, sizeof(header));
+    for(size_t s=0; s<stream_count; s++)
+        encode_u16_stream(&streams[s * vertex_count], vertex_count, out);
+    encode_index_buffer(indices.data(), indices.size(), out);
+    return true;
+}
+
+bool decode_mesh(const unsigned char* data, const size_t size, std::vector<Vertex>& vertices, std::vector<unsigned int>& indices){
+    MeshCodecHeader header;
+    if(size < sizeof(header))
+        return false;
+    std::memcpy(&header, data, sizeof(header));
+    if(header.magic != kMeshCodecMagic || header.version != kMeshCodecVersion)
+        return false;
+
+    const size_t vertex_count = header.vertex_count;
+    const bool has_bones = header.flags & kMeshCodecHasBones;
+    const size_t stream_count = kBaseStreamCount + (has_bones ? kBoneStreamCount : 0);
+    StreamDecoder decoders[kBaseStreamCount + kBoneStreamCount];
+    size_t offset = sizeof(header);
+    for(size_t s=0; s<stream_count; s++){
+        size_t used = 0;
+        if(!init_stream(decoders[s], data + offset, size - offset, vertex_count, used))
+            return false;
+        offset += used;
+    }
+    indices.resize(header.index_count);
+    if(header.index_count > 0 && decode_index_buffer(data + offset, size - offset, indices.data(), indices.size()) == 0)
+        return false;
+    for(unsigned int index : indices){
+        if(index >= vertex_count)
+            return false;
+    }
+
+    // - 按块解码全部流后立即反量化, 中间数据留在 L1 中
+    vertices.resize(vertex_count);
+    Vertex* out = vertices.data();
+    alignas(16) uint16_t q[kBaseStreamCount + kBoneStreamCount][kBlockSize];
+    alignas(16) float f[kBaseStreamCount + kBoneStreamCount][kBlockSize];
+    float scale[kBaseStreamCount + kBoneStreamCount], bias[kBaseStreamCount + kBoneStreamCount];
+    bool snorm[kBaseStreamCount + kBoneStreamCount];
+    for(size_t s=0; s<stream_count; s++){
+        snorm[s] = (s >= 3 && s < 6) || (s >= 8 && s < kBaseStreamCount);
+        scale[s] = snorm[s] ? 1.0f / 32767.0f : 1.0f;
+        bias[s] = 0.0f;
+    }
+    for(int k=0; k<3; k++){
+        scale[k] = header.pos_scale[k];
+        bias[k] = header.pos_min[k];
+    }
+    for(int k=0; k<2; k++){
+        scale[6 + k] = header.uv_scale[k];
+        bias[6 + k] = header.uv_min[k];
+    }
+    for(int k=0; k<MAX_BONE_INFLUENCE && has_bones; k++)
+        scale[kBaseStreamCount + MAX_BONE_INFLUENCE + k] = 1.0f / 65535.0f;
+
+    const size_t block_count = (vertex_count + kBlockSize - 1) / kBlockSize;
+    for(size_t b=0; b<block_count; b++){
+        for(size_t s=0; s<stream_count; s++){
+            decode_block(decoders[s], b, q[s]);
+#if defined(__SSE2__)
+            const __m128 scale4 = _mm_set1_ps(scale[s]), bias4 = _mm_set1_ps(bias[s]);
+            for(size_t i=0; i<kBlockSize; i+=8){
+                const __m128i x = _mm_load_si128(reinterpret_cast<const __m128i*>(&q[s][i]));
+                __m128i lo, hi;
+                if(snorm[s]){
+                    // - 放到高 16 位再算术右移, 完成符号扩展
+                    lo = _mm_srai_epi32(_mm_unpacklo_epi16(_mm_setzero_si128(), x), 16);
+                    hi = _mm_srai_epi32(_mm_unpackhi_epi16(_mm_setzero_si128(), x), 16);
+                }else{
+                    lo = _mm_unpacklo_epi16(x, _mm_setzero_si128());
+                    hi = _mm_unpackhi_epi16(x, _mm_setzero_si128());
+                }
+                _mm_store_ps(&f[s][i], _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(lo), scale4), bias4));
+                _mm_store_ps(&f[s][i + 4], _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(hi), scale4), bias4));
+            }
+#else
+            for(size_t i=0; i<kBlockSize; i++){
+                const float value = snorm[s] ? static_cast<int16_t>(q[s][i]) : q[s][i];
+                f[s][i] = value * scale[s] + bias[s];
+            }
+#endif
+        }
+
+        // - SoA -> Vertex; snorm 的 -32768 夹到 -1
+        const size_t n = std::min(kBlockSize, vertex_count - b * kBlockSize);
+        Vertex* dst = out + b * kBlockSize;
+        for(size_t i=0; i<n; i++){
+            Vertex& vertex = dst[i];
+            vertex.pos = glm::vec3(f[0][i], f[1][i], f[2][i]);
+            vertex.normal = glm::vec3(std::max(-1.0f, f[3][i]), std::max(-1.0f, f[4][i]), std::max(-1.0f, f[5][i]));
+            vertex.tex_coord = glm::vec2(f[6][i], f[7][i]);
+            vertex.tangent = glm::vec3(std::max(-1.0f, f[8][i]), std::max(-1.0f, f[9][i]), std::max(-1.0f, f[10][i]));
+            vertex.bitangent = glm::vec3(std::max(-1.0f, f[11][i]), std::max(-1.0f, f[12][i]), std::max(-1.0f, f[13][i]));
+        }
+        if(has_bones){
+            for(size_t i=0; i<n; i++){
+                for(int k=0; k<MAX_BONE_INFLUENCE; k++){
+                    const uint16_t bone = q[kBaseStreamCount + k][i];
+                    dst[i].bone_ids[k] = bone == kBoneNone ? -1 : bone;
+                    dst[i].weights[k] = f[kBaseStreamCount + MAX_BONE_INFLUENCE + k][i];
+                }
+            }
+        }else{
+            for(size_t i=0; i<n; i++){
+                std::memset(dst[i].bone_ids, 0, sizeof(dst[i].bone_ids));
+                std::memset(dst[i].weights, 0, sizeof(dst[i].weights));
+            }
+        }
+    }
+    return true;
+}
@@ -0,0 +1,42 @@
+#ifndef OPENGL_IO_MESH_CODEC_H_
+#define OPENGL_IO_MESH_CODEC_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "./vertex.h"
+
+/**
+ * 顶点 / 索引压缩
+ * - 顶点: 各属性量化为 16 位(位置 / uv 按包围盒, 法线 / 切线为 snorm), 拆成 SoA 流,
+ *         每个流做差分 + zigzag, 每 16 个值一组按 0 / 1 / 2 字节定宽存储, SSE2 解码
+ * - 索引: 按顶点缓存顺序编码为与"下一个新顶点"的距离, zigzag + varint, 新顶点只占 1 字节
+ * 编码前先做顶点缓存优化与按首次使用重排顶点, 使差分与索引距离都尽量小
+ * 量化有损: 位置误差不超过包围盒边长 / 65535
+ */
+
+/// @brief 按 Forsyth 算法重排三角形, 提高 post-transform 顶点缓存命中
+void optimize_vertex_cache(std::vector<unsigned int>& indices, const size_t vertex_count);
+
+/// @brief 按索引中首次出现的顺序重排顶点并改写索引, 未被引用的顶点被丢弃
+void optimize_vertex_fetch(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices);
+
+// - 单个 uint16 流的差分定宽编码
+void encode_u16_stream(const uint16_t* values, const size_t count, std::vector<unsigned char>& out);
+
+/// @return 消耗的输入字节数, 数据不完整时返回 0
+size_t decode_u16_stream(const unsigned char* data, const size_t size, uint16_t* values, const size_t count);
+
+void encode_index_buffer(const unsigned int* indices, const size_t count, std::vector<unsigned char>& out);
+
+size_t decode_index_buffer(const unsigned char* data, const size_t size, unsigned int* indices, const size_t count);
+
+/// @brief 编码整个 mesh, optimize 为 true 时先重排三角形与顶点(改写传入的数组)
+/// @return 索引越界或骨骼 id 不在 [-1, 65534] 时返回 false, 骨骼 id -1(无骨骼)原样保留
+bool encode_mesh(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices, std::vector<unsigned char>& out,
+                 const bool optimize = true);
+
+bool decode_mesh(const unsigned char* data, const size_t size, std::vector<Vertex>& vertices, std::vector<unsigned int>& indices);
+
+#endif
@@ -1,8 +1,15 @@
 #ifndef OPENGL_IO_MODEL_H__
 #define OPENGL_IO_MODEL_H__
+#include <iostream>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
 #include <vector>
 #include <map>
+#include <algorithm>
+#include <memory>
 #include <unordered_map>
+#include <chrono>
 
 
 #include <glm/glm.hpp>
@@ -12,19 +19,36 @@
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 
-#define STB_IMAGE_IMPLEMENTATION
-#include "../io/stb_image.h"
+#include "../io/vfs.h"
+#include "../io/vfs_assimp.h"
+#include "../io/vertex.h"
+#include "../io/mesh_codec.h"
+#include "../io/image_decoder.h"
+#include "../io/batch_reader.h"
+#include "../io/bundle.h"
+#include "../io/gltf.h"
+#include "../io/ply.h"
+#include "../core/job_system.h"
+#include "../core/task.h"
+#include "../core/profiler.h"
+#include "../io/async_loader.h"
+#include "../io/memory_stats.h"
 
 #include "../shader/shader.h"
-
-#define MAX_BONE_INFLUENCE 4
+#include "../render/gl_handle.h"
+#include "../render/gl_upload_thread.h"
+#include "../render/gpu_timer.h"
+#include "../texture/texture_array.h"
+#include "../texture/atlas_packer.h"
+#include "../texture/texture_manager.h"
 
 enum LightType{
     AMBIENT = 0,
     DIFFUSE,
     SPECULAR,
     NORMAL,
-    HEIGHT
+    HEIGHT,
+    PACKED
 };
 const std::string LightTypeStr(const LightType& light){
     switch(light){
@@ -38,55 +62,68 @@ const std::string LightTypeStr(const LightType& light){
             return "normal";
         case LightType::HEIGHT:
             return "height";
+        case LightType::PACKED:
+            return "packed";
         default:
             std::cout << "ERROR: LightType " << LightType::AMBIENT << std::endl;
             return "";
     }
 }
 
+// - 纹理数组按角色分组, 顺序与 object_array shader 中 material.layers 分量一致
+const int kTextureRoleCount = 4;
+int texture_role_index(const std::string& type){
+    if(type == LightTypeStr(LightType::DIFFUSE)) return 0;
+    if(type == LightTypeStr(LightType::SPECULAR)) return 1;
+    if(type == LightTypeStr(LightType::NORMAL)) return 2;
+    if(type == LightTypeStr(LightType::HEIGHT)) return 3;
+    return -1;
+}
 
-unsigned int load_texture(const std::string& img_path){
-
-    unsigned int texture_id;
-    glGenTextures(1, &texture_id);
-    glBindTexture(GL_TEXTURE_2D, texture_id);
 
-    int start_id = img_path.find_last_of("/");
-    std::string img_name = img_path.substr(start_id+1,  img_path.size() - start_id -1);
+// - 统一走 TextureManager, 按内容去重并计数, 用完需 TextureManager::release
+unsigned int load_texture(const std::string& img_path){
+    PROFILE_ZONE("load_texture");
+    return TextureManager::instance().acquire(img_path);
+}
 
-    // 设置纹理对象环绕、过滤方式
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-    // 加载纹理
-    int width, height, nrChannels;
-    unsigned char *data = stbi_load(img_path.c_str(), &width, &height, &nrChannels, 0);
-    
-    GLenum format;
-    if (nrChannels == 1)
-        format = GL_RED;
-    else if (nrChannels == 3)
-        format = GL_RGB;
-    else if (nrChannels == 4)
-        format = GL_RGBA;
+// - RGBA8 的 CPU 端图像, 用于打包(纹理数组 / atlas)时的中间数据; 直接接管解码结果的缓冲
+struct RgbaImage{
+    int width{0};
+    int height{0};
+    PixelBuffer data;
+};
 
-    if(data){
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
+// - 运行时生成(非文件)的纹理以此为名字前缀, 例如 atlas
+const std::string kGeneratedTexturePrefix = "@";
 
-        std::cout << "Read " << img_path << ", width "<< width << ", height " << height << ", nrChannels" << nrChannels << std::endl;
-    }
-    else
-    {
+bool load_rgba_image(const std::string& img_path, RgbaImage& image){
+    DecodedImage decoded;
+    if(!decode_image_file(img_path, 4, decoded)){
         std::cout << "ERROR: Read image fail, path " << img_path << std::endl;
+        return false;
     }
+    image.width = decoded.width;
+    image.height = decoded.height;
+    image.data = std::move(decoded.pixels);
+    return true;
+}
 
-    stbi_image_free(data);
-
-    return texture_id;
-
+// - 从 GL 纹理读回 level 0, 用于没有源文件的生成纹理
+bool read_texture_rgba(const unsigned int texture_id, RgbaImage& image){
+    glBindTexture(GL_TEXTURE_2D, texture_id);
+    glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &image.width);
+    glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &image.height);
+    if(image.width <= 0 || image.height <= 0){
+        glBindTexture(GL_TEXTURE_2D, 0);
+        return false;
+    }
+    image.data.resize(static_cast<size_t>(image.width) * image.height * 4);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, image.data.data());
+    glBindTexture(GL_TEXTURE_2D, 0);
+    return true;
 }
 
 
@@ -101,57 +138,134 @@ struct Texture{
 };
 
 
-struct Vertex{
-    glm::vec3 pos{0.0f, 0.0f, 0.0f};
-    glm::vec3 normal{0.0f, 0.0f, 0.0f};
-    glm::vec2 tex_coord{0.0f, 0.0f};
-    glm::vec3 tangent{0.0f, 0.0f, 0.0f};
-    glm::vec3 bitangent{0.0f, 0.0f, 0.0f};
-    int bone_ids[MAX_BONE_INFLUENCE];
-    float weights[MAX_BONE_INFLUENCE];
-    
+// - 打包贴图中各数据所在的通道, -1 表示未打包(仍使用独立贴图或没有该贴图)
+struct ChannelRemap{
+    int specular{-1};
+    int height{-1};
+};
+
+// - 上传 GPU 之后 CPU 端几何(vertices_ / indices_)的保留策略
+enum class GeometryRetention{
+    KEEP = 0,   // 全部保留
+    DROP,       // 释放, 需要时从 GPU 缓冲读回
+    COMPACT     // 只保留 mesh_codec 编码的紧凑副本, 需要时解码(量化有损)
 };
 
+const std::string GeometryRetentionStr(const GeometryRetention& retention){
+    switch(retention){
+        case GeometryRetention::KEEP:
+            return "keep";
+        case GeometryRetention::DROP:
+            return "drop";
+        case GeometryRetention::COMPACT:
+            return "compact";
+        default:
+            return "";
+    }
+}
+
+// - 提交的绘制调用与三角形数, 由 Mesh::draw_elements 累加; 只在 GL 线程访问, 基准按帧清零
+struct DrawStats{
+    uint64_t draw_calls{0};
+    uint64_t triangles{0};
+};
+
+DrawStats& draw_stats(){
+    static DrawStats stats;
+    return stats;
+}
+
 class Mesh{
 public:
     Mesh(){};
-    Mesh(const Mesh& other){
-        vertices_ = other.vertices_;
-        indices_ = other.indices_;
-        textures_ = other.textures_;
-    };
-    Mesh(const Mesh&& other){
-        vertices_ = std::move(other.vertices_);
-        indices_ = std::move(other.indices_);
-        textures_ = std::move(other.textures_);
-    };
-    ~Mesh(){
-        // glDeleteVertexArrays(1, &VAO_);
-        // glDeleteBuffers(1, &VBO_);
-        // glDeleteBuffers(1, &EBO_);
-    };
+
+    // - 持有 GL 对象, 只可移动; 析构时经 GlDeletionQueue 延迟删除
+    Mesh(const Mesh&) = delete;
+    Mesh& operator=(const Mesh&) = delete;
+    Mesh(Mesh&&) = default;
+    Mesh& operator=(Mesh&&) = default;
 
     void setup_mesh();
+
+    // - setup_mesh 的两步: 顶点 / 索引缓冲可在共享 context 中上传, VAO 不在 context 间共享, 需在绘制的 context 中建
+    void upload_buffers();
+    void setup_vertex_array();
+
     void draw(Shader& shader);
 
+    // - 只提交几何, 不绑定纹理
+    void draw_elements();
+
+    // - VAO 已由外部直接建好(如 glTF 零拷贝上传), 或 CPU 端几何已按保留策略释放
+    bool gpu_only() const { return VAO_ != 0 && vertices_.empty(); }
+
+    /**
+     * 按策略释放 CPU 端几何, 需在 setup_mesh 之后; 释放后绘制改用记录下的顶点 / 索引数
+     * COMPACT 编码失败时退化为 DROP
+    */
+    void release_cpu_geometry(const GeometryRetention retention);
+
+    /**
+     * 取回已释放的 CPU 端几何: 有紧凑副本时解码, 否则从 VBO / EBO 读回(需在 GL 线程)
+     *@ param lossless: 忽略紧凑副本, 总是从 VBO / EBO 读回; 之后要 update_vertex_buffer 写回时必须为 true,
+     *                  否则量化后的顶点会覆盖 GPU 上的完整精度数据
+     *@ return: 当前是否有 CPU 端几何, 从未有过 CPU 端几何的 mesh(glTF 零拷贝)返回 false
+    */
+    bool ensure_cpu_geometry(const bool lossless = false);
+
+    // - CPU 端顶点修改后写回 VBO(需在 GL 线程), 顶点须来自完整精度的数据; 旧的紧凑副本作废, 下次释放时重新编码
+    void update_vertex_buffer();
+
+    bool cpu_geometry_released() const { return geometry_released_; }
+
+    // - CPU 端几何(含紧凑副本)占用的字节数
+    size_t cpu_geometry_bytes() const;
+
 public:
     std::vector<Vertex> vertices_;
     std::vector<unsigned int> indices_;
     std::vector<Texture> textures_;
-    unsigned int VBO_, EBO_, VAO_;
+    GlBuffer VBO_, EBO_;
+    GlVertexArray VAO_;
+    // - 外部建好的索引缓冲的类型 / 数量 / 字节偏移, index_count_ 为 0 时使用 indices_
+    unsigned int index_type_{GL_UNSIGNED_INT};
+    size_t index_count_{0};
+    size_t index_offset_{0};
+    // - 图元类型; 没有索引时(点云)按 vertex_count_ 用 glDrawArrays 绘制
+    unsigned int draw_mode_{GL_TRIANGLES};
+    size_t vertex_count_{0};
+    int material_index_{-1};  // 纹理数组模式下的材质序号, -1 表示不可合批
+    ChannelRemap channel_remap_;
+    std::vector<unsigned char> compact_geometry_;   // COMPACT 策略下的 mesh_codec 编码数据
+    bool geometry_released_{false};
 };
 
 void Mesh::setup_mesh(){
-    glGenVertexArrays(1, &VAO_);
-    glGenBuffers(1, &VBO_);
-    glGenBuffers(1, &EBO_);
+    if(gpu_only())
+        return;
+    upload_buffers();
+    setup_vertex_array();
+}
+
+void Mesh::upload_buffers(){
+    VBO_ = GlBuffer::create();
+    EBO_ = GlBuffer::create();
+
+    // - 不依赖 VAO 的绑定点, 可在没有 VAO 的共享 context 中上传
+    glBindBuffer(GL_COPY_WRITE_BUFFER, VBO_);
+    glBufferData(GL_COPY_WRITE_BUFFER, vertices_.size() * sizeof(Vertex), vertices_.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, EBO_);
+    glBufferData(GL_COPY_WRITE_BUFFER, indices_.size() * sizeof(unsigned int), indices_.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+void Mesh::setup_vertex_array(){
+    VAO_ = GlVertexArray::create();
 
     glBindVertexArray(VAO_);
 
     glBindBuffer(GL_ARRAY_BUFFER, VBO_);
-    glBufferData(GL_ARRAY_BUFFER, vertices_.size() * sizeof(Vertex), &vertices_[0], GL_STATIC_DRAW);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO_);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices_.size() * sizeof(unsigned int), &indices_[0], GL_STATIC_DRAW);
 
     
     glEnableVertexAttribArray(0);
@@ -184,7 +298,11 @@ void Mesh::draw(Shader& shader){
                 {LightTypeStr(LightType::DIFFUSE), 1}, 
                 {LightTypeStr(LightType::SPECULAR), 1}, 
                 {LightTypeStr(LightType::NORMAL), 1}, 
-                {LightTypeStr(LightType::HEIGHT), 1}};
+                {LightTypeStr(LightType::HEIGHT), 1},
+                {LightTypeStr(LightType::PACKED), 1}};
+
+    // - 通道打包的 shader 变体按此选择通道, 与上一个 mesh 相同时不重复设置
+    shader.set_packed_channels(channel_remap_.specular, channel_remap_.height);
 
     for(size_t i=0; i < textures_.size(); i++){
         unsigned int& index = num_st.at(textures_[i].type);
@@ -195,53 +313,368 @@ void Mesh::draw(Shader& shader){
         index++;
     }
 
+    draw_elements();
+}
+
+void Mesh::draw_elements(){
     glBindVertexArray(VAO_);
-    glDrawElements(GL_TRIANGLES, static_cast<unsigned int>(indices_.size()), GL_UNSIGNED_INT, 0);
+    const size_t count = index_count_ ? index_count_ : indices_.size();
+    if(count == 0)
+        glDrawArrays(draw_mode_, 0, static_cast<GLsizei>(vertex_count_ ? vertex_count_ : vertices_.size()));
+    else
+        glDrawElements(draw_mode_, static_cast<unsigned int>(count), index_type_, reinterpret_cast<void*>(index_offset_));
     glBindVertexArray(0);
+
+    DrawStats& stats = draw_stats();
+    stats.draw_calls++;
+    if(draw_mode_ == GL_TRIANGLES)
+        stats.triangles += count / 3;
+}
+
+void Mesh::release_cpu_geometry(const GeometryRetention retention){
+    if(retention == GeometryRetention::KEEP || geometry_released_ || VAO_ == 0 || vertices_.empty())
+        return;
+    if(retention == GeometryRetention::COMPACT && compact_geometry_.empty()){
+        // - 不重排, 解码结果与 GPU 上的顶点顺序一致
+        if(!encode_mesh(vertices_, indices_, compact_geometry_, false))
+            std::vector<unsigned char>().swap(compact_geometry_);
+    }
+    if(retention == GeometryRetention::DROP)
+        std::vector<unsigned char>().swap(compact_geometry_);
+    vertex_count_ = vertices_.size();
+    index_count_ = indices_.size();
+    std::vector<Vertex>().swap(vertices_);
+    std::vector<unsigned int>().swap(indices_);
+    geometry_released_ = true;
+}
+
+bool Mesh::ensure_cpu_geometry(const bool lossless){
+    if(!geometry_released_)
+        return !vertices_.empty();
+    if(!lossless && !compact_geometry_.empty()){
+        if(!decode_mesh(compact_geometry_.data(), compact_geometry_.size(), vertices_, indices_))
+            return false;
+    }else{
+        // - 用 COPY_READ 绑定点读回, 不改动当前 VAO 的索引缓冲绑定
+        vertices_.resize(vertex_count_);
+        indices_.resize(index_count_);
+        glBindBuffer(GL_COPY_READ_BUFFER, VBO_);
+        glGetBufferSubData(GL_COPY_READ_BUFFER, 0, vertices_.size() * sizeof(Vertex), vertices_.data());
+        glBindBuffer(GL_COPY_READ_BUFFER, EBO_);
+        glGetBufferSubData(GL_COPY_READ_BUFFER, 0, indices_.size() * sizeof(unsigned int), indices_.data());
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    }
+    geometry_released_ = false;
+    return true;
+}
+
+void Mesh::update_vertex_buffer(){
+    std::vector<unsigned char>().swap(compact_geometry_);
+    if(VBO_ == 0 || vertices_.empty())
+        return;
+    glBindBuffer(GL_COPY_WRITE_BUFFER, VBO_);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, 0, vertices_.size() * sizeof(Vertex), vertices_.data());
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+size_t Mesh::cpu_geometry_bytes() const{
+    return vertices_.capacity() * sizeof(Vertex) + indices_.capacity() * sizeof(unsigned int) + compact_geometry_.capacity();
+}
+
+bool path_has_extension(const std::string& path, const std::string& ext){
+    return path.size() > ext.size() && path.compare(path.size() - ext.size(), ext.size(), ext) == 0;
+}
+
+// - 与 aiProcess_GenSmoothNormals 一致: 面法线按面积加权累加后归一化
+void generate_smooth_normals(std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices){
+    for(size_t i=0; i+2<indices.size(); i+=3){
+        const glm::vec3 p0 = vertices[indices[i]].pos;
+        const glm::vec3 e1 = vertices[indices[i + 1]].pos - p0;
+        const glm::vec3 e2 = vertices[indices[i + 2]].pos - p0;
+        const glm::vec3 face(e1.y * e2.z - e1.z * e2.y, e1.z * e2.x - e1.x * e2.z, e1.x * e2.y - e1.y * e2.x);
+        for(int k=0; k<3; k++)
+            vertices[indices[i + k]].normal = vertices[indices[i + k]].normal + face;
+    }
+    for(Vertex& vertex : vertices){
+        const glm::vec3& n = vertex.normal;
+        const float length = std::sqrt(n.x * n.x + n.y * n.y + n.z * n.z);
+        if(length > 0.0f)
+            vertex.normal = n / length;
+    }
+}
+
+
+
+// - 资源包中的 mesh 块: 头 + 纹理引用{type, name} + 几何
+//   几何为 Vertex 数组 + 索引, 或 flags 含 kBundleMeshEncoded 时为 mesh_codec 编码数据
+const uint32_t kBundleMeshEncoded = 1u << 0;
+
+struct BundleMeshHeader{
+    uint32_t vertex_count;
+    uint32_t index_count;
+    uint32_t texture_count;
+    uint32_t flags;
+};
+
+void append_bytes(std::vector<unsigned char>& out, const void* data, const size_t size){
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    out.insert(out.end(), bytes, bytes + size);
 }
 
+void append_string(std::vector<unsigned char>& out, const std::string& str){
+    const uint32_t length = static_cast<uint32_t>(str.size());
+    append_bytes(out, &length, sizeof(length));
+    append_bytes(out, str.data(), str.size());
+}
+
+// - encode 为 true 时几何经 mesh_codec 量化压缩, 三角形与顶点顺序会被重排
+std::vector<unsigned char> serialize_mesh(const Mesh& mesh, const bool encode = true){
+    std::vector<unsigned char> geometry;
+    // - 重排时会丢弃未被引用的顶点, 头中记录编码后的数量
+    size_t vertex_count = mesh.vertices_.size();
+    if(encode){
+        std::vector<Vertex> vertices = mesh.vertices_;
+        std::vector<unsigned int> indices = mesh.indices_;
+        if(!encode_mesh(vertices, indices, geometry))
+            return serialize_mesh(mesh, false);
+        vertex_count = vertices.size();
+    }else{
+        append_bytes(geometry, mesh.vertices_.data(), mesh.vertices_.size() * sizeof(Vertex));
+        append_bytes(geometry, mesh.indices_.data(), mesh.indices_.size() * sizeof(unsigned int));
+    }
+
+    BundleMeshHeader header{static_cast<uint32_t>(vertex_count), static_cast<uint32_t>(mesh.indices_.size()),
+                            static_cast<uint32_t>(mesh.textures_.size()), encode ? kBundleMeshEncoded : 0};
+    std::vector<unsigned char> out;
+    append_bytes(out, &header, sizeof(header));
+    for(const Texture& texture : mesh.textures_){
+        append_string(out, texture.type);
+        append_string(out, texture.name);
+    }
+    out.insert(out.end(), geometry.begin(), geometry.end());
+    return out;
+}
+
+// - 纹理只还原 type / name, id 由调用方按 name 填入
+bool deserialize_mesh(const std::vector<unsigned char>& data, Mesh& mesh){
+    size_t offset = 0;
+    auto read_bytes = [&](void* dst, const size_t size){
+        if(offset + size > data.size())
+            return false;
+        if(size > 0)
+            std::memcpy(dst, data.data() + offset, size);
+        offset += size;
+        return true;
+    };
+    auto read_string = [&](std::string& str){
+        uint32_t length = 0;
+        if(!read_bytes(&length, sizeof(length)) || offset + length > data.size())
+            return false;
+        str.assign(reinterpret_cast<const char*>(data.data() + offset), length);
+        offset += length;
+        return true;
+    };
+
+    BundleMeshHeader header;
+    if(!read_bytes(&header, sizeof(header)))
+        return false;
+    mesh.textures_.resize(header.texture_count);
+    for(Texture& texture : mesh.textures_){
+        texture.id = 0;
+        if(!read_string(texture.type) || !read_string(texture.name))
+            return false;
+    }
+
+    if(header.flags & kBundleMeshEncoded){
+        return decode_mesh(data.data() + offset, data.size() - offset, mesh.vertices_, mesh.indices_)
+               && mesh.vertices_.size() == header.vertex_count && mesh.indices_.size() == header.index_count;
+    }
+    mesh.vertices_.resize(header.vertex_count);
+    mesh.indices_.resize(header.index_count);
+    return read_bytes(mesh.vertices_.data(), mesh.vertices_.size() * sizeof(Vertex))
+           && read_bytes(mesh.indices_.data(), mesh.indices_.size() * sizeof(unsigned int));
+}
 
 
 class Model{
 public:
-    Model(const std::string& model_path);
+    /**
+     *@ model_path: 模型文件, 以 .bundle 结尾时从资源包加载
+     *@ load_textures: 为 false 时只导入几何与纹理名, 不读图片也不需要 GL context (离线打包用)
+    */
+    Model(const std::string& model_path, bool load_textures = true);
+
+    // - 由已导入的 Assimp 场景构造, 贴图应已由 load_texture_async 登记到 TextureManager; 需在 GL 线程
+    Model(const std::string& model_path, const aiScene* scene);
+    ~Model();
+
+    /**
+     * 协程加载: Assimp 导入和贴图的读取、解码在 JobSystem worker, 贴图上传与构造 Model 在 GL 线程
+     * 贴图经 load_texture_async 同时加载, 之后 process_material 命中 TextureManager 的路径缓存
+     * bundle / glTF / PLY 的读取过程中就有 GL 上传, 在 GL 线程按同步方式构造
+     *@ return: 与 Model(model_path) 相同, 调用方之后照常 setup_mesh
+    */
+    static Task<std::unique_ptr<Model>> load_async(std::string model_path);
+
+    // - 场景材质引用的不重复贴图路径
+    static std::vector<std::string> texture_paths(const aiScene* scene, const std::string& directory);
 
     void load_model(const std::string& model_path);
 
+    /**
+     * 批量预取场景引用的全部贴图: io_uring 一次提交读取, 线程池并行哈希与解码, GL 线程统一上传
+     * 之后 process_material 命中 TextureManager 的路径缓存
+     * 环境变量 TEST_OPENGL_COLD_CACHE 非空时先丢弃这些文件的 page cache
+     *@ return: 预取持有的纹理引用, process_node 之后需 release
+    */
+    std::vector<unsigned int> prefetch_textures(const aiScene* scene);
+
+    // - 读取 bundle_packer 生成的资源包, chunk 在线程池中并行解压
+    void load_bundle(const std::string& bundle_path);
+
+    /**
+     * 原生读取 glTF 2.0 / GLB, 不经过 Assimp
+     * - 格式可直接作为 GL 顶点属性的 primitive: bufferView 从 mmap 整块上传为 GL 缓冲, VAO 按访问器设置格式与步长
+     * - 节点带变换、非三角形、缺法线或格式不受支持时才展开为 Vertex 数组
+    */
+    void load_gltf(const std::string& gltf_path);
+
+    /**
+     * 原生读取二进制 PLY (扫描数据 / 点云), 不经过 Assimp
+     * - 属性先解码为紧凑 SoA (PlyData), 再按块在线程池中并行转换为 Vertex
+     * - 点云(没有面)不展开为 Vertex: 各属性数组直接上传为独立 GL 缓冲, 用 GL_POINTS 绘制
+    */
+    void load_ply(const std::string& ply_path);
+
     void process_node(const aiNode* node, const aiScene* scene);
 
     Mesh process_mesh(const aiMesh* ai_mesh, const aiScene* scene);
 
     std::vector<Texture> process_material(const aiMaterial* material, aiTextureType material_type);
 
-    // - 
+    // - 上传全部 mesh, 之后按 retention_ 释放 CPU 端几何
     void setup_mesh();
 
+    // - 同 setup_mesh, 缓冲在 GlUploadThread 上传(未启动时在 GL 线程), fence 完成后回到 GL 线程建 VAO
+    Task<void> setup_mesh_async();
+
+    // - 按 retention_ 释放 CPU 端几何, 输出释放前后的几何字节数与进程 RSS
+    void apply_retention();
+
+    // - 取回全部已释放的 CPU 端几何, 供拾取 / 包围盒 / 重新打包等 CPU 端查询; lossless 见 Mesh::ensure_cpu_geometry
+    bool ensure_cpu_geometry(const bool lossless = false);
+
+    size_t cpu_geometry_bytes() const;
+
     void draw(Shader& shader);
 
+    /**
+     * 将同尺寸贴图按角色打包进 GL_TEXTURE_2D_ARRAY, 每个材质变为一组 layer 序号并写入 SSBO
+     * 进入数组的 mesh 释放各自的 2D 纹理(id 置 0), 之后只能用 draw_batched 绘制; 作为最后一个打包步骤, 结束时释放图像缓存
+     *@ resize_mismatched: 尺寸与该角色主尺寸不一致的贴图是否重采样进数组, 否则对应 mesh 走普通路径
+     *@ return: 是否启用 (需要 GL 4.3 SSBO)
+    */
+    bool build_texture_arrays(bool resize_mismatched = false);
+
+    /**
+     * 把小贴图合并进 atlas 并重映射 UV; 在 setup_mesh 之后调用时已释放的几何先取回, 改写 VBO 后按 retention_ 重新释放
+     *@ max_size: 贴图宽高都不超过该值才参与合并
+     *@ padding: 每块四周外扩的像素(边缘复制), 同时限制 mip 层数避免相邻块串色
+     *@ return: 被合并的 mesh 数
+    */
+    size_t pack_small_textures(int max_size = 256, int atlas_size = 1024, int padding = 4);
+
+    /**
+     * 把单通道的 specular / height 贴图合并到一张 R8 / RG8 贴图的不同通道
+     * 每个 mesh 记录 ChannelRemap, 需配合 PACKED_CHANNELS 的 shader 变体
+     *@ tolerance: RGB 分量最大差值, 不超过即视为单通道数据
+     *@ return: 使用打包贴图的 mesh 数
+    */
+    size_t pack_material_channels(int tolerance = 2);
+
+    // - 可合批的 mesh 用 array_shader 一次绑定全部绘制, 其余用 fallback_shader 走 Mesh::draw
+    void draw_batched(Shader& array_shader, Shader& fallback_shader);
+
+private:
+    // - 删除 loaded_texture 中已没有 mesh 引用的 GL 纹理
+    void release_unused_textures();
+
+    // - 贴图的 RGBA8 数据: 优先取 TextureManager 保留的首次解码结果; 生成纹理与资源包纹理没有源文件, 从 GL 读回
+    bool texture_image(const Texture& texture, RgbaImage& image);
+
+    // - 打包步骤共用的图像缓存, 每张贴图只准备一次; 失败返回 nullptr
+    const RgbaImage* cached_image(const Texture& texture);
+
+    // - 贴图宽高, 不解码: 依次查缓存、GL 纹理参数、文件头
+    bool texture_size(const Texture& texture, int& width, int& height);
+
+    void release_image_cache();
+
 public:
+    struct MaterialLayers{
+        int layers[kTextureRoleCount]{-1, -1, -1, -1};
+    };
+
     std::string directory_;
     std::unordered_map<std::string, Texture> loaded_texture;
 
     std::vector<Mesh> meshes_;
 
-};
+    std::unique_ptr<TextureArray> texture_arrays_[kTextureRoleCount];
+    std::vector<MaterialLayers> materials_;
+    GlBuffer material_ssbo_;
 
+    bool load_textures_{true};
+    bool from_bundle_{false};
+    GeometryRetention retention_{GeometryRetention::KEEP};
 
-Model::Model(const std::string& model_path){
-    Assimp::Importer importer;
-    std::string obj_path = model_path;
-    const aiScene* scene = importer.ReadFile(obj_path, aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
-    if(!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode){
-        std::cout << " - import fail, path = " << obj_path << std::endl; 
-        exit(-1);
-    }
+    std::vector<GlBuffer> gpu_buffers_;   // 直接上传的 GL 缓冲 (glTF bufferView / PLY 点云属性)
 
+private:
+    std::unordered_map<std::string, RgbaImage> image_cache_;   // texture id(或名字) -> RGBA8
+
+};
+
+
+Model::Model(const std::string& model_path, bool load_textures):
+    load_textures_(load_textures){
+    const auto start = std::chrono::steady_clock::now();
     directory_ = model_path.substr(0, model_path.find_last_of("/"));
     std::cout << " - directory_ " << directory_ << std::endl;
 
-    process_node(scene->mRootNode, scene);
+    auto has_ext = [&model_path](const std::string& ext){ return path_has_extension(model_path, ext); };
+    std::string source = "loose files";
+    if(has_ext(".bundle")){
+        source = "bundle";
+        load_bundle(model_path);
+    }else if(has_ext(".glb") || has_ext(".gltf")){
+        source = "glTF";
+        load_gltf(model_path);
+    }else if(has_ext(".ply")){
+        source = "PLY";
+        load_ply(model_path);
+    }else{
+        Assimp::Importer importer;
+        // - obj / mtl 等都经过 Vfs 的 mmap 读取, Importer 负责释放 IOSystem
+        importer.SetIOHandler(new VfsIOSystem());
+        std::string obj_path = model_path;
+        const aiScene* scene = importer.ReadFile(obj_path, aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
+        if(!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode){
+            std::cout << " - import fail, path = " << obj_path << std::endl; 
+            exit(-1);
+        }
+
+        std::vector<unsigned int> prefetched;
+        if(load_textures_)
+            prefetched = prefetch_textures(scene);
+        process_node(scene->mRootNode, scene);
+        for(unsigned int texture_id : prefetched)
+            TextureManager::instance().release(texture_id);
+    }
 
+    const auto end = std::chrono::steady_clock::now();
+    std::cout << "OUT: model load " << std::chrono::duration<double, std::milli>(end - start).count() << " ms, "
+              << source << std::endl;
     std::cout << "OUT: mesh count " << meshes_.size() << std::endl;
     std::cout << "OUT: textures sum " << loaded_texture.size() << std::endl;
     for(size_t i=0; i<meshes_.size(); i++){
@@ -252,20 +685,1185 @@ Model::Model(const std::string& model_path){
     }
 }
 
+Model::Model(const std::string& model_path, const aiScene* scene){
+    directory_ = model_path.substr(0, model_path.find_last_of("/"));
+    process_node(scene->mRootNode, scene);
+}
+
+Task<std::unique_ptr<Model>> Model::load_async(std::string model_path){
+    const auto start = std::chrono::steady_clock::now();
+    if(path_has_extension(model_path, ".bundle") || path_has_extension(model_path, ".glb") ||
+       path_has_extension(model_path, ".gltf") || path_has_extension(model_path, ".ply")){
+        co_await resume_on_gl_thread();
+        co_return std::unique_ptr<Model>(new Model(model_path));
+    }
+
+    co_await schedule_on_jobs("model_import");
+    Assimp::Importer importer;
+    importer.SetIOHandler(new VfsIOSystem());
+    const aiScene* scene = importer.ReadFile(model_path, aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
+    if(!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode){
+        std::cout << " - import fail, path = " << model_path << std::endl;
+        exit(-1);
+    }
+    const auto import_end = std::chrono::steady_clock::now();
+
+    const std::string directory = model_path.substr(0, model_path.find_last_of("/"));
+    std::vector<Task<unsigned int>> textures;
+    for(const std::string& img_path : texture_paths(scene, directory))
+        textures.push_back(load_texture_async(img_path));
+    co_await when_all(textures);
+
+    co_await resume_on_gl_thread();
+    std::unique_ptr<Model> model(new Model(model_path, scene));
+    for(Task<unsigned int>& texture : textures)
+        TextureManager::instance().release(texture.result());
+
+    const auto end = std::chrono::steady_clock::now();
+    std::cout << "OUT: model load " << std::chrono::duration<double, std::milli>(end - start).count() << " ms, async (import "
+              << std::chrono::duration<double, std::milli>(import_end - start).count() << " ms, "
+              << textures.size() << " textures), mesh count " << model->meshes_.size() << std::endl;
+    co_return model;
+}
+
+Model::~Model(){
+    for(const auto& item : loaded_texture)
+        TextureManager::instance().release(item.second.id);
+}
+
 void Model::setup_mesh(){
     for(size_t i=0; i< meshes_.size(); i++){
         meshes_[i].setup_mesh();
     }
+    apply_retention();
+}
+
+Task<void> Model::setup_mesh_async(){
+    co_await resume_on_upload_thread();
+    for(Mesh& mesh : meshes_){
+        if(!mesh.gpu_only())
+            mesh.upload_buffers();
+    }
+    co_await publish_to_gl_thread();
+    for(Mesh& mesh : meshes_){
+        if(!mesh.gpu_only())
+            mesh.setup_vertex_array();
+    }
+    apply_retention();
+}
+
+void Model::apply_retention(){
+    if(retention_ == GeometryRetention::KEEP)
+        return;
+    const size_t bytes_before = cpu_geometry_bytes();
+    const size_t rss_before = process_rss_bytes();
+    for(Mesh& mesh : meshes_)
+        mesh.release_cpu_geometry(retention_);
+    trim_heap();
+    const size_t bytes_after = cpu_geometry_bytes();
+    const size_t rss_after = process_rss_bytes();
+    const double mb = 1024.0 * 1024.0;
+    std::cout << "OUT: geometry retention " << GeometryRetentionStr(retention_) << ", CPU geometry "
+              << bytes_before / mb << " MB -> " << bytes_after / mb << " MB, RSS "
+              << rss_before / mb << " MB -> " << rss_after / mb << " MB" << std::endl;
+}
+
+bool Model::ensure_cpu_geometry(const bool lossless){
+    bool ok = true;
+    for(Mesh& mesh : meshes_){
+        if(mesh.cpu_geometry_released())
+            ok = mesh.ensure_cpu_geometry(lossless) && ok;
+    }
+    return ok;
+}
+
+size_t Model::cpu_geometry_bytes() const{
+    size_t bytes = 0;
+    for(const Mesh& mesh : meshes_)
+        bytes += mesh.cpu_geometry_bytes();
+    return bytes;
 }
 
 void Model::draw(Shader& shader){
+    const bool mesh_scopes = GpuTimer::instance().mesh_scopes();
     for(size_t i=0; i<meshes_.size(); i++){
+        GPU_ZONE_IF("gpu_mesh", mesh_scopes);
         meshes_[i].draw(shader);
     }
 }
 
+void Model::load_bundle(const std::string& bundle_path){
+    const auto start = std::chrono::steady_clock::now();
+    BundleReader reader;
+    if(!reader.open(bundle_path))
+        exit(-1);
+    from_bundle_ = true;
+
+    const std::vector<BundleEntry>& entries = reader.entries();
+    std::vector<std::vector<unsigned char>> chunks(entries.size());
+    std::vector<char> chunk_ok(entries.size(), 0);
+    JobSystem::instance().parallel_for(0, entries.size(), 1, [&](size_t begin, size_t end){
+        for(size_t i=begin; i<end; i++){
+            if(!load_textures_ && entries[i].kind == BUNDLE_CHUNK_TEXTURE)
+                continue;
+            chunk_ok[i] = reader.read(entries[i], chunks[i]);
+        }
+    }, "bundle_chunk");
+    const auto decompress_end = std::chrono::steady_clock::now();
+
+    uint64_t packed_bytes = 0, raw_bytes = 0;
+    size_t mesh_count = 0;
+    for(size_t i=0; i<entries.size(); i++){
+        packed_bytes += entries[i].packed_size;
+        raw_bytes += entries[i].raw_size;
+        if(!chunk_ok[i])
+            continue;
+
+        if(entries[i].kind == BUNDLE_CHUNK_TEXTURE){
+            BundleTextureHeader header;
+            if(chunks[i].size() < sizeof(header))
+                continue;
+            std::memcpy(&header, chunks[i].data(), sizeof(header));
+            const std::string name = entries[i].name.substr(entries[i].name.find('/') + 1);
+            unsigned int tex_id = TextureManager::instance().acquire_mip_chain(name, entries[i].hash,
+                                        header.width, header.height, header.channels, header.levels,
+                                        chunks[i].data() + sizeof(header));
+            loaded_texture.insert({name, Texture(tex_id, "", name)});
+            std::vector<unsigned char>().swap(chunks[i]);
+        }else if(entries[i].kind == BUNDLE_CHUNK_MESH){
+            mesh_count++;
+        }
+    }
+
+    // - mesh 块按名字中的序号还原顺序
+    meshes_.resize(mesh_count);
+    for(size_t i=0; i<entries.size(); i++){
+        if(!chunk_ok[i] || entries[i].kind != BUNDLE_CHUNK_MESH)
+            continue;
+        const size_t index = std::strtoul(entries[i].name.c_str() + entries[i].name.find('/') + 1, nullptr, 10);
+        if(index >= meshes_.size() || !deserialize_mesh(chunks[i], meshes_[index])){
+            std::cout << "ERROR: bundle mesh chunk corrupt, " << entries[i].name << std::endl;
+            exit(-1);
+        }
+        for(Texture& texture : meshes_[index].textures_){
+            auto it = loaded_texture.find(texture.name);
+            if(it != loaded_texture.end())
+                texture.id = it->second.id;
+        }
+    }
+
+    const auto end = std::chrono::steady_clock::now();
+    auto ms = [](std::chrono::steady_clock::time_point a, std::chrono::steady_clock::time_point b){
+        return std::chrono::duration<double, std::milli>(b - a).count();
+    };
+    std::cout << "OUT: bundle " << entries.size() << " chunks, " << packed_bytes / (1024.0 * 1024.0) << " MB -> "
+              << raw_bytes / (1024.0 * 1024.0) << " MB, decompress " << ms(start, decompress_end)
+              << " ms, total " << ms(start, end) << " ms" << std::endl;
+}
+
+bool Model::texture_image(const Texture& texture, RgbaImage& image){
+    DecodedImage decoded;
+    if(texture.id != 0 && TextureManager::instance().take_decoded(texture.id, decoded)){
+        convert_channels(decoded, 4);
+        image.width = decoded.width;
+        image.height = decoded.height;
+        image.data = std::move(decoded.pixels);
+        return true;
+    }
+
+    bool generated = texture.name.compare(0, kGeneratedTexturePrefix.size(), kGeneratedTexturePrefix) == 0;
+    const std::string path = directory_ + "/" + texture.name;
+    // - 资源包与 GLB 内嵌图片没有对应文件
+    if(generated || from_bundle_ || !Vfs::instance().exists(path))
+        return read_texture_rgba(texture.id, image);
+    return load_rgba_image(path, image);
+}
+
+// - 去重后同一 GL 纹理可能有多个名字, 有 id 时按 id 缓存
+std::string image_cache_key(const Texture& texture){
+    return texture.id != 0 ? "#" + std::to_string(texture.id) : texture.name;
+}
+
+const RgbaImage* Model::cached_image(const Texture& texture){
+    const std::string key = image_cache_key(texture);
+    auto it = image_cache_.find(key);
+    if(it != image_cache_.end())
+        return &it->second;
+    RgbaImage image;
+    if(!texture_image(texture, image))
+        return nullptr;
+    return &image_cache_.insert({key, std::move(image)}).first->second;
+}
+
+bool Model::texture_size(const Texture& texture, int& width, int& height){
+    auto it = image_cache_.find(image_cache_key(texture));
+    if(it != image_cache_.end()){
+        width = it->second.width;
+        height = it->second.height;
+        return true;
+    }
+    width = height = 0;
+    if(texture.id != 0){
+        glBindTexture(GL_TEXTURE_2D, texture.id);
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width);
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        return width > 0 && height > 0;
+    }
+    MappedFile file = Vfs::instance().map(directory_ + "/" + texture.name);
+    int channels = 0;
+    return file.valid() && image_info(file.data(), file.size(), width, height, channels);
+}
+
+void Model::release_image_cache(){
+    std::unordered_map<std::string, RgbaImage>().swap(image_cache_);
+}
+
+void Model::load_gltf(const std::string& gltf_path){
+    GltfAsset asset;
+    if(!asset.load(gltf_path))
+        exit(-1);
+
+    // - glTF 贴图 -> Texture, 名字为图片 uri 或 "<文件名>#image<序号>"
+    std::vector<int> texture_loaded(asset.texture_sources_.size(), 0);
+    std::vector<Texture> textures(asset.texture_sources_.size());
+    auto gltf_texture = [&](const int texture, const std::string& type, std::vector<Texture>& out){
+        if(texture < 0 || texture >= static_cast<int>(textures.size()) || !load_textures_)
+            return;
+        if(!texture_loaded[texture]){
+            texture_loaded[texture] = 1;
+            const int source = asset.texture_sources_[texture];
+            if(source < 0 || source >= static_cast<int>(asset.images_.size()))
+                return;
+            const GltfImage& image = asset.images_[source];
+            std::string name;
+            unsigned int tex_id = 0;
+            if(!image.uri.empty()){
+                name = image.uri;
+                if(loaded_texture.find(name) == loaded_texture.end())
+                    tex_id = load_texture(directory_ + "/" + name);
+            }else{
+                name = gltf_path.substr(gltf_path.find_last_of("/") + 1) + "#image" + std::to_string(source);
+                size_t size = 0;
+                const unsigned char* bytes = asset.image_data(source, size);
+                if(bytes && loaded_texture.find(name) == loaded_texture.end()){
+                    const uint64_t hash = TextureManager::content_hash(bytes, size);
+                    DecodedImage decoded;
+                    if(TextureManager::instance().contains(hash, bytes, size) || decode_image(bytes, size, 0, decoded))
+                        tex_id = TextureManager::instance().acquire_decoded(name, hash, bytes, size, decoded);
+                }
+            }
+            if(tex_id != 0)
+                loaded_texture.insert({name, Texture(tex_id, "", name)});
+            auto it = loaded_texture.find(name);
+            if(it != loaded_texture.end())
+                textures[texture] = it->second;
+        }
+        if(textures[texture].id != 0){
+            Texture item = textures[texture];
+            item.type = type;
+            out.push_back(item);
+        }
+    };
+
+    // - 访问器能否直接作为 GL 顶点属性: 不稀疏, 偏移与步长按分量对齐, 且分量类型在允许列表内
+    auto attribute_ok = [&](const std::map<std::string, int>& attributes, const std::string& name, const int components,
+                            const std::vector<int>& types, const bool need_normalized){
+        auto it = attributes.find(name);
+        if(it == attributes.end() || it->second < 0 || it->second >= static_cast<int>(asset.accessors_.size()))
+            return false;
+        const GltfAccessor& accessor = asset.accessors_[it->second];
+        const size_t component = GltfAsset::component_size(accessor.component_type);
+        if(accessor.sparse || accessor.buffer_view < 0 || accessor.components != components
+           || std::find(types.begin(), types.end(), accessor.component_type) == types.end()
+           || (need_normalized && accessor.component_type != kGltfFloat && !accessor.normalized))
+            return false;
+        return (asset.views_[accessor.buffer_view].byte_offset + accessor.byte_offset) % component == 0
+               && asset.accessor_stride(accessor) % component == 0;
+    };
+
+    std::unordered_map<int, unsigned int> view_buffers;
+    size_t uploaded_bytes = 0;
+    auto view_buffer = [&](const int view){
+        auto it = view_buffers.find(view);
+        if(it != view_buffers.end())
+            return it->second;
+        GlBuffer buffer = GlBuffer::create();
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        glBufferData(GL_ARRAY_BUFFER, asset.views_[view].byte_length, asset.view_data(view), GL_STATIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        uploaded_bytes += asset.views_[view].byte_length;
+        view_buffers[view] = buffer;
+        gpu_buffers_.push_back(std::move(buffer));
+        return view_buffers[view];
+    };
+    auto bind_attribute = [&](const GltfPrimitive& primitive, const std::string& name, const unsigned int location, const int size){
+        auto it = primitive.attributes.find(name);
+        if(it == primitive.attributes.end())
+            return;
+        const GltfAccessor& accessor = asset.accessors_[it->second];
+        glBindBuffer(GL_ARRAY_BUFFER, view_buffer(accessor.buffer_view));
+        glEnableVertexAttribArray(location);
+        glVertexAttribPointer(location, size, accessor.component_type, accessor.normalized ? GL_TRUE : GL_FALSE,
+                              static_cast<GLsizei>(asset.accessor_stride(accessor)), reinterpret_cast<void*>(accessor.byte_offset));
+    };
+
+    const std::vector<int> float_types{kGltfFloat};
+    const std::vector<int> snorm_types{kGltfFloat, kGltfByte, kGltfShort};
+    const std::vector<int> unorm_types{kGltfFloat, kGltfUnsignedByte, kGltfUnsignedShort};
+    const std::vector<int> index_types{kGltfUnsignedByte, kGltfUnsignedShort, kGltfUnsignedInt};
+
+    size_t direct_count = 0, expanded_count = 0, skipped_count = 0;
+    for(const GltfMeshInstance& instance : asset.mesh_instances()){
+        const GltfMesh& gltf_mesh = asset.meshes_[instance.mesh];
+        for(const GltfPrimitive& primitive : gltf_mesh.primitives){
+            Mesh mesh;
+            if(primitive.material >= 0 && primitive.material < static_cast<int>(asset.materials_.size())){
+                const GltfMaterial& material = asset.materials_[primitive.material];
+                gltf_texture(material.base_color_texture, LightTypeStr(LightType::DIFFUSE), mesh.textures_);
+                gltf_texture(material.specular_texture, LightTypeStr(LightType::SPECULAR), mesh.textures_);
+                gltf_texture(material.normal_texture, LightTypeStr(LightType::NORMAL), mesh.textures_);
+            }
+
+            const GltfAccessor* index_accessor = primitive.indices >= 0 && primitive.indices < static_cast<int>(asset.accessors_.size())
+                                               ? &asset.accessors_[primitive.indices] : nullptr;
+            const bool indices_ok = index_accessor && !index_accessor->sparse && index_accessor->buffer_view >= 0
+                                    && index_accessor->components == 1
+                                    && asset.views_[index_accessor->buffer_view].byte_stride == 0
+                                    && std::find(index_types.begin(), index_types.end(), index_accessor->component_type) != index_types.end()
+                                    && index_accessor->byte_offset % GltfAsset::component_size(index_accessor->component_type) == 0;
+            const auto& attributes = primitive.attributes;
+            // - 文件中的索引直接交给 GPU, 须全部小于各个绑定属性的元素数, 否则越界取顶点; 不满足时走展开路径(逐个检查)
+            auto indices_in_range = [&](){
+                size_t vertex_count = SIZE_MAX;
+                for(const char* name : {"POSITION", "NORMAL", "TEXCOORD_0", "TANGENT", "JOINTS_0", "WEIGHTS_0"}){
+                    auto it = attributes.find(name);
+                    if(it != attributes.end())
+                        vertex_count = std::min(vertex_count, asset.accessors_[it->second].count);
+                }
+                unsigned int max = 0;
+                return asset.max_index(primitive.indices, max) && static_cast<size_t>(max) < vertex_count;
+            };
+            // - 直接引用 GL 缓冲, 没有 GL context 时(离线打包, glad 未加载)展开为 Vertex
+            const bool direct = GLAD_GL_VERSION_3_3 && GltfAsset::is_identity(instance.matrix) && primitive.mode == kGltfTriangles
+                                && indices_ok
+                                && attribute_ok(attributes, "POSITION", 3, float_types, false)
+                                && attribute_ok(attributes, "NORMAL", 3, snorm_types, true)
+                                && (!attributes.count("TEXCOORD_0") || attribute_ok(attributes, "TEXCOORD_0", 2, unorm_types, true))
+                                && (!attributes.count("TANGENT") || attribute_ok(attributes, "TANGENT", 4, snorm_types, true))
+                                && (!attributes.count("JOINTS_0") || attribute_ok(attributes, "JOINTS_0", 4, {kGltfUnsignedByte, kGltfUnsignedShort}, false))
+                                && (!attributes.count("WEIGHTS_0") || attribute_ok(attributes, "WEIGHTS_0", 4, unorm_types, true))
+                                && indices_in_range();
+
+            if(direct){
+                // - 属性 location 与 Mesh::setup_mesh 一致, glTF 没有副切线, location 4 保持关闭
+                mesh.VAO_ = GlVertexArray::create();
+                glBindVertexArray(mesh.VAO_);
+                bind_attribute(primitive, "POSITION", 0, 3);
+                bind_attribute(primitive, "NORMAL", 1, 3);
+                bind_attribute(primitive, "TEXCOORD_0", 2, 2);
+                // - glTF 切线为 VEC4, w 为副切线方向(±1); 按 4 分量绑定, 读 vec3 的 shader 忽略 w
+                bind_attribute(primitive, "TANGENT", 3, 4);
+                bind_attribute(primitive, "JOINTS_0", 5, 4);
+                bind_attribute(primitive, "WEIGHTS_0", 6, 4);
+                glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, view_buffer(index_accessor->buffer_view));
+                glBindVertexArray(0);
+                glBindBuffer(GL_ARRAY_BUFFER, 0);
+                mesh.index_type_ = index_accessor->component_type;
+                mesh.index_count_ = index_accessor->count;
+                mesh.index_offset_ = index_accessor->byte_offset;
+                meshes_.push_back(std::move(mesh));
+                direct_count++;
+                continue;
+            }
+
+            // - 展开为 Vertex, 位置与法线变换到世界空间
+            std::vector<float> positions, normals, tex_coords, tangents;
+            auto attribute = [&attributes](const std::string& name){
+                auto it = attributes.find(name);
+                return it == attributes.end() ? -1 : it->second;
+            };
+            std::vector<unsigned int> indices;
+            if(!asset.read_floats(attribute("POSITION"), positions) || positions.size() % 3 != 0
+               || (primitive.indices >= 0 && !asset.read_indices(primitive.indices, indices))){
+                skipped_count++;
+                continue;
+            }
+            const size_t vertex_count = positions.size() / 3;
+            if(primitive.indices < 0){
+                indices.resize(vertex_count);
+                for(size_t i=0; i<vertex_count; i++)
+                    indices[i] = static_cast<unsigned int>(i);
+            }
+            if(primitive.mode == 5 || primitive.mode == 6){
+                // - TRIANGLE_STRIP / TRIANGLE_FAN 转为三角形列表
+                std::vector<unsigned int> list;
+                for(size_t i=2; i<indices.size(); i++){
+                    if(primitive.mode == 5)
+                        list.insert(list.end(), {indices[i - 2 + (i % 2)], indices[i - 1 - (i % 2)], indices[i]});
+                    else
+                        list.insert(list.end(), {indices[0], indices[i - 1], indices[i]});
+                }
+                indices.swap(list);
+            }else if(primitive.mode != kGltfTriangles){
+                std::cout << "WARN: glTF primitive mode " << primitive.mode << " not supported, skip" << std::endl;
+                skipped_count++;
+                continue;
+            }
+            indices.resize(indices.size() / 3 * 3);
+            if(std::any_of(indices.begin(), indices.end(), [vertex_count](unsigned int index){ return index >= vertex_count; })){
+                skipped_count++;
+                continue;
+            }
+            const bool has_normals = asset.read_floats(attribute("NORMAL"), normals) && normals.size() == vertex_count * 3;
+            const bool has_uv = asset.read_floats(attribute("TEXCOORD_0"), tex_coords) && tex_coords.size() == vertex_count * 2;
+            const bool has_tangents = asset.read_floats(attribute("TANGENT"), tangents) && tangents.size() == vertex_count * 4;
+
+            // - 法线矩阵取左上 3x3 的余子式矩阵, 只差一个 det 因子, 归一化后等价于逆转置
+            const std::array<float, 16>& m = instance.matrix;
+            const float a[9] = {m[0], m[1], m[2], m[4], m[5], m[6], m[8], m[9], m[10]};
+            float cof[9] = {a[4] * a[8] - a[5] * a[7], a[5] * a[6] - a[3] * a[8], a[3] * a[7] - a[4] * a[6],
+                            a[2] * a[7] - a[1] * a[8], a[0] * a[8] - a[2] * a[6], a[1] * a[6] - a[0] * a[7],
+                            a[1] * a[5] - a[2] * a[4], a[2] * a[3] - a[0] * a[5], a[0] * a[4] - a[1] * a[3]};
+            auto transform_point = [&m](const float* p){
+                return glm::vec3(m[0] * p[0] + m[4] * p[1] + m[8] * p[2] + m[12],
+                                 m[1] * p[0] + m[5] * p[1] + m[9] * p[2] + m[13],
+                                 m[2] * p[0] + m[6] * p[1] + m[10] * p[2] + m[14]);
+            };
+            auto transform_normal = [&cof](const float* n){
+                glm::vec3 out(cof[0] * n[0] + cof[3] * n[1] + cof[6] * n[2],
+                              cof[1] * n[0] + cof[4] * n[1] + cof[7] * n[2],
+                              cof[2] * n[0] + cof[5] * n[1] + cof[8] * n[2]);
+                const float length = std::sqrt(out.x * out.x + out.y * out.y + out.z * out.z);
+                return length > 0.0f ? out / length : out;
+            };
+            auto transform_direction = [&m](const float* d){
+                glm::vec3 out(m[0] * d[0] + m[4] * d[1] + m[8] * d[2],
+                              m[1] * d[0] + m[5] * d[1] + m[9] * d[2],
+                              m[2] * d[0] + m[6] * d[1] + m[10] * d[2]);
+                const float length = std::sqrt(out.x * out.x + out.y * out.y + out.z * out.z);
+                return length > 0.0f ? out / length : out;
+            };
+
+            mesh.vertices_.resize(vertex_count);
+            for(size_t i=0; i<vertex_count; i++){
+                Vertex& vertex = mesh.vertices_[i];
+                vertex.pos = transform_point(&positions[i * 3]);
+                if(has_normals)
+                    vertex.normal = transform_normal(&normals[i * 3]);
+                if(has_uv)
+                    vertex.tex_coord = glm::vec2(tex_coords[i * 2], tex_coords[i * 2 + 1]);
+                if(has_tangents){
+                    vertex.tangent = transform_direction(&tangents[i * 4]);
+                    const glm::vec3& n = vertex.normal;
+                    const glm::vec3& t = vertex.tangent;
+                    vertex.bitangent = glm::vec3(n.y * t.z - n.z * t.y, n.z * t.x - n.x * t.z, n.x * t.y - n.y * t.x) * tangents[i * 4 + 3];
+                }
+            }
+            if(!has_normals)
+                generate_smooth_normals(mesh.vertices_, indices);
+            mesh.indices_ = std::move(indices);
+            meshes_.push_back(std::move(mesh));
+            expanded_count++;
+        }
+    }
+
+    std::cout << "OUT: glTF primitives zero-copy " << direct_count << ", expanded " << expanded_count
+              << ", skipped " << skipped_count << ", buffer views uploaded " << view_buffers.size()
+              << " (" << uploaded_bytes / 1024.0 << " KB)" << std::endl;
+}
+
+void Model::load_ply(const std::string& ply_path){
+    PlyFile file;
+    PlyData data;
+    if(!file.open(ply_path) || !file.read(data))
+        exit(-1);
+    const size_t vertex_count = data.vertex_count;
+
+    Mesh mesh;
+    if(data.point_cloud() && load_textures_){
+        // - 每个属性一个缓冲, location 与 Mesh::setup_mesh 一致, 颜色放在 location 7 (归一化 RGBA8)
+        auto upload = [this](const void* bytes, const size_t size, const unsigned int location, const int components,
+                             const unsigned int type, const bool normalized){
+            if(size == 0)
+                return;
+            GlBuffer buffer = GlBuffer::create();
+            glBindBuffer(GL_ARRAY_BUFFER, buffer);
+            glBufferData(GL_ARRAY_BUFFER, size, bytes, GL_STATIC_DRAW);
+            glEnableVertexAttribArray(location);
+            glVertexAttribPointer(location, components, type, normalized ? GL_TRUE : GL_FALSE, 0, (void*)0);
+            gpu_buffers_.push_back(std::move(buffer));
+        };
+        mesh.VAO_ = GlVertexArray::create();
+        glBindVertexArray(mesh.VAO_);
+        upload(data.positions.data(), data.positions.size() * sizeof(float), 0, 3, GL_FLOAT, false);
+        upload(data.normals.data(), data.normals.size() * sizeof(float), 1, 3, GL_FLOAT, false);
+        upload(data.tex_coords.data(), data.tex_coords.size() * sizeof(float), 2, 2, GL_FLOAT, false);
+        upload(data.colors.data(), data.colors.size(), 7, 4, GL_UNSIGNED_BYTE, true);
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        mesh.draw_mode_ = GL_POINTS;
+        mesh.vertex_count_ = vertex_count;
+        std::cout << "OUT: PLY point cloud uploaded as SoA buffers, " << data.byte_size() / (1024.0 * 1024.0)
+                  << " MB (Vertex would need " << vertex_count * sizeof(Vertex) / (1024.0 * 1024.0) << " MB)" << std::endl;
+        meshes_.push_back(std::move(mesh));
+        return;
+    }
+
+    // - 按 kPlyChunkRows 分块并行展开为 Vertex, 完成后释放 SoA
+    mesh.vertices_.resize(vertex_count);
+    JobSystem::instance().parallel_for(0, vertex_count, kPlyChunkRows, [&mesh, &data](size_t begin, size_t end){
+        const float* positions = data.positions.data();
+        const float* normals = data.normals.empty() ? nullptr : data.normals.data();
+        const float* tex_coords = data.tex_coords.empty() ? nullptr : data.tex_coords.data();
+        for(size_t i=begin; i<end; i++){
+            Vertex& vertex = mesh.vertices_[i];
+            vertex.pos = glm::vec3(positions[i * 3], positions[i * 3 + 1], positions[i * 3 + 2]);
+            if(normals)
+                vertex.normal = glm::vec3(normals[i * 3], normals[i * 3 + 1], normals[i * 3 + 2]);
+            if(tex_coords)
+                vertex.tex_coord = glm::vec2(tex_coords[i * 2], tex_coords[i * 2 + 1]);
+        }
+    }, "ply_expand");
+    const bool has_normals = !data.normals.empty();
+    mesh.indices_ = std::move(data.indices);
+    data = PlyData();
+    if(mesh.indices_.empty())
+        mesh.draw_mode_ = GL_POINTS;
+    else if(!has_normals)
+        generate_smooth_normals(mesh.vertices_, mesh.indices_);
+    meshes_.push_back(std::move(mesh));
+}
+
+bool Model::build_texture_arrays(bool resize_mismatched){
+    if(!GLAD_GL_VERSION_4_3){
+        std::cout << "WARN: texture arrays need GL 4.3 (SSBO), use per-mesh textures" << std::endl;
+        release_image_cache();
+        return false;
+    }
+
+    // - 先只取尺寸分组, 进入数组的贴图才准备 RGBA8 数据
+    std::unordered_map<std::string, const Texture*> textures;
+    std::unordered_map<std::string, std::pair<int, int>> sizes;
+    std::vector<std::string> role_names[kTextureRoleCount];
+    for(size_t i=0; i<meshes_.size(); i++){
+        for(const Texture& texture : meshes_[i].textures_){
+            int role = texture_role_index(texture.type);
+            if(role < 0)
+                continue;
+            std::vector<std::string>& names = role_names[role];
+            if(std::find(names.begin(), names.end(), texture.name) == names.end())
+                names.push_back(texture.name);
+
+            if(sizes.find(texture.name) != sizes.end())
+                continue;
+            int width = 0, height = 0;
+            if(!texture_size(texture, width, height))
+                continue;
+            textures[texture.name] = &texture;
+            sizes[texture.name] = {width, height};
+        }
+    }
+
+    std::unordered_map<std::string, int> layer_of[kTextureRoleCount];
+    for(int role=0; role<kTextureRoleCount; role++){
+        // - 取该角色出现最多的尺寸作为数组尺寸
+        std::map<std::pair<int, int>, int> size_count;
+        for(const std::string& name : role_names[role]){
+            auto it = sizes.find(name);
+            if(it != sizes.end())
+                size_count[it->second]++;
+        }
+        if(size_count.empty())
+            continue;
+
+        std::pair<int, int> array_size = size_count.begin()->first;
+        for(const auto& item : size_count){
+            if(item.second > size_count[array_size])
+                array_size = item.first;
+        }
+
+        std::vector<std::string> members;
+        std::vector<const RgbaImage*> member_images;
+        for(const std::string& name : role_names[role]){
+            auto it = sizes.find(name);
+            if(it == sizes.end() || (it->second != array_size && !resize_mismatched))
+                continue;
+            const RgbaImage* image = cached_image(*textures.at(name));
+            if(!image)
+                continue;
+            members.push_back(name);
+            member_images.push_back(image);
+        }
+        if(members.empty())
+            continue;
+
+        texture_arrays_[role].reset(new TextureArray(array_size.first, array_size.second, members.size()));
+        for(size_t layer=0; layer<members.size(); layer++){
+            const RgbaImage& image = *member_images[layer];
+            if(image.width == array_size.first && image.height == array_size.second){
+                texture_arrays_[role]->upload_layer(layer, image.data.data());
+            }else{
+                std::vector<unsigned char> resized = resample_rgba8(image.data.data(), image.width, image.height,
+                                                                    array_size.first, array_size.second);
+                texture_arrays_[role]->upload_layer(layer, resized.data());
+            }
+            layer_of[role][members[layer]] = layer;
+        }
+        texture_arrays_[role]->generate_mipmap();
+
+        std::cout << "OUT: texture array " << LightTypeStr(static_cast<LightType>(role + 1)) << " "
+                  << array_size.first << "x" << array_size.second << ", layers " << members.size() << std::endl;
+    }
+
+    // - 每个 mesh 的贴图组合变为一个材质, 相同组合共享
+    materials_.clear();
+    size_t batched_count = 0;
+    for(size_t i=0; i<meshes_.size(); i++){
+        Mesh& mesh = meshes_[i];
+        MaterialLayers material;
+        bool batchable = true;
+        for(const Texture& texture : mesh.textures_){
+            int role = texture_role_index(texture.type);
+            if(role < 0){
+                // - 打包通道等数组 shader 不支持的贴图
+                batchable = false;
+                break;
+            }
+            if(material.layers[role] >= 0)
+                continue;
+            auto it = layer_of[role].find(texture.name);
+            if(it == layer_of[role].end()){
+                batchable = false;
+                break;
+            }
+            material.layers[role] = it->second;
+        }
+        if(!batchable){
+            mesh.material_index_ = -1;
+            continue;
+        }
+
+        int material_index = -1;
+        for(size_t j=0; j<materials_.size(); j++){
+            if(std::equal(material.layers, material.layers + kTextureRoleCount, materials_[j].layers)){
+                material_index = j;
+                break;
+            }
+        }
+        if(material_index < 0){
+            material_index = materials_.size();
+            materials_.push_back(material);
+        }
+        mesh.material_index_ = material_index;
+        batched_count++;
+    }
+
+    if(!material_ssbo_)
+        material_ssbo_ = GlBuffer::create();
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, material_ssbo_);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, materials_.size() * sizeof(MaterialLayers), materials_.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    // - 已进入数组的 mesh 不再引用 2D 纹理, 只剩它们引用的纹理随之释放, 避免显存中存两份
+    const size_t texture_count = loaded_texture.size();
+    for(Mesh& mesh : meshes_){
+        if(mesh.material_index_ < 0)
+            continue;
+        for(Texture& texture : mesh.textures_)
+            texture.id = 0;
+    }
+    release_unused_textures();
+    release_image_cache();
+
+    std::cout << "OUT: materials " << materials_.size() << ", batched meshes " << batched_count
+              << " / " << meshes_.size() << ", released 2D textures " << texture_count - loaded_texture.size() << std::endl;
+    return true;
+}
+
+size_t Model::pack_small_textures(int max_size, int atlas_size, int padding){
+    // - 同一组贴图(按角色)共享 atlas 中的同一位置, 因为一个 mesh 的所有贴图共用一套 UV
+    struct TextureSet{
+        Texture textures[kTextureRoleCount];
+        int width{0};
+        int height{0};
+        std::vector<size_t> meshes;
+        AtlasRect rect;
+        int page{-1};
+    };
+
+    std::vector<TextureSet> sets;
+    std::unordered_map<std::string, size_t> set_index;
+
+    bool rehydrated = false;
+    for(const Mesh& mesh : meshes_)
+        rehydrated = rehydrated || mesh.cpu_geometry_released();
+    // - 重映射后整段写回 VBO, 从 VBO 读回完整精度的顶点, 不用 COMPACT 的有损副本
+    ensure_cpu_geometry(true);
+
+    for(size_t i=0; i<meshes_.size(); i++){
+        const Mesh& mesh = meshes_[i];
+        // - 没有 CPU 端顶点的 mesh(glTF 零拷贝)无法重映射 UV
+        if(mesh.textures_.empty() || mesh.gpu_only())
+            continue;
+
+        TextureSet texture_set;
+        std::string key;
+        bool packable = true;
+        for(const Texture& texture : mesh.textures_){
+            int role = texture_role_index(texture.type);
+            if(role < 0 || !texture_set.textures[role].name.empty()
+               || texture.name.compare(0, kGeneratedTexturePrefix.size(), kGeneratedTexturePrefix) == 0){
+                packable = false;
+                break;
+            }
+            // - 只取尺寸, 大贴图不解码; 合成时才准备像素
+            int width = 0, height = 0;
+            if(!texture_size(texture, width, height) || width > max_size || height > max_size){
+                packable = false;
+                break;
+            }
+            texture_set.textures[role] = texture;
+            texture_set.width = std::max(texture_set.width, width);
+            texture_set.height = std::max(texture_set.height, height);
+        }
+        if(!packable)
+            continue;
+
+        // - atlas 中不能 REPEAT, UV 超出 [0, 1] 的 mesh 不合并
+        const float eps = 1e-4f;
+        for(const Vertex& vertex : mesh.vertices_){
+            if(vertex.tex_coord.x < -eps || vertex.tex_coord.x > 1.0f + eps ||
+               vertex.tex_coord.y < -eps || vertex.tex_coord.y > 1.0f + eps){
+                packable = false;
+                break;
+            }
+        }
+        if(!packable)
+            continue;
+
+        for(int role=0; role<kTextureRoleCount; role++)
+            key += texture_set.textures[role].name + "|";
+        auto it = set_index.find(key);
+        if(it == set_index.end()){
+            it = set_index.insert({key, sets.size()}).first;
+            sets.push_back(texture_set);
+        }
+        sets[it->second].meshes.push_back(i);
+    }
+
+    if(sets.size() < 2){
+        std::cout << "OUT: atlas skip, packable texture sets " << sets.size() << std::endl;
+        if(rehydrated)
+            apply_retention();
+        return 0;
+    }
+
+    // - 放置: 高的先放; 块尺寸对齐到 padding, 保证块原点在低层 mip 上仍对齐
+    const int align = std::max(padding, 1);
+    auto align_up = [align](int value){ return (value + align - 1) / align * align; };
+
+    std::vector<size_t> order(sets.size());
+    for(size_t i=0; i<order.size(); i++)
+        order[i] = i;
+    std::sort(order.begin(), order.end(), [&sets](size_t a, size_t b){ return sets[a].height > sets[b].height; });
+
+    std::vector<SkylinePacker> pages;
+    for(size_t index : order){
+        TextureSet& texture_set = sets[index];
+        const int block_width = align_up(texture_set.width + 2 * padding);
+        const int block_height = align_up(texture_set.height + 2 * padding);
+        for(size_t page=0; page<pages.size() && texture_set.page < 0; page++){
+            if(pages[page].insert(block_width, block_height, texture_set.rect))
+                texture_set.page = page;
+        }
+        if(texture_set.page < 0){
+            pages.emplace_back(atlas_size, atlas_size);
+            if(pages.back().insert(block_width, block_height, texture_set.rect)){
+                texture_set.page = pages.size() - 1;
+            }else{
+                pages.pop_back();
+            }
+        }
+    }
+
+    int max_level = 0;
+    while((2 << max_level) <= align)
+        max_level++;
+
+    // - 逐页逐角色合成并上传, 空白处保持为 0
+    std::vector<std::vector<Texture>> page_textures(pages.size(), std::vector<Texture>(kTextureRoleCount));
+    for(size_t page=0; page<pages.size(); page++){
+        const int page_width = pages[page].used_width();
+        const int page_height = pages[page].used_height();
+        size_t inner_area = 0;
+
+        for(int role=0; role<kTextureRoleCount; role++){
+            std::vector<unsigned char> pixels;
+            for(const TextureSet& texture_set : sets){
+                if(texture_set.page != static_cast<int>(page) || texture_set.textures[role].name.empty())
+                    continue;
+                if(pixels.empty())
+                    pixels.assign(static_cast<size_t>(page_width) * page_height * 4, 0);
+
+                const RgbaImage* cached = cached_image(texture_set.textures[role]);
+                if(!cached)
+                    continue;
+                const RgbaImage& image = *cached;
+                std::vector<unsigned char> resized;
+                const unsigned char* src = image.data.data();
+                if(image.width != texture_set.width || image.height != texture_set.height){
+                    resized = resample_rgba8(src, image.width, image.height, texture_set.width, texture_set.height);
+                    src = resized.data();
+                }
+
+                // - 含 padding 的整块, 越界部分取最近的边缘像素
+                const AtlasRect& rect = texture_set.rect;
+                for(int y=0; y<rect.height; y++){
+                    int src_y = std::min(std::max(y - padding, 0), texture_set.height - 1);
+                    for(int x=0; x<rect.width; x++){
+                        int src_x = std::min(std::max(x - padding, 0), texture_set.width - 1);
+                        const unsigned char* from = src + (static_cast<size_t>(src_y) * texture_set.width + src_x) * 4;
+                        unsigned char* to = &pixels[(static_cast<size_t>(rect.y + y) * page_width + rect.x + x) * 4];
+                        std::copy(from, from + 4, to);
+                    }
+                }
+            }
+            if(pixels.empty())
+                continue;
+
+            unsigned int texture_id;
+            glGenTextures(1, &texture_id);
+            glBindTexture(GL_TEXTURE_2D, texture_id);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, max_level);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, page_width, page_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+            glGenerateMipmap(GL_TEXTURE_2D);
+            glBindTexture(GL_TEXTURE_2D, 0);
+
+            TextureManager::instance().adopt(texture_id, pixels.size() * 4 / 3);
+            const std::string type = LightTypeStr(static_cast<LightType>(role + 1));
+            const std::string name = kGeneratedTexturePrefix + "atlas_" + type + "_" + std::to_string(page);
+            page_textures[page][role] = Texture(texture_id, type, name);
+            loaded_texture.insert({name, page_textures[page][role]});
+        }
+
+        size_t set_count = 0;
+        for(const TextureSet& texture_set : sets){
+            if(texture_set.page == static_cast<int>(page)){
+                inner_area += static_cast<size_t>(texture_set.width) * texture_set.height;
+                set_count++;
+            }
+        }
+        std::cout << "OUT: atlas page " << page << " " << page_width << "x" << page_height
+                  << ", texture sets " << set_count
+                  << ", occupancy " << static_cast<float>(inner_area) / (static_cast<float>(page_width) * page_height)
+                  << " (with padding " << pages[page].occupancy() * atlas_size * atlas_size / (static_cast<float>(page_width) * page_height)
+                  << ")" << std::endl;
+    }
+
+    // - 重映射 UV 并替换 mesh 的贴图
+    size_t packed_count = 0;
+    for(const TextureSet& texture_set : sets){
+        if(texture_set.page < 0)
+            continue;
+        const float page_width = pages[texture_set.page].used_width();
+        const float page_height = pages[texture_set.page].used_height();
+        const glm::vec2 offset((texture_set.rect.x + padding) / page_width, (texture_set.rect.y + padding) / page_height);
+        const glm::vec2 scale(texture_set.width / page_width, texture_set.height / page_height);
+
+        for(size_t mesh_index : texture_set.meshes){
+            Mesh& mesh = meshes_[mesh_index];
+            for(Vertex& vertex : mesh.vertices_){
+                vertex.tex_coord.x = offset.x + vertex.tex_coord.x * scale.x;
+                vertex.tex_coord.y = offset.y + vertex.tex_coord.y * scale.y;
+            }
+            mesh.update_vertex_buffer();
+            for(Texture& texture : mesh.textures_){
+                texture = page_textures[texture_set.page][texture_role_index(texture.type)];
+            }
+            packed_count++;
+        }
+    }
+
+    release_unused_textures();
+    if(rehydrated)
+        apply_retention();
+
+    std::cout << "OUT: atlas pages " << pages.size() << ", packed meshes " << packed_count << std::endl;
+    return packed_count;
+}
+
+size_t Model::pack_material_channels(int tolerance){
+    // - 单通道判断: 所有像素 RGB 近似相等
+    auto is_single_channel = [tolerance](const RgbaImage& image){
+        const size_t count = static_cast<size_t>(image.width) * image.height;
+        for(size_t i=0; i<count; i++){
+            const unsigned char* p = &image.data[i * 4];
+            if(std::abs(p[0] - p[1]) > tolerance || std::abs(p[1] - p[2]) > tolerance)
+                return false;
+        }
+        return true;
+    };
+
+    // - 像素来自共用的图像缓存, 之后的纹理数组不再重复准备
+    std::unordered_map<std::string, const RgbaImage*> images;
+    std::unordered_map<std::string, bool> single_channel;
+    auto load_candidate = [&](const Texture& texture){
+        auto it = single_channel.find(texture.name);
+        if(it != single_channel.end())
+            return it->second;
+        const RgbaImage* image = cached_image(texture);
+        bool single = image && is_single_channel(*image);
+        single_channel[texture.name] = single;
+        if(single)
+            images[texture.name] = image;
+        return single;
+    };
+
+    // - 相同的 (specular, height) 组合共用一张打包贴图
+    std::unordered_map<std::string, std::pair<Texture, ChannelRemap>> packed_textures;
+    size_t packed_count = 0;
+
+    for(size_t i=0; i<meshes_.size(); i++){
+        Mesh& mesh = meshes_[i];
+        const Texture* specular = nullptr;
+        const Texture* height = nullptr;
+        for(const Texture& texture : mesh.textures_){
+            if(!specular && texture.type == LightTypeStr(LightType::SPECULAR) && load_candidate(texture))
+                specular = &texture;
+            else if(!height && texture.type == LightTypeStr(LightType::HEIGHT) && load_candidate(texture))
+                height = &texture;
+        }
+        if(!specular && !height)
+            continue;
+
+        const std::string key = (specular ? specular->name : "") + "|" + (height ? height->name : "");
+        auto it = packed_textures.find(key);
+        if(it == packed_textures.end()){
+            // - 通道按出现顺序紧凑分配: specular -> R, height -> 下一个通道
+            std::vector<const RgbaImage*> sources;
+            ChannelRemap remap;
+            if(specular){
+                remap.specular = sources.size();
+                sources.push_back(images.at(specular->name));
+            }
+            if(height){
+                remap.height = sources.size();
+                sources.push_back(images.at(height->name));
+            }
+
+            int width = 0, height_px = 0;
+            for(const RgbaImage* image : sources){
+                width = std::max(width, image->width);
+                height_px = std::max(height_px, image->height);
+            }
+
+            const int channels = sources.size();
+            std::vector<unsigned char> pixels(static_cast<size_t>(width) * height_px * channels);
+            for(int c=0; c<channels; c++){
+                const RgbaImage& image = *sources[c];
+                std::vector<unsigned char> resized;
+                const unsigned char* src = image.data.data();
+                if(image.width != width || image.height != height_px){
+                    resized = resample_rgba8(src, image.width, image.height, width, height_px);
+                    src = resized.data();
+                }
+                const size_t count = static_cast<size_t>(width) * height_px;
+                for(size_t p=0; p<count; p++)
+                    pixels[p * channels + c] = src[p * 4];
+            }
+
+            const GLenum format = channels == 1 ? GL_RED : GL_RG;
+            const GLenum internal_format = channels == 1 ? GL_R8 : GL_RG8;
+            unsigned int texture_id;
+            glGenTextures(1, &texture_id);
+            glBindTexture(GL_TEXTURE_2D, texture_id);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+            glTexImage2D(GL_TEXTURE_2D, 0, internal_format, width, height_px, 0, format, GL_UNSIGNED_BYTE, pixels.data());
+            glGenerateMipmap(GL_TEXTURE_2D);
+            glBindTexture(GL_TEXTURE_2D, 0);
+
+            TextureManager::instance().adopt(texture_id, pixels.size() * 4 / 3);
+            const std::string name = kGeneratedTexturePrefix + "packed_" + std::to_string(packed_textures.size());
+            Texture texture(texture_id, LightTypeStr(LightType::PACKED), name);
+            loaded_texture.insert({name, texture});
+            it = packed_textures.insert({key, {texture, remap}}).first;
+
+            std::cout << "OUT: packed " << key << " -> " << name << ", channels " << channels << std::endl;
+        }
+
+        // - 去掉已打包的独立贴图, 换成打包贴图
+        const std::string specular_name = specular ? specular->name : "";
+        const std::string height_name = height ? height->name : "";
+        const ChannelRemap& remap = it->second.second;
+        std::vector<Texture> textures;
+        for(const Texture& texture : mesh.textures_){
+            bool packed = (remap.specular >= 0 && texture.type == LightTypeStr(LightType::SPECULAR) && texture.name == specular_name)
+                       || (remap.height >= 0 && texture.type == LightTypeStr(LightType::HEIGHT) && texture.name == height_name);
+            if(!packed)
+                textures.push_back(texture);
+        }
+        textures.push_back(it->second.first);
+        mesh.textures_ = std::move(textures);
+        mesh.channel_remap_ = remap;
+        packed_count++;
+    }
+
+    release_unused_textures();
+
+    std::cout << "OUT: channel packed meshes " << packed_count << " / " << meshes_.size() << std::endl;
+    return packed_count;
+}
+
+void Model::release_unused_textures(){
+    std::unordered_map<unsigned int, bool> in_use;
+    for(const Mesh& mesh : meshes_){
+        for(const Texture& texture : mesh.textures_)
+            in_use[texture.id] = true;
+    }
+    for(auto it = loaded_texture.begin(); it != loaded_texture.end();){
+        if(in_use.find(it->second.id) == in_use.end()){
+            TextureManager::instance().release(it->second.id);
+            it = loaded_texture.erase(it);
+        }else{
+            it++;
+        }
+    }
+}
+
+void Model::draw_batched(Shader& array_shader, Shader& fallback_shader){
+    const char* sampler_names[kTextureRoleCount] = {"tex_diffuse_array", "tex_specular_array",
+                                                    "tex_normal_array", "tex_height_array"};
+    // - 一次绑定全部纹理数组与材质表
+    array_shader.use();
+    for(int role=0; role<kTextureRoleCount; role++){
+        if(texture_arrays_[role])
+            texture_arrays_[role]->bind(role);
+        array_shader.set_int(sampler_names[role], role);
+    }
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, material_ssbo_);
+
+    bool has_fallback = false;
+    for(size_t i=0; i<meshes_.size(); i++){
+        if(meshes_[i].material_index_ < 0){
+            has_fallback = true;
+            continue;
+        }
+        array_shader.set_int("material_index", meshes_[i].material_index_);
+        meshes_[i].draw_elements();
+    }
+
+    if(!has_fallback)
+        return;
+    fallback_shader.use();
+    for(size_t i=0; i<meshes_.size(); i++){
+        if(meshes_[i].material_index_ < 0)
+            meshes_[i].draw(fallback_shader);
+    }
+}
+
+
+std::vector<std::string> Model::texture_paths(const aiScene* scene, const std::string& directory){
+    const aiTextureType tex_types[] = {aiTextureType_DIFFUSE, aiTextureType_SPECULAR, aiTextureType_NORMALS, aiTextureType_HEIGHT};
+    std::vector<std::string> paths;
+    std::unordered_map<std::string, bool> seen;
+    for(unsigned int i=0; i<scene->mNumMaterials; i++){
+        const aiMaterial* material = scene->mMaterials[i];
+        for(aiTextureType tex_type : tex_types){
+            for(unsigned int j=0; j<material->GetTextureCount(tex_type); j++){
+                aiString name;
+                material->GetTexture(tex_type, j, &name);
+                const std::string img_path = directory + "/" + name.C_Str();
+                if(seen.emplace(img_path, true).second)
+                    paths.push_back(img_path);
+            }
+        }
+    }
+    return paths;
+}
+
+std::vector<unsigned int> Model::prefetch_textures(const aiScene* scene){
+    std::vector<unsigned int> texture_ids;
+
+    const std::vector<std::string> paths = texture_paths(scene, directory_);
+    if(paths.empty())
+        return texture_ids;
+
+    const char* cold_env = std::getenv("TEST_OPENGL_COLD_CACHE");
+    const bool cold = cold_env && *cold_env;
+    if(cold){
+        for(const std::string& path : paths)
+            BatchReader::drop_cache(path);
+    }
+
+    struct Prefetched{
+        std::string path;
+        uint64_t hash{0};
+        std::shared_ptr<std::vector<unsigned char>> bytes;   // 登记时哈希命中要逐字节比较
+        DecodedImage image;
+        bool ok{false};
+    };
+    std::vector<Prefetched> results(paths.size());
+    size_t total_bytes = 0;
+
+    const auto start = std::chrono::steady_clock::now();
+    JobSystem& jobs = JobSystem::instance();
+    JobCounter decoding;
+    BatchReader reader;
+    // - 读完一个就提交解码任务, 读取与解码重叠
+    reader.read_all(paths, [&](ReadResult&& read){
+        if(!read.ok)
+            return;
+        total_bytes += read.bytes.size();
+        Prefetched* out = &results[read.index];
+        out->path = read.path;
+        auto bytes = std::make_shared<std::vector<unsigned char>>(std::move(read.bytes));
+        out->bytes = bytes;
+        jobs.run([out, bytes](){
+            out->hash = TextureManager::content_hash(bytes->data(), bytes->size());
+            if(TextureManager::instance().contains(out->hash, bytes->data(), bytes->size())){
+                out->ok = true;
+                return;
+            }
+            out->ok = decode_image(bytes->data(), bytes->size(), 0, out->image);
+        }, &decoding, "texture_decode");
+    });
+    const auto read_end = std::chrono::steady_clock::now();
+    jobs.wait(decoding);
+    const auto decode_end = std::chrono::steady_clock::now();
+
+    // - GL 上传留在当前线程; 同一批内容重复的图片由 acquire_decoded 按哈希去重
+    for(const Prefetched& item : results){
+        if(!item.ok)
+            continue;
+        unsigned int texture_id = TextureManager::instance().acquire_decoded(item.path, item.hash, item.bytes->data(),
+                                                                             item.bytes->size(), item.image);
+        if(texture_id != 0)
+            texture_ids.push_back(texture_id);
+    }
+    const auto end = std::chrono::steady_clock::now();
+
+    auto ms = [](std::chrono::steady_clock::time_point a, std::chrono::steady_clock::time_point b){
+        return std::chrono::duration<double, std::milli>(b - a).count();
+    };
+    std::cout << "OUT: texture prefetch " << paths.size() << " files, " << total_bytes / (1024.0 * 1024.0) << " MB"
+              << ", read " << ms(start, read_end) << " ms, decode " << ms(start, decode_end) << " ms"
+              << ", total " << ms(start, end) << " ms, " << (reader.uses_io_uring() ? "io_uring" : "job system")
+              << ", " << (cold ? "cold" : "warm") << std::endl;
+    return texture_ids;
+}
 
 void Model::process_node(const aiNode* node, const aiScene* scene){
+    PROFILE_ZONE("process_node");
     // - process multi meshs
     for(unsigned int i=0; i<node->mNumMeshes; i++){
         Mesh a_mesh = process_mesh(scene->mMeshes[node->mMeshes[i]], scene);
@@ -372,13 +1970,16 @@ std::vector<Texture> Model::process_material(const aiMaterial* material, aiTextu
         material->GetTexture(tex_type, i, &name);
         if(loaded_texture.find(name.C_Str()) == loaded_texture.end()){
             const std::string img_path = directory_ + "/" + name.C_Str();
-            unsigned int tex_id = load_texture(img_path);
+            unsigned int tex_id = load_textures_ ? load_texture(img_path) : 0;
             Texture texture(tex_id, type_name_map[tex_type], name.C_Str());
             textures.emplace_back(texture);
             
             loaded_texture.insert({name.C_Str(), texture});
         }else{
-            textures.emplace_back(loaded_texture[name.C_Str()]);
+            // - 同一图片可能以不同角色被引用, 角色取本次的
+            Texture texture = loaded_texture[name.C_Str()];
+            texture.type = type_name_map[tex_type];
+            textures.emplace_back(texture);
         }
         
     }
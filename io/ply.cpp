@@ -0,0 +1,471 @@
+#include "./ply.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <sstream>
+#include <iostream>
+#include <algorithm>
+
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "../core/job_system.h"
+
+namespace {
+
+PlyType parse_type(const std::string& name){
+    if(name == "char" || name == "int8") return PlyType::INT8;
+    if(name == "uchar" || name == "uint8") return PlyType::UINT8;
+    if(name == "short" || name == "int16") return PlyType::INT16;
+    if(name == "ushort" || name == "uint16") return PlyType::UINT16;
+    if(name == "int" || name == "int32") return PlyType::INT32;
+    if(name == "uint" || name == "uint32") return PlyType::UINT32;
+    if(name == "float" || name == "float32") return PlyType::FLOAT32;
+    if(name == "double" || name == "float64") return PlyType::FLOAT64;
+    return PlyType::INVALID;
+}
+
+bool is_float_type(const PlyType type){
+    return type == PlyType::FLOAT32 || type == PlyType::FLOAT64;
+}
+
+template<typename T>
+inline T load_value(const unsigned char* p, const bool swap){
+    T value;
+    if(!swap){
+        std::memcpy(&value, p, sizeof(T));
+        return value;
+    }
+    unsigned char bytes[sizeof(T)];
+    for(size_t i=0; i<sizeof(T); i++)
+        bytes[i] = p[sizeof(T) - 1 - i];
+    std::memcpy(&value, bytes, sizeof(T));
+    return value;
+}
+
+// - 列表长度与索引, 浮点类型或负数返回 -1
+int64_t load_integer(const unsigned char* p, const PlyType type, const bool swap){
+    switch(type){
+        case PlyType::INT8: return load_value<int8_t>(p, swap);
+        case PlyType::UINT8: return load_value<uint8_t>(p, swap);
+        case PlyType::INT16: return load_value<int16_t>(p, swap);
+        case PlyType::UINT16: return load_value<uint16_t>(p, swap);
+        case PlyType::INT32: return load_value<int32_t>(p, swap);
+        case PlyType::UINT32: return load_value<uint32_t>(p, swap);
+        default: return -1;
+    }
+}
+
+template<typename Out>
+inline Out convert_value(const float value);
+
+template<>
+inline float convert_value<float>(const float value){
+    return value;
+}
+
+template<>
+inline unsigned char convert_value<unsigned char>(const float value){
+    return static_cast<unsigned char>(std::min(std::max(value + 0.5f, 0.0f), 255.0f));
+}
+
+// - 一列属性: 从 rows 起每 stride 字节取一个值, 乘 scale 后写到 out, 步长 out_stride
+template<typename T, typename Out>
+void decode_column(const unsigned char* rows, const size_t stride, const size_t count, const bool swap,
+                   const float scale, Out* out, const size_t out_stride){
+    for(size_t i=0; i<count; i++)
+        out[i * out_stride] = convert_value<Out>(static_cast<float>(load_value<T>(rows + i * stride, swap)) * scale);
+}
+
+template<typename Out>
+void decode_property(const PlyType type, const unsigned char* rows, const size_t stride, const size_t count,
+                     const bool swap, const float scale, Out* out, const size_t out_stride){
+    switch(type){
+        case PlyType::INT8: decode_column<int8_t>(rows, stride, count, swap, scale, out, out_stride); break;
+        case PlyType::UINT8: decode_column<uint8_t>(rows, stride, count, swap, scale, out, out_stride); break;
+        case PlyType::INT16: decode_column<int16_t>(rows, stride, count, swap, scale, out, out_stride); break;
+        case PlyType::UINT16: decode_column<uint16_t>(rows, stride, count, swap, scale, out, out_stride); break;
+        case PlyType::INT32: decode_column<int32_t>(rows, stride, count, swap, scale, out, out_stride); break;
+        case PlyType::UINT32: decode_column<uint32_t>(rows, stride, count, swap, scale, out, out_stride); break;
+        case PlyType::FLOAT32: decode_column<float>(rows, stride, count, swap, scale, out, out_stride); break;
+        case PlyType::FLOAT64: decode_column<double>(rows, stride, count, swap, scale, out, out_stride); break;
+        default: break;
+    }
+}
+
+// - 颜色统一为 0-255: 浮点按 [0, 1], ushort 按 [0, 65535]
+float color_scale(const PlyType type){
+    if(is_float_type(type))
+        return 255.0f;
+    if(type == PlyType::UINT16)
+        return 255.0f / 65535.0f;
+    return 1.0f;
+}
+
+}
+
+
+const PlyProperty* PlyElement::find(const std::string& property_name) const{
+    for(const PlyProperty& property : properties)
+        if(property.name == property_name)
+            return &property;
+    return nullptr;
+}
+
+size_t PlyData::byte_size() const{
+    return positions.size() * sizeof(float) + normals.size() * sizeof(float) + tex_coords.size() * sizeof(float)
+           + colors.size() + indices.size() * sizeof(unsigned int);
+}
+
+size_t PlyFile::type_size(const PlyType type){
+    switch(type){
+        case PlyType::INT8:
+        case PlyType::UINT8: return 1;
+        case PlyType::INT16:
+        case PlyType::UINT16: return 2;
+        case PlyType::INT32:
+        case PlyType::UINT32:
+        case PlyType::FLOAT32: return 4;
+        case PlyType::FLOAT64: return 8;
+        default: return 0;
+    }
+}
+
+const PlyElement* PlyFile::element(const std::string& name) const{
+    for(const PlyElement& item : elements_)
+        if(item.name == name)
+            return &item;
+    return nullptr;
+}
+
+bool PlyFile::open(const std::string& path){
+    path_ = path;
+    elements_.clear();
+    file_ = Vfs::instance().map(path);
+    if(!file_.valid()){
+        std::cout << "ERROR: PLY open fail, path " << path << std::endl;
+        return false;
+    }
+    const char* text = reinterpret_cast<const char*>(file_.data());
+    const size_t size = file_.size();
+    if(size < 4 || std::memcmp(text, "ply", 3) != 0){
+        std::cout << "ERROR: PLY bad magic, path " << path << std::endl;
+        return false;
+    }
+
+    // - 头部为 ASCII, 以 "end_header" 加换行结束
+    const char* marker = "end_header";
+    const char* found = std::search(text, text + size, marker, marker + std::strlen(marker));
+    const char* header_end = found == text + size ? found : std::find(found, text + size, '\n');
+    if(header_end == text + size){
+        std::cout << "ERROR: PLY header not terminated, path " << path << std::endl;
+        return false;
+    }
+    size_t offset = static_cast<size_t>(header_end - text) + 1;
+
+    std::istringstream header(std::string(text, found));
+    std::string line;
+    bool has_format = false;
+    while(std::getline(header, line)){
+        if(!line.empty() && line.back() == '\r')
+            line.pop_back();
+        std::istringstream words(line);
+        std::string keyword;
+        words >> keyword;
+        if(keyword == "format"){
+            std::string format;
+            words >> format;
+            if(format == "binary_little_endian")
+                big_endian_ = false;
+            else if(format == "binary_big_endian")
+                big_endian_ = true;
+            else{
+                std::cout << "ERROR: PLY format " << format << " not supported, path " << path << std::endl;
+                return false;
+            }
+            has_format = true;
+        }else if(keyword == "element"){
+            PlyElement item;
+            words >> item.name >> item.count;
+            elements_.push_back(item);
+        }else if(keyword == "property"){
+            if(elements_.empty())
+                return false;
+            PlyProperty property;
+            std::string type;
+            words >> type;
+            if(type == "list"){
+                std::string count_type, item_type;
+                words >> count_type >> item_type;
+                property.is_list = true;
+                property.count_type = parse_type(count_type);
+                property.type = parse_type(item_type);
+                if(property.count_type == PlyType::INVALID || is_float_type(property.count_type))
+                    property.type = PlyType::INVALID;
+            }else{
+                property.type = parse_type(type);
+            }
+            words >> property.name;
+            if(property.type == PlyType::INVALID){
+                std::cout << "ERROR: PLY property type in \"" << line << "\", path " << path << std::endl;
+                return false;
+            }
+            elements_.back().properties.push_back(property);
+        }
+    }
+    if(!has_format){
+        std::cout << "ERROR: PLY missing format line, path " << path << std::endl;
+        return false;
+    }
+
+    // - 定长元素直接算出行长与偏移; 含列表的元素只有后面还有元素时才需要扫描
+    for(size_t e=0; e<elements_.size(); e++){
+        PlyElement& item = elements_[e];
+        size_t row_size = 0;
+        bool fixed = true;
+        for(PlyProperty& property : item.properties){
+            property.offset = row_size;
+            fixed = fixed && !property.is_list;
+            row_size += type_size(property.type);
+        }
+        item.row_size = fixed ? row_size : 0;
+        item.data_offset = offset;
+        if(fixed){
+            if(item.count > (size - offset) / std::max<size_t>(row_size, 1)){
+                std::cout << "ERROR: PLY element " << item.name << " truncated, path " << path << std::endl;
+                return false;
+            }
+            offset += item.count * row_size;
+        }else if(e + 1 < elements_.size()){
+            const size_t bytes = scan_element(item, offset);
+            if(bytes == 0 && item.count > 0){
+                std::cout << "ERROR: PLY element " << item.name << " truncated, path " << path << std::endl;
+                return false;
+            }
+            offset += bytes;
+        }
+    }
+    return true;
+}
+
+size_t PlyFile::scan_element(const PlyElement& item, size_t offset) const{
+    const size_t begin = offset;
+    const size_t size = file_.size();
+    const unsigned char* data = file_.data();
+    for(size_t row=0; row<item.count; row++){
+        for(const PlyProperty& property : item.properties){
+            if(!property.is_list){
+                offset += type_size(property.type);
+                continue;
+            }
+            const size_t count_size = type_size(property.count_type);
+            if(offset + count_size > size)
+                return 0;
+            const int64_t count = load_integer(data + offset, property.count_type, big_endian_);
+            if(count < 0)
+                return 0;
+            offset += count_size + static_cast<size_t>(count) * type_size(property.type);
+        }
+        if(offset > size)
+            return 0;
+    }
+    return offset - begin;
+}
+
+void PlyFile::release_pages(size_t begin, size_t end) const{
+    static const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    const uintptr_t base = reinterpret_cast<uintptr_t>(file_.data());
+    const uintptr_t first = (base + begin + page - 1) / page * page;
+    const uintptr_t last = (base + end) / page * page;
+    if(last > first)
+        madvise(reinterpret_cast<void*>(first), last - first, MADV_DONTNEED);
+}
+
+bool PlyFile::read(PlyData& data) const{
+    const auto start = std::chrono::steady_clock::now();
+    data = PlyData();
+    const PlyElement* vertex = element("vertex");
+    if(!vertex || !read_vertices(*vertex, data))
+        return false;
+    const PlyElement* face = element("face");
+    if(face && face->count > 0 && !read_faces(*face, data))
+        return false;
+    const auto end = std::chrono::steady_clock::now();
+    std::cout << "OUT: PLY " << data.vertex_count << " vertices, " << data.indices.size() / 3 << " triangles, "
+              << data.byte_size() / (1024.0 * 1024.0) << " MB SoA, decode "
+              << std::chrono::duration<double, std::milli>(end - start).count() << " ms" << std::endl;
+    return true;
+}
+
+bool PlyFile::read_vertices(const PlyElement& vertex, PlyData& data) const{
+    if(vertex.row_size == 0){
+        std::cout << "ERROR: PLY list property in vertex element not supported, path " << path_ << std::endl;
+        return false;
+    }
+    auto find_any = [&vertex](std::initializer_list<const char*> names) -> const PlyProperty*{
+        for(const char* name : names)
+            if(const PlyProperty* property = vertex.find(name))
+                return property;
+        return nullptr;
+    };
+    const PlyProperty* position[3] = {vertex.find("x"), vertex.find("y"), vertex.find("z")};
+    const PlyProperty* normal[3] = {vertex.find("nx"), vertex.find("ny"), vertex.find("nz")};
+    const PlyProperty* uv[2] = {find_any({"u", "s", "texture_u", "texture_s"}), find_any({"v", "t", "texture_v", "texture_t"})};
+    const PlyProperty* color[4] = {find_any({"red", "r", "diffuse_red"}), find_any({"green", "g", "diffuse_green"}),
+                                   find_any({"blue", "b", "diffuse_blue"}), find_any({"alpha", "a"})};
+    if(!position[0] || !position[1] || !position[2]){
+        std::cout << "ERROR: PLY vertex has no x / y / z, path " << path_ << std::endl;
+        return false;
+    }
+    const bool has_normals = normal[0] && normal[1] && normal[2];
+    const bool has_uv = uv[0] && uv[1];
+    const bool has_colors = color[0] && color[1] && color[2];
+
+    const size_t count = vertex.count;
+    data.vertex_count = count;
+    data.positions.resize(count * 3);
+    if(has_normals)
+        data.normals.resize(count * 3);
+    if(has_uv)
+        data.tex_coords.resize(count * 2);
+    if(has_colors)
+        data.colors.resize(count * 4);
+
+    const unsigned char* base = file_.data() + vertex.data_offset;
+    const size_t stride = vertex.row_size;
+    const bool swap = big_endian_;
+    JobSystem::instance().parallel_for(0, count, kPlyChunkRows, [&](size_t begin, size_t end){
+        const size_t rows = end - begin;
+        const unsigned char* chunk = base + begin * stride;
+        for(int k=0; k<3; k++)
+            decode_property(position[k]->type, chunk + position[k]->offset, stride, rows, swap, 1.0f,
+                            &data.positions[begin * 3 + k], 3);
+        if(has_normals)
+            for(int k=0; k<3; k++)
+                decode_property(normal[k]->type, chunk + normal[k]->offset, stride, rows, swap, 1.0f,
+                                &data.normals[begin * 3 + k], 3);
+        if(has_uv)
+            for(int k=0; k<2; k++)
+                decode_property(uv[k]->type, chunk + uv[k]->offset, stride, rows, swap, 1.0f,
+                                &data.tex_coords[begin * 2 + k], 2);
+        if(has_colors){
+            for(int k=0; k<4; k++){
+                unsigned char* out = &data.colors[begin * 4 + k];
+                if(color[k])
+                    decode_property(color[k]->type, chunk + color[k]->offset, stride, rows, swap,
+                                    color_scale(color[k]->type), out, 4);
+                else
+                    for(size_t i=0; i<rows; i++)
+                        out[i * 4] = 255;
+            }
+        }
+        release_pages(vertex.data_offset + begin * stride, vertex.data_offset + end * stride);
+    }, "ply_vertices");
+    return true;
+}
+
+bool PlyFile::read_faces(const PlyElement& face, PlyData& data) const{
+    const PlyProperty* list = face.find("vertex_indices");
+    if(!list)
+        list = face.find("vertex_index");
+    if(!list || !list->is_list){
+        std::cout << "WARN: PLY face has no vertex_indices, load as point cloud, path " << path_ << std::endl;
+        return true;
+    }
+
+    const unsigned char* data_ptr = file_.data();
+    const size_t size = file_.size();
+    const size_t count_size = type_size(list->count_type);
+    const size_t index_size = type_size(list->type);
+    const size_t vertex_count = data.vertex_count;
+    const bool swap = big_endian_;
+
+    // - 快速路径: 除索引列表外都是定长属性, 且每个面都是三角形时行长固定, 可按块并行解码
+    size_t triangle_row = 0, list_offset = 0;
+    bool other_lists = false;
+    for(const PlyProperty& property : face.properties){
+        if(&property == list){
+            list_offset = triangle_row;
+            triangle_row += count_size + 3 * index_size;
+        }else{
+            other_lists = other_lists || property.is_list;
+            triangle_row += type_size(property.type);
+        }
+    }
+    const size_t begin_offset = face.data_offset;
+    if(!other_lists && face.count <= (size - begin_offset) / triangle_row){
+        data.indices.resize(face.count * 3);
+        std::atomic<bool> not_triangles{false};
+        std::atomic<bool> out_of_range{false};
+        JobSystem::instance().parallel_for(0, face.count, kPlyChunkRows, [&](size_t begin, size_t end){
+            if(not_triangles)
+                return;
+            const size_t rows = end - begin;
+            const unsigned char* row = data_ptr + begin_offset + begin * triangle_row + list_offset;
+            unsigned int* out = &data.indices[begin * 3];
+            for(size_t i=0; i<rows; i++, row+=triangle_row){
+                if(load_integer(row, list->count_type, swap) != 3){
+                    not_triangles = true;
+                    return;
+                }
+                for(int k=0; k<3; k++){
+                    const int64_t index = load_integer(row + count_size + k * index_size, list->type, swap);
+                    if(index < 0 || static_cast<size_t>(index) >= vertex_count){
+                        out_of_range = true;
+                        return;
+                    }
+                    out[i * 3 + k] = static_cast<unsigned int>(index);
+                }
+            }
+            // - 中途退出的块不释放: 通用路径还要重新读这些页
+            release_pages(begin_offset + begin * triangle_row, begin_offset + end * triangle_row);
+        }, "ply_faces");
+        // - 出现非三角形时, 之后的块按三角形行长读到的是错位的字节, 越界只在全是三角形时才可信
+        if(!not_triangles){
+            if(out_of_range){
+                std::cout << "ERROR: PLY face index out of range, path " << path_ << std::endl;
+                return false;
+            }
+            return true;
+        }
+    }
+
+    // - 通用路径: 逐行解析, 多边形按扇形拆成三角形
+    data.indices.clear();
+    data.indices.reserve(face.count * 3);
+    size_t offset = begin_offset;
+    std::vector<unsigned int> polygon;
+    for(size_t row=0; row<face.count; row++){
+        for(const PlyProperty& property : face.properties){
+            if(!property.is_list){
+                offset += type_size(property.type);
+                continue;
+            }
+            const size_t item_size = type_size(property.type);
+            const size_t length_size = type_size(property.count_type);
+            const int64_t n = offset + length_size <= size ? load_integer(data_ptr + offset, property.count_type, swap) : -1;
+            if(n < 0 || offset + length_size + static_cast<size_t>(n) * item_size > size){
+                std::cout << "ERROR: PLY face element truncated, path " << path_ << std::endl;
+                return false;
+            }
+            offset += length_size;
+            if(&property == list){
+                polygon.resize(static_cast<size_t>(n));
+                for(int64_t k=0; k<n; k++){
+                    const int64_t index = load_integer(data_ptr + offset + k * item_size, property.type, swap);
+                    if(index < 0 || static_cast<size_t>(index) >= vertex_count){
+                        std::cout << "ERROR: PLY face index out of range, path " << path_ << std::endl;
+                        return false;
+                    }
+                    polygon[k] = static_cast<unsigned int>(index);
+                }
+                for(size_t k=2; k<polygon.size(); k++)
+                    data.indices.insert(data.indices.end(), {polygon[0], polygon[k - 1], polygon[k]});
+            }
+            offset += static_cast<size_t>(n) * item_size;
+        }
+    }
+    release_pages(begin_offset, offset);
+    return true;
+}
@@ -0,0 +1,95 @@
+#ifndef OPENGL_IO_PLY_H_
+#define OPENGL_IO_PLY_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "./vfs.h"
+
+enum class PlyType : uint8_t{
+    INVALID = 0,
+    INT8,
+    UINT8,
+    INT16,
+    UINT16,
+    INT32,
+    UINT32,
+    FLOAT32,
+    FLOAT64
+};
+
+// - 每个并行任务解码的行数
+const size_t kPlyChunkRows = 1 << 16;
+
+struct PlyProperty{
+    std::string name;
+    PlyType type{PlyType::INVALID};       // 列表时为元素类型
+    bool is_list{false};
+    PlyType count_type{PlyType::INVALID}; // 列表长度的类型
+    size_t offset{0};                     // 定长元素中相对行首的字节偏移
+};
+
+struct PlyElement{
+    std::string name;
+    size_t count{0};
+    std::vector<PlyProperty> properties;
+    size_t row_size{0};                   // 0 表示含列表, 行长不定
+    size_t data_offset{0};                // 数据在文件中的起始位置
+
+    const PlyProperty* find(const std::string& name) const;
+};
+
+/**
+ * 紧凑的 SoA 几何, 每个属性一个数组, 文件中没有的属性为空
+ * 每个顶点 12 ~ 36 字节, 而展开为 Vertex 需要 88 字节
+ */
+struct PlyData{
+    size_t vertex_count{0};
+    std::vector<float> positions;         // xyz
+    std::vector<float> normals;           // xyz
+    std::vector<float> tex_coords;        // uv
+    std::vector<unsigned char> colors;    // rgba8
+    std::vector<unsigned int> indices;    // 三角形, 多边形按扇形拆分
+
+    bool point_cloud() const { return indices.empty(); }
+    size_t byte_size() const;
+};
+
+/**
+ * 二进制 PLY (binary_little_endian / binary_big_endian) 读取
+ * - 文件经 Vfs mmap, 只解析头部; 属性按列从映射内存直接解码到 PlyData
+ * - vertex / face 按 kPlyChunkRows 分块由 JobSystem 并行解码, 解码完的页随即 MADV_DONTNEED, 常驻内存不随文件增长
+ * - 没有 face 元素时为点云
+ */
+class PlyFile{
+public:
+    bool open(const std::string& path);
+
+    const std::vector<PlyElement>& elements() const { return elements_; }
+
+    const PlyElement* element(const std::string& name) const;
+
+    bool read(PlyData& data) const;
+
+    static size_t type_size(const PlyType type);
+
+private:
+    bool read_vertices(const PlyElement& vertex, PlyData& data) const;
+
+    bool read_faces(const PlyElement& face, PlyData& data) const;
+
+    // - 列表行长不定时逐行扫描, 返回元素数据的总字节数, 越界返回 0
+    size_t scan_element(const PlyElement& element, size_t offset) const;
+
+    // - 把已解码完的映射页还给系统
+    void release_pages(size_t begin, size_t end) const;
+
+private:
+    std::string path_;
+    MappedFile file_;
+    bool big_endian_{false};
+    std::vector<PlyElement> elements_;
+};
+
+#endif
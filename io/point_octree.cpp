@@ -0,0 +1,218 @@
+#include "./point_octree.h"
+
+#include <cmath>
+#include <deque>
+#include <random>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+
+#include <unistd.h>
+#include <sys/mman.h>
+
+namespace {
+
+// - 代表点网格采样的分辨率, 每个格子最多取一个点
+const uint32_t kSampleGrid = 128;
+
+struct BuildTask{
+    int32_t node;
+    size_t begin;
+    size_t end;
+};
+
+}
+
+
+bool build_point_octree(const PlyData& cloud, const std::string& out_path, uint32_t points_per_node){
+    const size_t count = cloud.vertex_count;
+    if(count == 0 || points_per_node == 0){
+        std::cout << "ERROR: point octree needs a non-empty cloud" << std::endl;
+        return false;
+    }
+
+    std::vector<PointRecord> points(count);
+    float lo[3] = {cloud.positions[0], cloud.positions[1], cloud.positions[2]};
+    float hi[3] = {lo[0], lo[1], lo[2]};
+    for(size_t i=0; i<count; i++){
+        for(int k=0; k<3; k++){
+            const float v = cloud.positions[i * 3 + k];
+            points[i].pos[k] = v;
+            lo[k] = std::min(lo[k], v);
+            hi[k] = std::max(hi[k], v);
+        }
+        for(int k=0; k<4; k++)
+            points[i].color[k] = cloud.colors.empty() ? 255 : cloud.colors[i * 4 + k];
+    }
+    // - 打乱后每个格子取到的第一个点即为随机代表点, 父节点的子集不会偏向扫描顺序
+    std::shuffle(points.begin(), points.end(), std::mt19937(20240531u));
+
+    PointOctreeHeader header;
+    std::memcpy(header.magic, kPointOctreeMagic, sizeof(header.magic));
+    header.version = kPointOctreeVersion;
+    header.points_per_node = points_per_node;
+    header.size = std::max(std::max(hi[0] - lo[0], hi[1] - lo[1]), hi[2] - lo[2]) * 1.0001f + 1e-6f;
+    for(int k=0; k<3; k++)
+        header.min[k] = lo[k];
+
+    std::vector<PointOctreeNode> nodes;
+    std::vector<std::pair<size_t, size_t>> ranges;   // 各节点自身的点在 points 中的区间
+    auto add_node = [&nodes, &ranges](const float min[3], const float size, const uint32_t level){
+        PointOctreeNode node;
+        std::memcpy(node.min, min, sizeof(node.min));
+        node.size = size;
+        node.first_point = 0;
+        node.point_count = 0;
+        node.level = level;
+        std::fill(node.children, node.children + 8, -1);
+        nodes.push_back(node);
+        ranges.emplace_back(0, 0);
+        return static_cast<int32_t>(nodes.size() - 1);
+    };
+
+    std::vector<uint32_t> cell_stamp(static_cast<size_t>(kSampleGrid) * kSampleGrid * kSampleGrid, 0);
+    uint32_t stamp = 0;
+    size_t dropped = 0;
+    std::deque<BuildTask> tasks;
+    tasks.push_back({add_node(header.min, header.size, 0), 0, count});
+    while(!tasks.empty()){
+        const BuildTask task = tasks.front();
+        tasks.pop_front();
+        const PointOctreeNode node = nodes[task.node];
+        const size_t n = task.end - task.begin;
+
+        if(n <= points_per_node || node.level >= kPointOctreeMaxLevel){
+            const size_t kept = std::min<size_t>(n, points_per_node);
+            dropped += n - kept;
+            ranges[task.node] = {task.begin, task.begin + kept};
+            continue;
+        }
+
+        // - 网格采样选出代表点, 移到区间前部
+        stamp++;
+        const float cell = node.size / kSampleGrid;
+        size_t selected = task.begin;
+        for(size_t i=task.begin; i<task.end && selected - task.begin < points_per_node; i++){
+            uint32_t index[3];
+            for(int k=0; k<3; k++){
+                const float t = (points[i].pos[k] - node.min[k]) / cell;
+                index[k] = std::min(kSampleGrid - 1, static_cast<uint32_t>(std::max(t, 0.0f)));
+            }
+            const size_t key = (static_cast<size_t>(index[2]) * kSampleGrid + index[1]) * kSampleGrid + index[0];
+            if(cell_stamp[key] == stamp)
+                continue;
+            cell_stamp[key] = stamp;
+            std::swap(points[selected++], points[i]);
+        }
+        ranges[task.node] = {task.begin, selected};
+
+        // - 其余的点按 x / y / z 三次划分到八个子节点
+        const float half = node.size * 0.5f;
+        const float mid[3] = {node.min[0] + half, node.min[1] + half, node.min[2] + half};
+        size_t bounds[9];
+        bounds[0] = selected;
+        bounds[8] = task.end;
+        auto split = [&points, &mid](size_t begin, size_t end, int axis){
+            return static_cast<size_t>(std::partition(points.begin() + begin, points.begin() + end,
+                        [&mid, axis](const PointRecord& p){ return p.pos[axis] < mid[axis]; }) - points.begin());
+        };
+        bounds[4] = split(bounds[0], bounds[8], 0);
+        for(int x=0; x<2; x++){
+            bounds[x * 4 + 2] = split(bounds[x * 4], bounds[x * 4 + 4], 1);
+            for(int y=0; y<2; y++)
+                bounds[x * 4 + y * 2 + 1] = split(bounds[x * 4 + y * 2], bounds[x * 4 + y * 2 + 2], 2);
+        }
+        // - bounds 按 x 高位排列, 子节点下标为 x | y << 1 | z << 2
+        for(int x=0; x<2; x++){
+            for(int y=0; y<2; y++){
+                for(int z=0; z<2; z++){
+                    const int slot = x * 4 + y * 2 + z;
+                    if(bounds[slot] == bounds[slot + 1])
+                        continue;
+                    const float child_min[3] = {node.min[0] + x * half, node.min[1] + y * half, node.min[2] + z * half};
+                    const int32_t child = add_node(child_min, half, node.level + 1);
+                    nodes[task.node].children[x | (y << 1) | (z << 2)] = child;
+                    tasks.push_back({child, bounds[slot], bounds[slot + 1]});
+                }
+            }
+        }
+    }
+
+    // - 按节点顺序写出各自的点, 截断的点不写入
+    uint64_t written = 0;
+    for(size_t i=0; i<nodes.size(); i++){
+        nodes[i].first_point = written;
+        nodes[i].point_count = static_cast<uint32_t>(ranges[i].second - ranges[i].first);
+        written += nodes[i].point_count;
+    }
+    header.node_count = static_cast<uint32_t>(nodes.size());
+    header.point_count = written;
+
+    std::ofstream out(out_path, std::ios::binary);
+    if(!out){
+        std::cout << "ERROR: point octree write fail, path " << out_path << std::endl;
+        return false;
+    }
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(nodes.data()), nodes.size() * sizeof(PointOctreeNode));
+    for(size_t i=0; i<nodes.size(); i++)
+        out.write(reinterpret_cast<const char*>(points.data() + ranges[i].first), nodes[i].point_count * sizeof(PointRecord));
+    if(!out){
+        std::cout << "ERROR: point octree write fail, path " << out_path << std::endl;
+        return false;
+    }
+
+    uint32_t depth = 0;
+    for(const PointOctreeNode& node : nodes)
+        depth = std::max(depth, node.level + 1);
+    std::cout << "OUT: point octree " << nodes.size() << " nodes, depth " << depth << ", " << written << " points";
+    if(dropped)
+        std::cout << " (" << dropped << " dropped at max level)";
+    std::cout << std::endl;
+    return true;
+}
+
+
+bool PointOctree::open(const std::string& path){
+    nodes_.clear();
+    file_ = Vfs::instance().map(path);
+    if(!file_.valid() || file_.size() < sizeof(header_)){
+        std::cout << "ERROR: point octree open fail, path " << path << std::endl;
+        return false;
+    }
+    std::memcpy(&header_, file_.data(), sizeof(header_));
+    if(std::memcmp(header_.magic, kPointOctreeMagic, sizeof(header_.magic)) != 0 || header_.version != kPointOctreeVersion){
+        std::cout << "ERROR: point octree bad header, path " << path << std::endl;
+        return false;
+    }
+    const size_t table_size = static_cast<size_t>(header_.node_count) * sizeof(PointOctreeNode);
+    points_offset_ = sizeof(header_) + table_size;
+    if(file_.size() < points_offset_ || (file_.size() - points_offset_) / sizeof(PointRecord) < header_.point_count){
+        std::cout << "ERROR: point octree truncated, path " << path << std::endl;
+        return false;
+    }
+    nodes_.resize(header_.node_count);
+    std::memcpy(nodes_.data(), file_.data() + sizeof(header_), table_size);
+    for(const PointOctreeNode& node : nodes_){
+        if(node.first_point + node.point_count > header_.point_count || node.point_count > header_.points_per_node){
+            std::cout << "ERROR: point octree bad node, path " << path << std::endl;
+            nodes_.clear();
+            return false;
+        }
+    }
+    return true;
+}
+
+const PointRecord* PointOctree::points(const PointOctreeNode& node) const{
+    return reinterpret_cast<const PointRecord*>(file_.data() + points_offset_) + node.first_point;
+}
+
+void PointOctree::release(const PointOctreeNode& node) const{
+    static const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    const uintptr_t begin = reinterpret_cast<uintptr_t>(points(node));
+    const uintptr_t first = (begin + page - 1) / page * page;
+    const uintptr_t last = (begin + node.point_count * sizeof(PointRecord)) / page * page;
+    if(last > first)
+        madvise(reinterpret_cast<void*>(first), last - first, MADV_DONTNEED);
+}
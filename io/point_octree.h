@@ -0,0 +1,79 @@
+#ifndef OPENGL_IO_POINT_OCTREE_H_
+#define OPENGL_IO_POINT_OCTREE_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "./vfs.h"
+#include "./ply.h"
+
+/**
+ * 点云八叉树文件格式(小端)
+ *   PointOctreeHeader
+ *   node_count 个 PointOctreeNode  广度优先, 0 为根
+ *   point_count 个 PointRecord     每个节点的点连续存放
+ * 每个节点保存落在其中的点的代表子集(网格采样, 不超过 points_per_node), 子集之外的点下放到子节点,
+ * 父节点与全部祖先一起绘制才是完整精度, 因此越粗的层级点越少
+ */
+const char kPointOctreeMagic[4] = {'T', 'O', 'P', 'C'};
+const uint32_t kPointOctreeVersion = 1;
+const uint32_t kPointOctreeDefaultNodePoints = 16384;
+const uint32_t kPointOctreeMaxLevel = 24;
+
+struct PointRecord{
+    float pos[3];
+    unsigned char color[4];
+};
+
+struct PointOctreeHeader{
+    char magic[4];
+    uint32_t version;
+    uint32_t node_count;
+    uint32_t points_per_node;
+    uint64_t point_count;
+    float min[3];              // 根节点立方体
+    float size;
+};
+
+struct PointOctreeNode{
+    float min[3];
+    float size;
+    uint64_t first_point;      // 在点数组中的序号
+    uint32_t point_count;
+    uint32_t level;
+    int32_t children[8];       // -1 表示没有该子节点, 下标按 x | y << 1 | z << 2
+};
+
+/**
+ * 离线构建: 点数组整体在内存中按八分体原地划分, 每个节点的点在数组中天然连续
+ *@ points_per_node: 节点点数上限, 同时是渲染端 GPU 槽位的大小
+ *@ return: 写入是否成功
+ */
+bool build_point_octree(const PlyData& cloud, const std::string& out_path,
+                        uint32_t points_per_node = kPointOctreeDefaultNodePoints);
+
+/**
+ * 运行时读取: 只解析头部与节点表, 点数据留在 mmap 中按需读取
+ */
+class PointOctree{
+public:
+    bool open(const std::string& path);
+
+    const PointOctreeHeader& header() const { return header_; }
+    const std::vector<PointOctreeNode>& nodes() const { return nodes_; }
+
+    // - 节点的点在映射内存中的位置, 读取会触发缺页 IO, 应在加载线程调用
+    const PointRecord* points(const PointOctreeNode& node) const;
+
+    // - 节点数据已拷走, 把对应的页还给系统, 常驻内存不随文件大小增长
+    void release(const PointOctreeNode& node) const;
+
+private:
+    MappedFile file_;
+    PointOctreeHeader header_;
+    std::vector<PointOctreeNode> nodes_;
+    size_t points_offset_{0};
+};
+
+#endif
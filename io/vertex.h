@@ -0,0 +1,19 @@
+#ifndef OPENGL_IO_VERTEX_H_
+#define OPENGL_IO_VERTEX_H_
+
+#include <glm/glm.hpp>
+
+#define MAX_BONE_INFLUENCE 4
+
+struct Vertex{
+    glm::vec3 pos{0.0f, 0.0f, 0.0f};
+    glm::vec3 normal{0.0f, 0.0f, 0.0f};
+    glm::vec2 tex_coord{0.0f, 0.0f};
+    glm::vec3 tangent{0.0f, 0.0f, 0.0f};
+    glm::vec3 bitangent{0.0f, 0.0f, 0.0f};
+    int bone_ids[MAX_BONE_INFLUENCE]{};
+    float weights[MAX_BONE_INFLUENCE]{};
+    
+};
+
+#endif
@@ -0,0 +1,127 @@
+#include "./vfs.h"
+
+#include <cstring>
+#include <iostream>
+#include <algorithm>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+MappedFile::~MappedFile(){
+    reset();
+}
+
+MappedFile::MappedFile(MappedFile&& other):
+    data_(other.data_), size_(other.size_), valid_(other.valid_){
+    other.data_ = nullptr;
+    other.size_ = 0;
+    other.valid_ = false;
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other){
+    if(this != &other){
+        reset();
+        data_ = other.data_;
+        size_ = other.size_;
+        valid_ = other.valid_;
+        other.data_ = nullptr;
+        other.size_ = 0;
+        other.valid_ = false;
+    }
+    return *this;
+}
+
+void MappedFile::reset(){
+    if(data_)
+        munmap(const_cast<unsigned char*>(data_), size_);
+    data_ = nullptr;
+    size_ = 0;
+    valid_ = false;
+}
+
+MappedFile MappedFile::open(const std::string& real_path){
+    MappedFile file;
+    int fd = ::open(real_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if(fd < 0)
+        return file;
+
+    struct stat file_stat;
+    if(fstat(fd, &file_stat) != 0 || !S_ISREG(file_stat.st_mode)){
+        close(fd);
+        return file;
+    }
+
+    file.size_ = file_stat.st_size;
+    if(file.size_ > 0){
+        void* addr = mmap(nullptr, file.size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(addr == MAP_FAILED){
+            close(fd);
+            file.size_ = 0;
+            return file;
+        }
+        // - 资源基本是顺序整读
+        madvise(addr, file.size_, MADV_SEQUENTIAL);
+        file.data_ = static_cast<const unsigned char*>(addr);
+    }
+    close(fd);
+    file.valid_ = true;
+    return file;
+}
+
+
+Vfs& Vfs::instance(){
+    static Vfs vfs;
+    return vfs;
+}
+
+std::string Vfs::normalize(const std::string& path){
+    std::string out = path;
+    while(out.size() > 1 && out.back() == '/')
+        out.pop_back();
+    // - "./data" 与 "data" 视为相同
+    while(out.compare(0, 2, "./") == 0)
+        out.erase(0, 2);
+    return out == "/" || out == "." ? "" : out;
+}
+
+void Vfs::mount(const std::string& mount_point, const std::string& real_dir){
+    std::lock_guard<std::mutex> lock(mutex_);
+    MountPoint mount{normalize(mount_point), normalize(real_dir)};
+    mounts_.erase(std::remove_if(mounts_.begin(), mounts_.end(),
+                    [&mount](const MountPoint& item){ return item.prefix == mount.prefix; }), mounts_.end());
+    mounts_.push_back(mount);
+    std::sort(mounts_.begin(), mounts_.end(),
+              [](const MountPoint& a, const MountPoint& b){ return a.prefix.size() > b.prefix.size(); });
+    std::cout << " - mount " << (mount.prefix.empty() ? "/" : mount.prefix) << " -> " << mount.real_dir << std::endl;
+}
+
+std::string Vfs::resolve(const std::string& path) const{
+    const std::string virtual_path = normalize(path);
+    std::lock_guard<std::mutex> lock(mutex_);
+    for(const MountPoint& mount : mounts_){
+        if(mount.prefix.empty()){
+            // - 根挂载只接管相对路径
+            if(!virtual_path.empty() && virtual_path[0] != '/')
+                return mount.real_dir + "/" + virtual_path;
+            continue;
+        }
+        if(virtual_path == mount.prefix)
+            return mount.real_dir;
+        if(virtual_path.size() > mount.prefix.size() && virtual_path.compare(0, mount.prefix.size(), mount.prefix) == 0
+           && virtual_path[mount.prefix.size()] == '/'){
+            return mount.real_dir + virtual_path.substr(mount.prefix.size());
+        }
+    }
+    return path;
+}
+
+bool Vfs::exists(const std::string& path) const{
+    struct stat file_stat;
+    return stat(resolve(path).c_str(), &file_stat) == 0;
+}
+
+MappedFile Vfs::map(const std::string& path) const{
+    return MappedFile::open(resolve(path));
+}
@@ -0,0 +1,71 @@
+#ifndef OPENGL_IO_VFS_H_
+#define OPENGL_IO_VFS_H_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <mutex>
+
+/**
+ * 只读 mmap 文件, 只可移动
+ * 数据直接来自 page cache, 不经过 ifstream / stdio 的缓冲拷贝
+ */
+class MappedFile{
+public:
+    MappedFile(){}
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other);
+    MappedFile& operator=(MappedFile&& other);
+
+    static MappedFile open(const std::string& real_path);
+
+    const unsigned char* data() const { return data_; }
+    size_t size() const { return size_; }
+    bool valid() const { return valid_; }
+
+private:
+    void reset();
+
+private:
+    const unsigned char* data_{nullptr};
+    size_t size_{0};
+    bool valid_{false};
+};
+
+
+/**
+ * 资源虚拟文件系统
+ * - mount("data", "/path/to/repo/data") 后, "data/nanosuit/a.png" 映射到真实路径
+ * - 未匹配任何挂载点的路径按真实路径处理
+ */
+class Vfs{
+public:
+    static Vfs& instance();
+
+    void mount(const std::string& mount_point, const std::string& real_dir);
+
+    std::string resolve(const std::string& path) const;
+
+    bool exists(const std::string& path) const;
+
+    MappedFile map(const std::string& path) const;
+
+private:
+    Vfs(){}
+
+    static std::string normalize(const std::string& path);
+
+private:
+    struct MountPoint{
+        std::string prefix;
+        std::string real_dir;
+    };
+
+    mutable std::mutex mutex_;
+    std::vector<MountPoint> mounts_;   // 按前缀长度降序, 最长匹配优先
+};
+
+#endif
@@ -0,0 +1,65 @@
+#include "./vfs_assimp.h"
+
+#include <cstring>
+#include <algorithm>
+
+size_t VfsIOStream::Read(void* buffer, size_t size, size_t count){
+    if(size == 0 || count == 0 || pos_ >= file_.size())
+        return 0;
+    const size_t items = std::min(count, (file_.size() - pos_) / size);
+    std::memcpy(buffer, file_.data() + pos_, items * size);
+    pos_ += items * size;
+    return items;
+}
+
+size_t VfsIOStream::Write(const void* /*buffer*/, size_t /*size*/, size_t /*count*/){
+    return 0;
+}
+
+aiReturn VfsIOStream::Seek(size_t offset, aiOrigin origin){
+    size_t target;
+    if(origin == aiOrigin_SET)
+        target = offset;
+    else if(origin == aiOrigin_CUR)
+        target = pos_ + offset;
+    else
+        target = file_.size() - offset;
+
+    if(target > file_.size())
+        return aiReturn_FAILURE;
+    pos_ = target;
+    return aiReturn_SUCCESS;
+}
+
+size_t VfsIOStream::Tell() const{
+    return pos_;
+}
+
+size_t VfsIOStream::FileSize() const{
+    return file_.size();
+}
+
+void VfsIOStream::Flush(){}
+
+
+bool VfsIOSystem::Exists(const char* path) const{
+    return Vfs::instance().exists(path);
+}
+
+char VfsIOSystem::getOsSeparator() const{
+    return '/';
+}
+
+Assimp::IOStream* VfsIOSystem::Open(const char* path, const char* mode){
+    // - 只读
+    if(std::strchr(mode, 'w') || std::strchr(mode, 'a'))
+        return nullptr;
+    MappedFile file = Vfs::instance().map(path);
+    if(!file.valid())
+        return nullptr;
+    return new VfsIOStream(std::move(file));
+}
+
+void VfsIOSystem::Close(Assimp::IOStream* stream){
+    delete stream;
+}
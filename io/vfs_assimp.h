@@ -0,0 +1,35 @@
+#ifndef OPENGL_IO_VFS_ASSIMP_H_
+#define OPENGL_IO_VFS_ASSIMP_H_
+
+#include <assimp/IOStream.hpp>
+#include <assimp/IOSystem.hpp>
+
+#include "./vfs.h"
+
+// - Assimp 读取流, 持有 mmap, Read 直接从映射内存拷给 Assimp
+class VfsIOStream : public Assimp::IOStream{
+public:
+    VfsIOStream(MappedFile&& file): file_(std::move(file)){}
+
+    size_t Read(void* buffer, size_t size, size_t count) override;
+    size_t Write(const void* buffer, size_t size, size_t count) override;
+    aiReturn Seek(size_t offset, aiOrigin origin) override;
+    size_t Tell() const override;
+    size_t FileSize() const override;
+    void Flush() override;
+
+private:
+    MappedFile file_;
+    size_t pos_{0};
+};
+
+// - 通过 Importer::SetIOHandler 安装, Assimp 打开的 obj / mtl 等都经过 Vfs
+class VfsIOSystem : public Assimp::IOSystem{
+public:
+    bool Exists(const char* path) const override;
+    char getOsSeparator() const override;
+    Assimp::IOStream* Open(const char* path, const char* mode = "rb") override;
+    void Close(Assimp::IOStream* stream) override;
+};
+
+#endif
@@ -1,9 +1,13 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <iostream>
+#include <cstdlib>
 #include <vector>
+#include <memory>
 #include <cmath>
 #include <chrono>
+#include <thread>
+#include <algorithm>
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -18,8 +22,20 @@
 
 #include "shader/shader.h"
 #include "camera/camera.h"
+#include "camera/camera_log.h"
 // #include "texture/texture.h"
 #include "io/model.h"
+#include "render/ring_buffer.h"
+#include "render/point_cloud_renderer.h"
+#include "render/frame_packet.h"
+#include "render/gl_upload_thread.h"
+#include "render/gpu_timer.h"
+#include "io/vfs.h"
+#include "core/job_system.h"
+#include "core/task.h"
+#include "core/startup_timeline.h"
+#include "core/profiler.h"
+#include "io/async_loader.h"
 
 
 typedef struct {
@@ -27,21 +43,41 @@ typedef struct {
     bool is_last_down{false};
 } MouseInfo;
 
+// 与 shader 中 FrameBlock (std140) 布局一致
+struct FrameUniforms{
+    glm::mat4 model_mat;
+    glm::mat4 view_mat;
+    glm::mat4 projection_mat;
+    glm::mat4 normal_model_mat;
+    glm::vec4 light_pos;
+    glm::vec4 camera_pos;
+};
+const unsigned int kFrameBlockBinding = 0;
+
+// - DrawItem::object
+const unsigned int kObjectModel = 0;
+const unsigned int kObjectPointCloud = 1;
+
 
 const int kWidth = 800, kHeight = 600;
 MouseInfo mouse_left_info, mouse_right_info;
 Camera camera;
+// - 交互输入经 camera_recorder 作用于相机(打开记录时同时写日志); 回放时不读取交互输入
+CameraRecorder camera_recorder;
+CameraReplay camera_replay;
 
 float delta_time = 0.5f;
 float last_time = 0.0f;
 
+// - 视口在渲染线程按 FramePacket 中的帧缓冲尺寸设置, 这里不调用 GL
 void framebuffer_size_callback(GLFWwindow* window, int width, int height)
 {
-    glViewport(0, 0, width, height);
 }
 
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset ){
-    camera.update_forward(yoffset);
+    if(camera_replay.is_open())
+        return;
+    camera_recorder.update_forward(camera, yoffset);
     camera.info();
 }
 
@@ -52,29 +88,31 @@ void processInput(GLFWwindow* window){
         glfwGetKey(window, GLFW_KEY_Q) == GLFW_PRESS ){
         glfwSetWindowShouldClose(window, true);
     }
+    if(camera_replay.is_open())
+        return;
     // float  speed = 0.05f;;
     float  speed = delta_time * 10;
     if(glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS){
-        camera.update_forward(speed);
+        camera_recorder.update_forward(camera, speed);
         camera.info();
 
     }
     else if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS){
-        camera.update_forward(speed);
+        camera_recorder.update_forward(camera, speed);
         camera.info();
 
     }
     else if(glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS){
-        camera.update_camera(0, -speed);
+        camera_recorder.update_camera(camera, 0, -speed);
         camera.info();
     }
     else if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS){
-        camera.update_camera(0, speed);
+        camera_recorder.update_camera(camera, 0, speed);
         camera.info();
     }
 
     if(glfwGetKey(window, GLFW_KEY_R) == GLFW_PRESS){
-        camera.reset();
+        camera_recorder.reset(camera);
         camera.info();
     }
 
@@ -91,10 +129,10 @@ void processInput(GLFWwindow* window){
                 delta_pos *= 0.1;
                 // camera.update_camera((float)(delta_pos[1]), (float)(delta_pos[0]));
                 if(left_or_right == GLFW_MOUSE_BUTTON_RIGHT){
-                    camera.update_camera((float)(delta_pos[1]), (float)(delta_pos[0]));
+                    camera_recorder.update_camera(camera, (float)(delta_pos[1]), (float)(delta_pos[0]));
                 }
                 else{
-                    camera.update_object((float)(delta_pos[1]), (float)(delta_pos[0]));
+                    camera_recorder.update_object(camera, (float)(delta_pos[1]), (float)(delta_pos[0]));
                 }
 
             }
@@ -137,8 +175,22 @@ void show_mat4(const glm::mat4& mat4){
 
 }
 
+#ifndef PROJECT_ROOT_DIR
+#define PROJECT_ROOT_DIR "."
+#endif
+
+// - 资源根目录: 环境变量 TEST_OPENGL_ROOT 优先, 否则为构建时的源码目录
 std::string get_root_path(){
-    return "/home/ubt22/Projects/test_opengl_io/";
+    const char* root = getenv("TEST_OPENGL_ROOT");
+    if(root && root[0] != '\0')
+        return root;
+    return PROJECT_ROOT_DIR;
+}
+
+void mount_assets(){
+    const std::string ROOT_PATH = get_root_path();
+    Vfs::instance().mount("data", ROOT_PATH + "/data");
+    Vfs::instance().mount("shader", ROOT_PATH + "/shader");
 }
 
 GLFWwindow* InitWindow(){
@@ -171,9 +223,8 @@ GLFWwindow* InitWindow(){
 
 Shader::PathMap get_path_map(const std::string& prefix){
 
-    const std::string ROOT_PATH = get_root_path();
-    const std::string vertex_path = ROOT_PATH + "/shader/" + prefix + "_shader_vertex.vs";
-    const std::string frag_path = ROOT_PATH + "/shader/"+ prefix + "_shader_fragment.fs";
+    const std::string vertex_path = "shader/" + prefix + "_shader_vertex.vs";
+    const std::string frag_path = "shader/"+ prefix + "_shader_fragment.fs";
     Shader::PathMap path_map{{"vertex",vertex_path},
                             {"frag",frag_path}};
     return path_map;
@@ -197,14 +248,96 @@ int main()
 
     // ============== 窗口初始化 end
 
+    // - 启动流水: 模型导入、贴图解码与 shader 源码读取先在 worker 开始, 与窗口创建重叠
+    //   需要 GL 的步骤排队, context 就绪后执行; 各阶段耗时在第一帧后输出
+    StartupTimeline& startup = StartupTimeline::instance();
+    // - TEST_OPENGL_PROFILE=<trace.json> 打开 CPU profiler: 每 5 秒输出各区统计, 退出时写 Chrome trace
+    //   JobSystem 的任务也记入时间线, 需在提交任何任务之前 attach
+    //   TEST_OPENGL_GPU_TIMER=pass|mesh 另外按 pass(或每个 mesh)记录 GPU 耗时, 同样打开 profiler
+    const char* profile_env = std::getenv("TEST_OPENGL_PROFILE");
+    const char* gpu_timer_env = std::getenv("TEST_OPENGL_GPU_TIMER");
+    const bool gpu_timing = gpu_timer_env && *gpu_timer_env;
+    const bool profiling = (profile_env && *profile_env) || gpu_timing;
+    Profiler& profiler = Profiler::instance();
+    if(profiling){
+        profiler.set_enabled(true);
+        profiler.attach(JobSystem::instance());
+    }
+    PROFILE_THREAD("main");
+    mount_assets();
+
+    // - TEST_OPENGL_MODEL 可指定其它模型或 bundle_packer 生成的资源包, 加载耗时见 "OUT: model load"
+    const char* model_env = std::getenv("TEST_OPENGL_MODEL");
+    const std::string img_path = model_env && *model_env ? model_env : "data/nanosuit/nanosuit.obj";
+    startup.begin("model_load");
+    // - 保留首次解码结果, 加载后的 atlas / 通道打包 / 纹理数组不再重复解码
+    TextureManager::instance().keep_decoded(true);
+    Task<std::unique_ptr<Model>> model_task = Model::load_async(img_path);
+    model_task.start();
+
+    // - TEST_OPENGL_POINT_CLOUD 指定 point_octree_builder 生成的 .octree 时叠加绘制点云, 其 shader 不依赖模型
+    const char* point_cloud_env = std::getenv("TEST_OPENGL_POINT_CLOUD");
+    const bool want_point_cloud = point_cloud_env && *point_cloud_env;
+    Task<std::unique_ptr<Shader>> point_shader_task;
+    if(want_point_cloud){
+        point_shader_task = load_shader_async(get_path_map("point"));
+        point_shader_task.start();
+    }
+
+    startup.begin("window");
     GLFWwindow* window = InitWindow();
     glGetError(); 
-
-
-    const std::string img_path = get_root_path() + "/data/nanosuit/nanosuit.obj";
-    Model in_model(img_path);
-
-    in_model.setup_mesh();
+    GlThreadQueue::instance().bind_current_thread();
+    // - TEST_OPENGL_UPLOAD_THREAD 非空时, 缓冲与纹理在共享 context 的上传线程创建, 渲染线程只建 VAO
+    GLFWwindow* upload_window = nullptr;
+    const char* upload_env = std::getenv("TEST_OPENGL_UPLOAD_THREAD");
+    if(upload_env && *upload_env){
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+        upload_window = glfwCreateWindow(1, 1, "upload", NULL, window);
+        glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+        if(upload_window){
+            GlUploadThread::start([upload_window](){
+                glfwMakeContextCurrent(upload_window);
+                return glfwGetCurrentContext() == upload_window;
+            }, [](){
+                glfwMakeContextCurrent(NULL);
+            });
+        }else{
+            std::cout << "WARN: create shared upload context fail, uploads stay on GL thread" << std::endl;
+        }
+    }
+    startup.end("window");
+
+    sync_wait(model_task);
+    startup.end("model_load");
+    std::unique_ptr<Model> model = model_task.result();
+    Model& in_model = *model;
+
+    startup.begin("gl_upload");
+    // - 小贴图合并为 atlas, 需在上传顶点之前重映射 UV
+    in_model.pack_small_textures();
+    // - 单通道贴图合并, 有打包时使用 PACKED_CHANNELS 的 shader 变体
+    const bool has_packed_channels = in_model.pack_material_channels() > 0;
+    // - shader 变体确定后即开始读源码, 与下面的上传重叠
+    std::vector<std::string> object_defines;
+    if(has_packed_channels)
+        object_defines.push_back("PACKED_CHANNELS");
+    startup.begin("shader_compile");
+    Task<std::unique_ptr<Shader>> object_shader_task = load_shader_async(get_path_map("object"), object_defines);
+    object_shader_task.start();
+    // - TEST_OPENGL_GEOMETRY_RETENTION=drop|compact 上传后释放 CPU 端几何, 默认 keep
+    const char* retention_env = std::getenv("TEST_OPENGL_GEOMETRY_RETENTION");
+    if(retention_env && std::string(retention_env) == GeometryRetentionStr(GeometryRetention::DROP))
+        in_model.retention_ = GeometryRetention::DROP;
+    else if(retention_env && std::string(retention_env) == GeometryRetentionStr(GeometryRetention::COMPACT))
+        in_model.retention_ = GeometryRetention::COMPACT;
+    // - 等待期间 GL 线程继续执行排队的步骤(例如 shader 编译)
+    Task<void> upload_task = in_model.setup_mesh_async();
+    sync_wait(upload_task);
+    startup.end("gl_upload");
+    TextureManager::instance().info();
+    // - 加载阶段各 worker 的任务数与利用率
+    JobSystem::instance().info();
     // Mesh& mesh0 = in_model.meshes_[0];
     // for(size_t i=0; i < mesh0.vertices_.size(); i++){
     //     std::cout << " - i " << i << ": " << mesh0.vertices_[i].pos.x << ", " << mesh0.vertices_[i].pos.y << ", " <<  mesh0.vertices_[i].pos.z << std::endl;
@@ -253,8 +386,40 @@ int main()
 
     
     glEnable(GL_DEPTH_TEST);
-    Shader::PathMap object_ath_map = get_path_map("object");
-    Shader object_shader(object_ath_map);
+    sync_wait(object_shader_task);
+    std::unique_ptr<Shader> object_shader_ptr = object_shader_task.result();
+    Shader& object_shader = *object_shader_ptr;
+    object_shader.bind_uniform_block("FrameBlock", kFrameBlockBinding);
+    startup.end("shader_compile");
+
+    // - 每帧 uniform 走持久映射的环形缓冲, 三段轮转
+    int ubo_alignment = 256;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &ubo_alignment);
+    std::unique_ptr<RingBuffer> frame_ring(new RingBuffer(GL_UNIFORM_BUFFER, 64 * 1024, 3));
+
+    // - 纹理数组合批: 全部材质一次绑定, 不支持时退回逐 mesh 绑定
+    std::unique_ptr<Shader> object_array_shader;
+    const bool use_texture_arrays = in_model.build_texture_arrays();
+    TextureManager::instance().keep_decoded(false);
+    if(use_texture_arrays){
+        Shader::PathMap object_array_path_map = get_path_map("object_array");
+        object_array_shader.reset(new Shader(object_array_path_map));
+        object_array_shader->bind_uniform_block("FrameBlock", kFrameBlockBinding);
+    }
+
+    std::unique_ptr<PointCloudRenderer> point_cloud;
+    std::unique_ptr<Shader> point_shader;
+    if(want_point_cloud){
+        // - 无论是否使用都要等它结束, 排队中的协程不能随任务析构
+        sync_wait(point_shader_task);
+        point_cloud.reset(new PointCloudRenderer());
+        if(point_cloud->open(point_cloud_env)){
+            point_shader = point_shader_task.result();
+            point_shader->bind_uniform_block("FrameBlock", kFrameBlockBinding);
+        }else{
+            point_cloud.reset();
+        }
+    }
 
     // Shader::PathMap light_path_map = get_path_map("light");
     // Shader light_shader(light_path_map);
@@ -276,49 +441,205 @@ int main()
     camera.camera_pos_ = glm::vec3(0.0f, 5.0f, 10.0f);
     camera.update_forward(0, 0);
 
-    while(!glfwWindowShouldClose(window)){
-
+    // - TEST_OPENGL_CAMERA_RECORD=<path> 记录每帧施加到相机的增量与帧时间; TEST_OPENGL_CAMERA_REPLAY=<path> 逐帧回放,
+    //   用记录的时间代替 glfwGetTime, 放完后退出; 同一日志也可交给 bench_render 离屏复现
+    const char* camera_record_env = std::getenv("TEST_OPENGL_CAMERA_RECORD");
+    const char* camera_replay_env = std::getenv("TEST_OPENGL_CAMERA_REPLAY");
+    if(camera_replay_env && *camera_replay_env){
+        if(camera_replay.open(camera_replay_env))
+            camera_replay.apply_initial(camera);
+    }else if(camera_record_env && *camera_record_env){
+        camera_recorder.open(camera_record_env, camera);
+    }
 
-        float cur_time = glfwGetTime();
-        delta_time = cur_time - last_time;
-        last_time = cur_time;
+    // - 更新(输入、相机、变换)在主线程, GL 提交在渲染线程, 两者经 FramePacketQueue 交换帧数据
+    //   TEST_OPENGL_SINGLE_THREAD 非空时按原来的顺序在主线程完成; TEST_OPENGL_FRAME_PACKETS=3 使用三缓冲
+    const char* single_thread_env = std::getenv("TEST_OPENGL_SINGLE_THREAD");
+    const bool threaded = !(single_thread_env && *single_thread_env);
+    const char* packets_env = std::getenv("TEST_OPENGL_FRAME_PACKETS");
+    // - 按 int 解析后限制在 [2, 3], 负数不会转成极大的无符号深度
+    const int packet_count = packets_env && *packets_env ? std::min(3, std::max(2, std::atoi(packets_env))) : 2;
+    FramePacketQueue packet_queue(static_cast<unsigned int>(packet_count));
+
+    // - 每个 DrawItem 一份 FrameBlock, 从环形缓冲分配
+    auto bind_frame_uniforms = [&](const FramePacket& packet, const DrawItem& item){
+        size_t frame_offset = 0;
+        FrameUniforms* frame_uniforms = static_cast<FrameUniforms*>(
+                    frame_ring->allocate(sizeof(FrameUniforms), ubo_alignment, frame_offset));
+        if(!frame_uniforms)
+            return;
+        frame_uniforms->model_mat = item.model_mat;
+        frame_uniforms->view_mat = packet.view;
+        frame_uniforms->projection_mat = packet.projection;
+        frame_uniforms->normal_model_mat = item.normal_mat;
+        frame_uniforms->light_pos = glm::vec4(packet.light_pos, 1.0f);
+        frame_uniforms->camera_pos = glm::vec4(packet.camera_pos, 1.0f);
+        frame_ring->flush();
+        glBindBufferRange(GL_UNIFORM_BUFFER, kFrameBlockBinding, frame_ring->buffer_id(), frame_offset, sizeof(FrameUniforms));
+    };
 
-        glfwSetScrollCallback(window, scroll_callback);
+    // - 只读 packet, 不访问更新线程的状态
+    int viewport_width = kWidth, viewport_height = kHeight;
+    // - 需在 GL 线程调用
+    auto init_gpu_timer = [&](){
+        if(gpu_timing)
+            GpuTimer::instance().init(2, std::string(gpu_timer_env) == "mesh");
+    };
 
-        processInput(window);
+    auto render_frame = [&](const FramePacket& packet){
+        PROFILE_ZONE("draw");
+        GpuTimer& gpu_timer = GpuTimer::instance();
+        gpu_timer.begin_frame();
+        if(packet.viewport_width != viewport_width || packet.viewport_height != viewport_height){
+            viewport_width = packet.viewport_width;
+            viewport_height = packet.viewport_height;
+            glViewport(0, 0, viewport_width, viewport_height);
+        }
         glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+        frame_ring->begin_frame();
+        for(const DrawItem& item : packet.draws){
+            bind_frame_uniforms(packet, item);
+            if(item.object == kObjectModel){
+                GPU_ZONE("gpu_model");
+                object_shader.use();
+                if(use_texture_arrays)
+                    in_model.draw_batched(*object_array_shader, object_shader);
+                else
+                    in_model.draw(object_shader);
+            }else if(item.object == kObjectPointCloud && point_cloud){
+                GPU_ZONE("gpu_point_cloud");
+                point_cloud->update(packet.view, packet.projection, packet.camera_pos, packet.viewport_height);
+                point_shader->use();
+                point_cloud->draw();
+            }
+        }
+        gpu_timer.end_frame();
+        frame_ring->end_frame();
+        // - 本帧释放的 GL 对象插入 fence, 之前已完成的批次真正删除
+        GlDeletionQueue::instance().end_frame();
+        // - 异步加载中等待 GL 线程的步骤
+        GlThreadQueue::instance().pump();
+    };
 
-        glm::mat4 model         = glm::mat4(1.0f);
-        glm::mat4 view          =glm::mat4(1.0f);
-        glm::mat4 projection    =glm::mat4(1.0f);
-        glm::mat4 normal_model_mat = glm::mat4(1.0f);
+    auto update_frame = [&](FramePacket& packet, uint64_t frame){
+        float cur_time = glfwGetTime();
+        delta_time = cur_time - last_time;
+        last_time = cur_time;
 
-        model  = glm::rotate(model, cur_time, glm::vec3(0.0f, 1.0f, 0.0f));
-        normal_model_mat = glm::transpose(glm::inverse(model));
-        view = camera.view_mat4_;
-        projection = glm::perspective(glm::radians(90.0f), (float)kWidth / (float)kHeight, 0.1f, 200.0f);
+        {
+            PROFILE_ZONE("input");
+            processInput(window);
+        }
 
-        object_shader.use();
-        object_shader.set_mat4("model_mat", glm::value_ptr(model));
-        object_shader.set_mat4("view_mat", glm::value_ptr(view));
-        object_shader.set_mat4("projection_mat", glm::value_ptr(projection));
-        object_shader.set_mat4("normal_model_mat", glm::value_ptr(normal_model_mat));
+        if(camera_replay.is_open()){
+            if(!camera_replay.next_frame(camera, cur_time))
+                glfwSetWindowShouldClose(window, true);
+        }else{
+            camera_recorder.frame(cur_time);
+        }
 
-        object_shader.set_vec3("light_pos", glm::value_ptr(light_pos));
-        object_shader.set_vec3("camera_pos", glm::value_ptr(camera.camera_pos_));
+        PROFILE_ZONE("camera");
+        glm::mat4 model = glm::rotate(glm::mat4(1.0f), cur_time, glm::vec3(0.0f, 1.0f, 0.0f));
+        packet.frame = frame;
+        packet.time = cur_time;
+        glfwGetFramebufferSize(window, &packet.viewport_width, &packet.viewport_height);
+        packet.view = camera.view_mat4_;
+        packet.projection = glm::perspective(glm::radians(90.0f), (float)kWidth / (float)kHeight, 0.1f, 200.0f);
+        packet.camera_pos = camera.camera_pos_;
+        packet.light_pos = light_pos;
+        packet.draws.clear();
+        packet.draws.push_back({kObjectModel, model, glm::transpose(glm::inverse(model))});
+        if(point_cloud)
+            packet.draws.push_back({kObjectPointCloud, glm::mat4(1.0f), glm::mat4(1.0f)});
+    };
 
-        // a_mesh.draw(object_shader);
+    auto report_first_frame = [&startup](){
+        startup.end("first_frame");
+        startup.first_frame();
+    };
 
-        in_model.draw(object_shader);
-        // in_model.meshes_[1].draw(object_shader);
+    glfwSetScrollCallback(window, scroll_callback);
+    startup.begin("first_frame");
+    std::thread render_thread;
+    if(threaded){
+        // - GL context 交给渲染线程; 窗口事件仍需在主线程处理
+        glfwMakeContextCurrent(NULL);
+        render_thread = std::thread([&](){
+            glfwMakeContextCurrent(window);
+            GlThreadQueue::instance().bind_current_thread();
+            PROFILE_THREAD("render");
+            init_gpu_timer();
+            while(FramePacket* packet = packet_queue.begin_read()){
+                const uint64_t packet_frame = packet->frame;
+                render_frame(*packet);
+                packet_queue.end_read();
+                {
+                    PROFILE_ZONE("swap");
+                    glfwSwapBuffers(window);
+                }
+                if(packet_frame == 0)
+                    report_first_frame();
+            }
+            GpuTimer::instance().shutdown();
+            glfwMakeContextCurrent(NULL);
+        });
+    }
 
-        glfwSwapBuffers(window);
-        glfwPollEvents();
-        // start = std::chrono::high_resolution_clock::now();
+    if(!threaded)
+        init_gpu_timer();
+    uint64_t frame = 0;
+    FramePacket single_packet;
+    const double kProfileReportSeconds = 5.0;
+    double profile_report_time = glfwGetTime();
+    while(!glfwWindowShouldClose(window)){
+        if(threaded){
+            FramePacket* packet = packet_queue.begin_write();
+            if(!packet)
+                break;
+            update_frame(*packet, frame++);
+            packet_queue.end_write();
+        }else{
+            update_frame(single_packet, frame++);
+            render_frame(single_packet);
+            {
+                PROFILE_ZONE("swap");
+                glfwSwapBuffers(window);
+            }
+            if(single_packet.frame == 0)
+                report_first_frame();
+        }
+        {
+            PROFILE_ZONE("poll_events");
+            glfwPollEvents();
+        }
+        if(profiling){
+            profiler.collect();
+            const double now = glfwGetTime();
+            if(now - profile_report_time >= kProfileReportSeconds){
+                profiler.info("last 5 s");
+                profile_report_time = now;
+            }
+        }
+    }
+    if(threaded){
+        packet_queue.stop();
+        render_thread.join();
+        packet_queue.info();
+        glfwMakeContextCurrent(window);
+    }else{
+        GpuTimer::instance().shutdown();
     }
+    if(profile_env && *profile_env)
+        profiler.write_chrome_trace(profile_env);
+    camera_recorder.close();
+    GlUploadThread::stop();
+    if(upload_window)
+        glfwDestroyWindow(upload_window);
+    // - 环形缓冲持有 GL 对象, 须在 context 仍然当前时销毁
+    frame_ring.reset();
+    GlDeletionQueue::instance().flush();
     glfwTerminate();
     return 0;
 }
-
@@ -0,0 +1,84 @@
+#include "./frame_packet.h"
+
+#include <chrono>
+#include <iostream>
+#include <algorithm>
+
+namespace {
+
+uint64_t now_ns(){
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+}
+
+FramePacketQueue::FramePacketQueue(unsigned int packet_count){
+    packet_count = std::max(2u, packet_count);
+    packets_.resize(packet_count);
+    for(unsigned int i=0; i<packet_count; i++)
+        free_.push_back(i);
+}
+
+FramePacket* FramePacketQueue::begin_write(){
+    const uint64_t start = now_ns();
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this](){ return stop_ || !free_.empty(); });
+    write_wait_ns_ += now_ns() - start;
+    if(stop_)
+        return nullptr;
+    writing_ = static_cast<int>(free_.front());
+    free_.pop_front();
+    return &packets_[writing_];
+}
+
+void FramePacketQueue::end_write(){
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if(writing_ < 0)
+            return;
+        ready_.push_back(static_cast<unsigned int>(writing_));
+        writing_ = -1;
+    }
+    cv_.notify_all();
+}
+
+FramePacket* FramePacketQueue::begin_read(){
+    const uint64_t start = now_ns();
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this](){ return stop_ || !ready_.empty(); });
+    read_wait_ns_ += now_ns() - start;
+    if(stop_)
+        return nullptr;
+    reading_ = static_cast<int>(ready_.front());
+    ready_.pop_front();
+    return &packets_[reading_];
+}
+
+void FramePacketQueue::end_read(){
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if(reading_ < 0)
+            return;
+        free_.push_back(static_cast<unsigned int>(reading_));
+        reading_ = -1;
+        frames_++;
+    }
+    cv_.notify_all();
+}
+
+void FramePacketQueue::stop(){
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+}
+
+void FramePacketQueue::info() const{
+    std::lock_guard<std::mutex> lock(mutex_);
+    const double frames = std::max<uint64_t>(1, frames_);
+    std::cout << "OUT: frame packets " << packets_.size() << ", " << frames_ << " frames, update waited "
+              << write_wait_ns_ / 1e6 / frames << " ms/frame, render waited " << read_wait_ns_ / 1e6 / frames
+              << " ms/frame" << std::endl;
+}
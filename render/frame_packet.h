@@ -0,0 +1,76 @@
+#ifndef OPENGL_RENDER_FRAME_PACKET_H_
+#define OPENGL_RENDER_FRAME_PACKET_H_
+#include <deque>
+#include <mutex>
+#include <vector>
+#include <cstdint>
+#include <condition_variable>
+
+#include <glm/glm.hpp>
+
+// - 一个待绘制对象: object 由调用方约定(模型、点云等), 变换在更新线程算好
+struct DrawItem{
+    unsigned int object{0};
+    glm::mat4 model_mat{1.0f};
+    glm::mat4 normal_mat{1.0f};
+};
+
+/**
+ * 更新线程交给渲染线程的一帧数据, 渲染线程只读它, 不访问更新线程的状态
+ */
+struct FramePacket{
+    uint64_t frame{0};
+    float time{0.0f};
+    int viewport_width{0};
+    int viewport_height{0};
+    glm::mat4 view{1.0f};
+    glm::mat4 projection{1.0f};
+    glm::vec3 camera_pos{0.0f};
+    glm::vec3 light_pos{0.0f};
+    std::vector<DrawItem> draws;    // 每帧 clear 后复用容量
+};
+
+/**
+ * 更新线程与渲染线程之间的帧数据队列, packet_count 个 FramePacket 轮转
+ * - 2 个为双缓冲: 更新线程写第 N+1 帧时渲染线程提交第 N 帧
+ * - 3 个为三缓冲: 更新线程最多领先两帧, 吸收单帧的时间抖动, 代价是多一帧延迟
+ * 没有空闲 packet 时 begin_write 阻塞, 渲染跟不上时自然限制更新速度
+ */
+class FramePacketQueue{
+public:
+    explicit FramePacketQueue(unsigned int packet_count = 2);
+
+    FramePacketQueue(const FramePacketQueue&) = delete;
+    FramePacketQueue& operator=(const FramePacketQueue&) = delete;
+
+    // - 取一个空闲 packet 写入, stop() 之后返回 nullptr
+    FramePacket* begin_write();
+    void end_write();
+
+    // - 按写入顺序取下一帧, stop() 之后返回 nullptr
+    FramePacket* begin_read();
+    void end_read();
+
+    // - 唤醒并结束两侧的等待
+    void stop();
+
+    // - 输出两侧累计的等待时间
+    void info() const;
+
+private:
+    std::vector<FramePacket> packets_;
+    std::deque<unsigned int> free_;
+    std::deque<unsigned int> ready_;
+    int writing_{-1};
+    int reading_{-1};
+    bool stop_{false};
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+
+    uint64_t write_wait_ns_{0};
+    uint64_t read_wait_ns_{0};
+    uint64_t frames_{0};
+};
+
+#endif
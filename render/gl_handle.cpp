@@ -0,0 +1,133 @@
+#include "./gl_handle.h"
+
+#include <iostream>
+
+GlDeletionQueue& GlDeletionQueue::instance(){
+    // - 不在析构中调用 GL, 进程退出时 context 可能已经销毁, 故不需要关心静态对象析构顺序
+    static GlDeletionQueue queue;
+    return queue;
+}
+
+void GlDeletionQueue::push(GlObjectType type, unsigned int id){
+    if(id == 0)
+        return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    incoming_.emplace_back(type, id);
+}
+
+void GlDeletionQueue::push_fence(GLsync fence){
+    if(!fence)
+        return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    fences_.push_back(fence);
+}
+
+void GlDeletionQueue::end_frame(){
+    std::vector<Object> objects;
+    std::vector<GLsync> fences;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        objects.swap(incoming_);
+        fences.swap(fences_);
+    }
+    // - sync 对象删除时不会影响在途命令, 直接删除
+    for(GLsync fence : fences)
+        glDeleteSync(fence);
+    if(!objects.empty()){
+        Batch batch;
+        batch.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        batch.objects = std::move(objects);
+        batches_.push_back(std::move(batch));
+    }
+
+    // - fence 按提交顺序完成, 遇到第一个未完成的即可停止
+    while(!batches_.empty()){
+        Batch& batch = batches_.front();
+        const GLenum result = glClientWaitSync(batch.fence, 0, 0);
+        if(result == GL_TIMEOUT_EXPIRED)
+            break;
+        if(result == GL_WAIT_FAILED)
+            std::cout << "WARN: GlDeletionQueue glClientWaitSync fail, delete anyway" << std::endl;
+        glDeleteSync(batch.fence);
+        destroy(batch.objects);
+        batches_.pop_front();
+    }
+}
+
+void GlDeletionQueue::flush(){
+    std::vector<Object> objects;
+    std::vector<GLsync> fences;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        objects.swap(incoming_);
+        fences.swap(fences_);
+    }
+    for(GLsync fence : fences)
+        glDeleteSync(fence);
+    while(!batches_.empty()){
+        Batch& batch = batches_.front();
+        GLenum result = glClientWaitSync(batch.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);  // 1s
+        if(result == GL_TIMEOUT_EXPIRED)
+            std::cout << "WARN: GlDeletionQueue fence timeout, delete anyway" << std::endl;
+        glDeleteSync(batch.fence);
+        destroy(batch.objects);
+        batches_.pop_front();
+    }
+    // - 本帧的对象: GL 保证删除时仍在使用的对象会延后到命令完成, 这里直接删除
+    destroy(objects);
+}
+
+size_t GlDeletionQueue::pending_count() const{
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t count = incoming_.size();
+    for(const Batch& batch : batches_)
+        count += batch.objects.size();
+    return count;
+}
+
+void GlDeletionQueue::destroy(std::vector<Object>& objects){
+    for(const Object& object : objects){
+        const unsigned int id = object.second;
+        switch(object.first){
+            case GlObjectType::BUFFER:
+                glDeleteBuffers(1, &id);
+                break;
+            case GlObjectType::VERTEX_ARRAY:
+                glDeleteVertexArrays(1, &id);
+                break;
+            case GlObjectType::TEXTURE:
+                glDeleteTextures(1, &id);
+                break;
+            case GlObjectType::PROGRAM:
+                glDeleteProgram(id);
+                break;
+            case GlObjectType::QUERY:
+                glDeleteQueries(1, &id);
+                break;
+        }
+    }
+    deleted_count_ += objects.size();
+    objects.clear();
+}
+
+unsigned int gl_create_object(GlObjectType type){
+    unsigned int id = 0;
+    switch(type){
+        case GlObjectType::BUFFER:
+            glGenBuffers(1, &id);
+            break;
+        case GlObjectType::VERTEX_ARRAY:
+            glGenVertexArrays(1, &id);
+            break;
+        case GlObjectType::TEXTURE:
+            glGenTextures(1, &id);
+            break;
+        case GlObjectType::PROGRAM:
+            id = glCreateProgram();
+            break;
+        case GlObjectType::QUERY:
+            glGenQueries(1, &id);
+            break;
+    }
+    return id;
+}
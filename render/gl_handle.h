@@ -0,0 +1,125 @@
+#ifndef OPENGL_RENDER_GL_HANDLE_H_
+#define OPENGL_RENDER_GL_HANDLE_H_
+#include <mutex>
+#include <deque>
+#include <vector>
+#include <utility>
+
+#include <glad/glad.h>
+
+enum class GlObjectType : unsigned char{
+    BUFFER = 0,
+    VERTEX_ARRAY,
+    TEXTURE,
+    PROGRAM,
+    QUERY
+};
+
+/**
+ * GL 对象的延迟删除队列
+ * - push() / push_fence() 可在任意线程、任意时刻调用(包括 context 已销毁之后的析构), 本身不调用 GL
+ * - GL 线程每帧调用 end_frame(): 为本帧释放的对象插入一个 fence, fence 完成的批次才真正 glDelete*
+ *   仍被在途命令引用的对象不会提前删除, 也不需要 glFinish
+ */
+class GlDeletionQueue{
+public:
+    static GlDeletionQueue& instance();
+
+    GlDeletionQueue(const GlDeletionQueue&) = delete;
+    GlDeletionQueue& operator=(const GlDeletionQueue&) = delete;
+
+    void push(GlObjectType type, unsigned int id);
+
+    // - 不再等待的 fence, 同样延后到 GL 线程的 end_frame / flush 删除
+    void push_fence(GLsync fence);
+
+    // - 需在 GL 线程调用
+    void end_frame();
+
+    // - 等待全部 fence 并删除, 卸载场景或销毁 context 之前调用; 需在 GL 线程
+    void flush();
+
+    size_t pending_count() const;
+    size_t deleted_count() const { return deleted_count_; }
+
+private:
+    GlDeletionQueue(){}
+
+    using Object = std::pair<GlObjectType, unsigned int>;
+
+    struct Batch{
+        GLsync fence{nullptr};
+        std::vector<Object> objects;
+    };
+
+    void destroy(std::vector<Object>& objects);
+
+private:
+    mutable std::mutex mutex_;
+    std::vector<Object> incoming_;      // 上次 end_frame 之后释放的对象
+    std::deque<Batch> batches_;         // 等待 fence 的批次, 按提交顺序
+    std::vector<GLsync> fences_;        // push_fence 交来的 fence, 删除无需等待
+    size_t deleted_count_{0};
+};
+
+// - 创建一个 GL 对象, PROGRAM 为 glCreateProgram, 其余为 glGen*
+unsigned int gl_create_object(GlObjectType type);
+
+/**
+ * 只可移动的 GL 对象句柄, 析构时交给 GlDeletionQueue
+ * 可隐式转换为 GL id, 直接用于 glBind* / glUseProgram 等调用
+ */
+template<GlObjectType Type>
+class GlHandle{
+public:
+    GlHandle(){}
+    explicit GlHandle(unsigned int id): id_(id){}
+    ~GlHandle(){ reset(); }
+
+    GlHandle(const GlHandle&) = delete;
+    GlHandle& operator=(const GlHandle&) = delete;
+
+    GlHandle(GlHandle&& other) noexcept: id_(other.id_){
+        other.id_ = 0;
+    }
+    GlHandle& operator=(GlHandle&& other) noexcept{
+        if(this != &other){
+            reset();
+            id_ = other.id_;
+            other.id_ = 0;
+        }
+        return *this;
+    }
+
+    static GlHandle create(){
+        return GlHandle(gl_create_object(Type));
+    }
+
+    // - 释放当前对象(延迟删除)并接管 id
+    void reset(unsigned int id = 0){
+        if(id_)
+            GlDeletionQueue::instance().push(Type, id_);
+        id_ = id;
+    }
+
+    // - 放弃所有权, 调用方负责删除
+    unsigned int release(){
+        unsigned int id = id_;
+        id_ = 0;
+        return id;
+    }
+
+    unsigned int id() const { return id_; }
+    operator unsigned int() const { return id_; }
+
+private:
+    unsigned int id_{0};
+};
+
+using GlBuffer = GlHandle<GlObjectType::BUFFER>;
+using GlVertexArray = GlHandle<GlObjectType::VERTEX_ARRAY>;
+using GlTexture = GlHandle<GlObjectType::TEXTURE>;
+using GlProgram = GlHandle<GlObjectType::PROGRAM>;
+using GlQuery = GlHandle<GlObjectType::QUERY>;
+
+#endif
@@ -0,0 +1,110 @@
+#include "./gl_upload_thread.h"
+
+#include <memory>
+#include <iostream>
+
+#include "../core/profiler.h"
+
+std::atomic<GlUploadThread*> GlUploadThread::instance_{nullptr};
+
+bool GlUploadThread::start(std::function<bool()> make_current, std::function<void()> release_current){
+    if(instance()){
+        std::cout << "WARN: GlUploadThread already started" << std::endl;
+        return true;
+    }
+    std::unique_ptr<GlUploadThread> upload(new GlUploadThread());
+    std::promise<bool> ready;
+    std::future<bool> ok = ready.get_future();
+    upload->thread_ = std::thread(&GlUploadThread::loop, upload.get(), std::move(make_current), std::move(release_current), &ready);
+    if(!ok.get()){
+        upload->thread_.join();
+        std::cout << "ERROR: GlUploadThread make shared context current fail, uploads stay on GL thread" << std::endl;
+        return false;
+    }
+    instance_.store(upload.release(), std::memory_order_release);
+    std::cout << "OUT: GlUploadThread started" << std::endl;
+    return true;
+}
+
+void GlUploadThread::stop(){
+    GlUploadThread* upload = instance_.exchange(nullptr);
+    if(!upload)
+        return;
+    {
+        std::lock_guard<std::mutex> lock(upload->mutex_);
+        upload->stop_ = true;
+    }
+    upload->cv_.notify_all();
+    upload->thread_.join();
+    upload->info();
+    delete upload;
+}
+
+void GlUploadThread::push(std::coroutine_handle<> handle){
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        handles_.push_back(handle);
+    }
+    cv_.notify_one();
+}
+
+void GlUploadThread::publish(std::coroutine_handle<> handle){
+    Pending pending;
+    pending.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    pending.handle = handle;
+    // - 让命令真正提交, 否则 fence 可能永远不会完成
+    glFlush();
+    fences_.push_back(pending);
+}
+
+void GlUploadThread::poll_fences(GLuint64 timeout_ns){
+    while(!fences_.empty()){
+        Pending& pending = fences_.front();
+        const GLenum result = glClientWaitSync(pending.fence, 0, timeout_ns);
+        if(result == GL_TIMEOUT_EXPIRED)
+            return;
+        if(result == GL_WAIT_FAILED)
+            std::cout << "WARN: GlUploadThread glClientWaitSync fail, publish anyway" << std::endl;
+        glDeleteSync(pending.fence);
+        GlThreadQueue::instance().push(pending.handle);
+        published_++;
+        fences_.pop_front();
+        timeout_ns = 0;
+    }
+}
+
+void GlUploadThread::loop(std::function<bool()> make_current, std::function<void()> release_current, std::promise<bool>* ready){
+    PROFILE_THREAD("upload");
+    if(!make_current()){
+        ready->set_value(false);
+        return;
+    }
+    ready->set_value(true);
+
+    while(true){
+        std::vector<std::coroutine_handle<>> handles;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if(fences_.empty())
+                cv_.wait(lock, [this](){ return stop_ || !handles_.empty(); });
+            if(stop_ && handles_.empty())
+                break;
+            handles.swap(handles_);
+        }
+        for(std::coroutine_handle<> handle : handles){
+            handle.resume();
+            resumed_++;
+        }
+        // - 有新任务时只检查不等待; 空闲时最多等 1ms 再回来看新任务
+        poll_fences(handles.empty() ? 1000000 : 0);
+    }
+    // - 退出前交出全部在途的协程, 它们在 GL 线程上还要继续
+    while(!fences_.empty())
+        poll_fences(1000000000);
+    release_current();
+}
+
+void GlUploadThread::info() const{
+    std::cout << "OUT: GlUploadThread resumed " << resumed_ << " upload steps, published " << published_
+              << " through fences" << std::endl;
+}
@@ -0,0 +1,110 @@
+#ifndef OPENGL_RENDER_GL_UPLOAD_THREAD_H_
+#define OPENGL_RENDER_GL_UPLOAD_THREAD_H_
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <future>
+#include <functional>
+#include <condition_variable>
+
+#include <glad/glad.h>
+
+#include "../core/task.h"
+
+/**
+ * 持有第二个 GL context (与渲染 context 共享对象) 的上传线程, 可选
+ * - 协程 co_await resume_on_upload_thread() 后在这里创建缓冲 / 纹理并写入数据, 渲染线程没有上传开销
+ * - co_await publish_to_gl_thread() 插入 fence 并 flush, fence 完成后协程才回到 GL 线程(GlThreadQueue),
+ *   之后渲染 context 绑定这些对象时数据已经可见
+ * - VAO / FBO 等容器对象不在 context 间共享, 仍需发布回 GL 线程后再建
+ * 未启动时两个 awaitable 都退化为 resume_on_gl_thread
+ */
+class GlUploadThread{
+public:
+    /**
+     * 启动上传线程, 返回 context 是否切换成功
+     *@ make_current: 在上传线程中调用, 使共享 context 成为当前 context (例如 GLFW 隐藏窗口)
+     *@ release_current: 线程退出前调用
+    */
+    static bool start(std::function<bool()> make_current, std::function<void()> release_current);
+
+    // - 等待在途的 fence 并交出协程后退出; 需在全部上传任务结束后、销毁共享 context 之前调用
+    static void stop();
+
+    // - 未启动时为 nullptr
+    static GlUploadThread* instance() { return instance_.load(std::memory_order_acquire); }
+
+    bool on_thread() const { return std::this_thread::get_id() == thread_.get_id(); }
+
+    void push(std::coroutine_handle<> handle);
+
+    // - 在上传线程调用
+    void publish(std::coroutine_handle<> handle);
+
+    void info() const;
+
+private:
+    GlUploadThread(){}
+
+    void loop(std::function<bool()> make_current, std::function<void()> release_current, std::promise<bool>* ready);
+
+    // - 把 fence 已完成的协程交给 GlThreadQueue; timeout_ns > 0 时等待最早的 fence
+    void poll_fences(GLuint64 timeout_ns);
+
+    struct Pending{
+        GLsync fence{nullptr};
+        std::coroutine_handle<> handle;
+    };
+
+private:
+    static std::atomic<GlUploadThread*> instance_;
+
+    std::thread thread_;
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::vector<std::coroutine_handle<>> handles_;
+    bool stop_{false};
+
+    std::deque<Pending> fences_;    // 只在上传线程访问, 按提交顺序
+
+    std::atomic<uint64_t> resumed_{0};
+    std::atomic<uint64_t> published_{0};
+};
+
+// - co_await resume_on_upload_thread(): 之后的 GL 上传在上传线程执行, 未启动时在 GL 线程
+inline auto resume_on_upload_thread(){
+    struct Awaiter{
+        bool await_ready() const{
+            GlUploadThread* upload = GlUploadThread::instance();
+            return upload ? upload->on_thread() : GlThreadQueue::instance().on_gl_thread();
+        }
+        void await_suspend(std::coroutine_handle<> handle){
+            if(GlUploadThread* upload = GlUploadThread::instance())
+                upload->push(handle);
+            else
+                GlThreadQueue::instance().push(handle);
+        }
+        void await_resume() {}
+    };
+    return Awaiter{};
+}
+
+// - co_await publish_to_gl_thread(): 上传的数据对渲染 context 可见后, 在 GL 线程继续
+inline auto publish_to_gl_thread(){
+    struct Awaiter{
+        bool await_ready() const { return GlThreadQueue::instance().on_gl_thread(); }
+        void await_suspend(std::coroutine_handle<> handle){
+            GlUploadThread* upload = GlUploadThread::instance();
+            if(upload && upload->on_thread())
+                upload->publish(handle);
+            else
+                GlThreadQueue::instance().push(handle);
+        }
+        void await_resume() {}
+    };
+    return Awaiter{};
+}
+
+#endif
@@ -0,0 +1,125 @@
+#include "./gpu_timer.h"
+
+#include <iostream>
+#include <algorithm>
+
+GpuTimer& GpuTimer::instance(){
+    static GpuTimer timer;
+    return timer;
+}
+
+bool GpuTimer::init(const unsigned int frame_count, const bool mesh_scopes){
+    if(enabled_)
+        return true;
+    // - GL_TIMESTAMP 查询是 3.3 core(ARB_timer_query); counter 位数为 0 表示实现不支持
+    GLint bits = 0;
+    if(GLAD_GL_VERSION_3_3)
+        glGetQueryiv(GL_TIMESTAMP, GL_QUERY_COUNTER_BITS, &bits);
+    if(bits == 0){
+        std::cout << "WARN: GL_TIMESTAMP query unsupported, gpu timer disabled" << std::endl;
+        return false;
+    }
+    frames_.clear();
+    frames_.resize(std::max(2u, frame_count));
+    current_ = 0;
+    mesh_scopes_ = mesh_scopes;
+    track_ = Profiler::instance().add_track("gpu");
+    enabled_ = true;
+    std::cout << "OUT: gpu timer " << frames_.size() << " frames in flight, " << bits << " bit timestamps"
+              << (mesh_scopes_ ? ", per-mesh scopes" : "") << std::endl;
+    return true;
+}
+
+void GpuTimer::shutdown(){
+    if(!enabled_)
+        return;
+    if(in_frame_)
+        end_frame();
+    for(size_t i=1; i<=frames_.size(); i++){
+        Frame& frame = frames_[(current_ + i) % frames_.size()];
+        if(frame.pending)
+            read_frame(frame, true);
+    }
+    frames_.clear();
+    enabled_ = false;
+}
+
+unsigned int GpuTimer::next_query(Frame& frame){
+    if(frame.used == frame.queries.size())
+        frame.queries.push_back(GlQuery::create());
+    return frame.queries[frame.used++];
+}
+
+void GpuTimer::begin_frame(){
+    if(!enabled_ || in_frame_)
+        return;
+    current_ = (current_ + 1) % frames_.size();
+    Frame& frame = frames_[current_];
+    if(frame.pending && !read_frame(frame, false))
+        dropped_frames_++;
+    frame.pending = false;
+    frame.used = 0;
+    frame.scopes.clear();
+    frame.open.clear();
+
+    glGetInteger64v(GL_TIMESTAMP, &frame.gpu_origin);
+    frame.cpu_origin_ns = Profiler::now_ns();
+    in_frame_ = true;
+    begin("gpu_frame");
+}
+
+void GpuTimer::end_frame(){
+    if(!enabled_ || !in_frame_)
+        return;
+    Frame& frame = frames_[current_];
+    while(!frame.open.empty())
+        end();
+    in_frame_ = false;
+    frame.pending = !frame.scopes.empty();
+}
+
+void GpuTimer::begin(const char* name){
+    if(!in_frame_)
+        return;
+    Frame& frame = frames_[current_];
+    Scope scope;
+    scope.name = name;
+    scope.begin_query = next_query(frame);
+    glQueryCounter(scope.begin_query, GL_TIMESTAMP);
+    frame.open.push_back(frame.scopes.size());
+    frame.scopes.push_back(scope);
+}
+
+void GpuTimer::end(){
+    if(!in_frame_)
+        return;
+    Frame& frame = frames_[current_];
+    if(frame.open.empty())
+        return;
+    Scope& scope = frame.scopes[frame.open.back()];
+    frame.open.pop_back();
+    scope.end_query = next_query(frame);
+    glQueryCounter(scope.end_query, GL_TIMESTAMP);
+}
+
+bool GpuTimer::read_frame(Frame& frame, const bool wait){
+    // - 查询按提交顺序完成, 最后一个就绪则全部就绪
+    if(!wait){
+        GLuint available = GL_FALSE;
+        glGetQueryObjectuiv(frame.queries[frame.used - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if(available != GL_TRUE)
+            return false;
+    }
+    Profiler& profiler = Profiler::instance();
+    for(const Scope& scope : frame.scopes){
+        GLuint64 begin = 0, end = 0;
+        glGetQueryObjectui64v(scope.begin_query, GL_QUERY_RESULT, &begin);
+        glGetQueryObjectui64v(scope.end_query, GL_QUERY_RESULT, &end);
+        // - 对齐点之前的时间戳(命令在对齐前已提交)截到对齐点, 换算结果不早于帧开始
+        const int64_t begin_offset = std::max<int64_t>(0, static_cast<int64_t>(begin) - frame.gpu_origin);
+        const int64_t end_offset = std::max<int64_t>(begin_offset, static_cast<int64_t>(end) - frame.gpu_origin);
+        profiler.record_track(track_, scope.name, frame.cpu_origin_ns + begin_offset, frame.cpu_origin_ns + end_offset);
+    }
+    frame.pending = false;
+    return true;
+}
@@ -0,0 +1,108 @@
+#ifndef OPENGL_RENDER_GPU_TIMER_H_
+#define OPENGL_RENDER_GPU_TIMER_H_
+#include <vector>
+#include <cstdint>
+
+#include "./gl_handle.h"
+#include "../core/profiler.h"
+
+/**
+ * GPU 分区计时, 结果记入 Profiler 的 "gpu" 轨道, 与 CPU zone 在同一时间线
+ * - 每个 scope 前后各一个 GL_TIMESTAMP 查询(glQueryCounter), 可以嵌套; GL_TIME_ELAPSED 不能嵌套
+ * - 查询按帧分组, frame_count 组轮换: begin_frame() 复用一组之前读取它的结果,
+ *   此时 GPU 已落后 frame_count 帧以上, 结果未就绪则丢弃这一帧而不是等待, 读取不会卡住管线
+ * - 每帧用 glGetInteger64v(GL_TIMESTAMP) 与 steady_clock 对齐一次, GPU 时间戳据此换算到 CPU 时间
+ * 只在 GL 线程使用; 软件光栅(llvmpipe)同样支持 GL 3.3 的 timer query
+ */
+class GpuTimer{
+public:
+    static GpuTimer& instance();
+
+    GpuTimer(const GpuTimer&) = delete;
+    GpuTimer& operator=(const GpuTimer&) = delete;
+
+    /**
+     * 在 GL 线程、context 就绪后调用; 不支持 timer query 时返回 false, 之后的调用都为空操作
+     *@ frame_count: 轮换的帧数, 至少 2
+     *@ mesh_scopes: 为 true 时 Model::draw 为每个 mesh 计时(查询数随 mesh 数增长)
+    */
+    bool init(const unsigned int frame_count = 2, const bool mesh_scopes = false);
+
+    // - 读取尚未读取的帧并释放查询, 销毁 context 之前调用
+    void shutdown();
+
+    bool enabled() const { return enabled_; }
+    bool mesh_scopes() const { return enabled_ && mesh_scopes_; }
+
+    // - 一帧的 GL 命令之前 / 之后调用, 整帧记为 "gpu_frame"
+    void begin_frame();
+    void end_frame();
+
+    // - name 须为静态存储的字符串; 必须成对, 且在 begin_frame / end_frame 之间
+    void begin(const char* name);
+    void end();
+
+    uint64_t dropped_frames() const { return dropped_frames_; }
+
+private:
+    GpuTimer(){}
+
+    struct Scope{
+        const char* name{nullptr};
+        unsigned int begin_query{0};
+        unsigned int end_query{0};
+    };
+
+    struct Frame{
+        std::vector<GlQuery> queries;   // 只增不减, 每帧从头复用
+        size_t used{0};
+        std::vector<Scope> scopes;
+        std::vector<size_t> open;       // 尚未 end 的 scope 下标
+        int64_t gpu_origin{0};
+        uint64_t cpu_origin_ns{0};
+        bool pending{false};            // 已提交、结果未读
+    };
+
+    unsigned int next_query(Frame& frame);
+
+    // - 结果就绪时记入 Profiler 并返回 true; wait 为 true 时阻塞等待(只在 shutdown 使用)
+    bool read_frame(Frame& frame, const bool wait);
+
+private:
+    bool enabled_{false};
+    bool mesh_scopes_{false};
+    bool in_frame_{false};
+    std::vector<Frame> frames_;
+    size_t current_{0};
+    unsigned int track_{0};
+    uint64_t dropped_frames_{0};
+};
+
+// - 作用域内的 GPU 计时; active 为 false 时不插入查询
+class GpuScope{
+public:
+    explicit GpuScope(const char* name, const bool active = true): active_(active && GpuTimer::instance().enabled()){
+        if(active_)
+            GpuTimer::instance().begin(name);
+    }
+    ~GpuScope(){
+        if(active_)
+            GpuTimer::instance().end();
+    }
+
+    GpuScope(const GpuScope&) = delete;
+    GpuScope& operator=(const GpuScope&) = delete;
+
+private:
+    bool active_;
+};
+
+#ifndef DISABLE_PROFILER
+#define GPU_ZONE(name) GpuScope PROFILE_CONCAT(gpu_zone_, __LINE__)(name)
+#define GPU_ZONE_IF(name, active) GpuScope PROFILE_CONCAT(gpu_zone_, __LINE__)(name, active)
+#else
+#define GPU_ZONE(name) ((void)0)
+#define GPU_ZONE_IF(name, active) ((void)0)
+#endif
+
+#endif
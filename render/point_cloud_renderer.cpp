@@ -0,0 +1,194 @@
+#include "./point_cloud_renderer.h"
+
+#include <cmath>
+#include <queue>
+#include <iostream>
+#include <algorithm>
+
+PointCloudRenderer::PointCloudRenderer(size_t point_budget, unsigned int slot_count, unsigned int max_uploads_per_frame):
+    point_budget_(point_budget), slot_count_(slot_count), max_uploads_per_frame_(max_uploads_per_frame){
+}
+
+PointCloudRenderer::~PointCloudRenderer(){
+    // - 等待加载任务结束, 它们还在读 octree_ 的映射内存并写 loaded_
+    JobSystem::instance().wait(loads_);
+}
+
+bool PointCloudRenderer::open(const std::string& path){
+    if(!octree_.open(path))
+        return false;
+    const size_t node_count = octree_.nodes().size();
+    state_.assign(node_count, NODE_UNLOADED);
+    slot_of_node_.assign(node_count, -1);
+    last_selected_.assign(node_count, 0);
+    node_of_slot_.assign(slot_count_, -1);
+
+    const size_t slot_bytes = static_cast<size_t>(octree_.header().points_per_node) * sizeof(PointRecord);
+    vao_ = GlVertexArray::create();
+    vbo_ = GlBuffer::create();
+    glBindVertexArray(vao_);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+    glBufferData(GL_ARRAY_BUFFER, slot_bytes * slot_count_, nullptr, GL_DYNAMIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(PointRecord), (void*)offsetof(PointRecord, pos));
+    glEnableVertexAttribArray(7);
+    glVertexAttribPointer(7, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(PointRecord), (void*)offsetof(PointRecord, color));
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    std::cout << "OUT: point cloud " << octree_.header().point_count << " points in " << node_count << " nodes, "
+              << slot_count_ << " GPU slots (" << slot_bytes * slot_count_ / (1024.0 * 1024.0) << " MB)" << std::endl;
+    return true;
+}
+
+void PointCloudRenderer::request_load(int32_t node){
+    state_[node] = NODE_LOADING;
+    pending_++;
+    JobSystem::instance().run([this, node](){
+        LoadedNode item;
+        item.node = node;
+        const PointOctreeNode& record = octree_.nodes()[node];
+        const PointRecord* points = octree_.points(record);
+        item.points.assign(points, points + record.point_count);
+        octree_.release(record);
+        std::lock_guard<std::mutex> lock(loaded_mutex_);
+        loaded_.push_back(std::move(item));
+    }, &loads_, "point_cloud_load");
+}
+
+int PointCloudRenderer::acquire_slot(){
+    int victim = -1;
+    for(unsigned int slot=0; slot<slot_count_; slot++){
+        const int32_t node = node_of_slot_[slot];
+        if(node < 0)
+            return static_cast<int>(slot);
+        // - 本帧选中的节点不淘汰
+        if(last_selected_[node] < frame_ && (victim < 0 || last_selected_[node] < last_selected_[node_of_slot_[victim]]))
+            victim = static_cast<int>(slot);
+    }
+    if(victim >= 0){
+        const int32_t node = node_of_slot_[victim];
+        state_[node] = NODE_UNLOADED;
+        slot_of_node_[node] = -1;
+        node_of_slot_[victim] = -1;
+    }
+    return victim;
+}
+
+void PointCloudRenderer::upload_loaded(){
+    const size_t slot_points = octree_.header().points_per_node;
+    glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+    for(unsigned int i=0; i<max_uploads_per_frame_; i++){
+        LoadedNode item;
+        {
+            std::lock_guard<std::mutex> lock(loaded_mutex_);
+            if(loaded_.empty())
+                break;
+            item = std::move(loaded_.front());
+            loaded_.pop_front();
+        }
+        pending_--;
+        const int slot = acquire_slot();
+        if(slot < 0){
+            // - 显存槽位全被本帧占用, 丢弃, 之后再被选中时重新加载
+            state_[item.node] = NODE_UNLOADED;
+            continue;
+        }
+        glBufferSubData(GL_ARRAY_BUFFER, slot * slot_points * sizeof(PointRecord),
+                        item.points.size() * sizeof(PointRecord), item.points.data());
+        state_[item.node] = NODE_RESIDENT;
+        slot_of_node_[item.node] = slot;
+        node_of_slot_[slot] = item.node;
+        stats_.uploads++;
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void PointCloudRenderer::update(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& camera_pos, int viewport_height){
+    frame_++;
+    selected_.clear();
+    stats_ = Stats();
+    const std::vector<PointOctreeNode>& nodes = octree_.nodes();
+    if(nodes.empty())
+        return;
+
+    // - 视锥六个平面: clip = vp * p, 由 vp 的行组合得到
+    const glm::mat4 vp = projection * view;
+    float planes[6][4];
+    for(int axis=0; axis<3; axis++){
+        for(int c=0; c<4; c++){
+            planes[axis * 2][c] = vp[c][3] + vp[c][axis];
+            planes[axis * 2 + 1][c] = vp[c][3] - vp[c][axis];
+        }
+    }
+    auto in_frustum = [&planes](const PointOctreeNode& node){
+        for(const float* plane : planes){
+            float d = plane[3];
+            for(int k=0; k<3; k++)
+                d += plane[k] * (plane[k] >= 0.0f ? node.min[k] + node.size : node.min[k]);
+            if(d < 0.0f)
+                return false;
+        }
+        return true;
+    };
+    // - 包围球半径与距离之比乘投影焦距, 换算为屏幕像素; 相机在球内时视为无限大
+    const float pixel_scale = projection[1][1] * viewport_height * 0.5f;
+    auto projected_pixels = [&camera_pos, pixel_scale](const PointOctreeNode& node){
+        const float half = node.size * 0.5f;
+        const float dx = node.min[0] + half - camera_pos.x;
+        const float dy = node.min[1] + half - camera_pos.y;
+        const float dz = node.min[2] + half - camera_pos.z;
+        const float distance = std::sqrt(dx * dx + dy * dy + dz * dz);
+        const float radius = half * 1.7320508f;
+        return distance <= radius ? 1e30f : radius / distance * pixel_scale;
+    };
+
+    std::priority_queue<std::pair<float, int32_t>> queue;
+    if(in_frustum(nodes[0]))
+        queue.push({projected_pixels(nodes[0]), 0});
+    while(!queue.empty() && selected_.size() < slot_count_){
+        const int32_t index = queue.top().second;
+        queue.pop();
+        const PointOctreeNode& node = nodes[index];
+        if(stats_.selected_points + node.point_count > point_budget_)
+            break;
+        selected_.push_back(index);
+        stats_.selected_points += node.point_count;
+        last_selected_[index] = frame_;
+        if(state_[index] == NODE_UNLOADED && pending_ < max_pending_loads_)
+            request_load(index);
+
+        for(int32_t child : node.children){
+            if(child < 0 || !in_frustum(nodes[child]))
+                continue;
+            const float pixels = projected_pixels(nodes[child]);
+            if(pixels >= min_node_pixels_)
+                queue.push({pixels, child});
+        }
+    }
+    stats_.selected_nodes = selected_.size();
+
+    upload_loaded();
+    stats_.pending_loads = pending_;
+    for(int32_t node : node_of_slot_)
+        stats_.resident_nodes += node >= 0;
+}
+
+void PointCloudRenderer::draw(){
+    if(!vao_)
+        return;
+    const size_t slot_points = octree_.header().points_per_node;
+    glPointSize(point_size_);
+    glBindVertexArray(vao_);
+    stats_.drawn_nodes = 0;
+    stats_.drawn_points = 0;
+    for(int32_t node : selected_){
+        if(state_[node] != NODE_RESIDENT)
+            continue;
+        const uint32_t count = octree_.nodes()[node].point_count;
+        glDrawArrays(GL_POINTS, static_cast<GLint>(slot_of_node_[node] * slot_points), count);
+        stats_.drawn_nodes++;
+        stats_.drawn_points += count;
+    }
+    glBindVertexArray(0);
+}
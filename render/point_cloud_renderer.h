@@ -0,0 +1,97 @@
+#ifndef OPENGL_RENDER_POINT_CLOUD_RENDERER_H_
+#define OPENGL_RENDER_POINT_CLOUD_RENDERER_H_
+#include <deque>
+#include <mutex>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "../io/point_octree.h"
+#include "../core/job_system.h"
+#include "./gl_handle.h"
+
+/**
+ * 八叉树点云的 LOD 渲染, 数据量可远大于显存
+ * - update(): 按节点投影尺寸从大到小遍历, 视锥外与过小的节点跳过, 累计点数不超过 point_budget
+ * - 选中但不在显存的节点提交 JobSystem 任务从 mmap 读出, 之后每帧最多上传 max_uploads_per_frame 个
+ * - 显存为 slot_count 个固定大小的槽位(每槽 points_per_node 个点), 满时淘汰最久未被选中的节点
+ * 每帧的遍历、上传与绘制都有上限, 帧时间与数据集大小无关
+ */
+class PointCloudRenderer{
+public:
+    struct Stats{
+        size_t selected_nodes{0};
+        size_t selected_points{0};
+        size_t drawn_nodes{0};
+        size_t drawn_points{0};
+        size_t resident_nodes{0};
+        size_t pending_loads{0};
+        size_t uploads{0};
+    };
+
+    PointCloudRenderer(size_t point_budget = 2000000, unsigned int slot_count = 512, unsigned int max_uploads_per_frame = 8);
+    ~PointCloudRenderer();
+
+    PointCloudRenderer(const PointCloudRenderer&) = delete;
+    PointCloudRenderer& operator=(const PointCloudRenderer&) = delete;
+
+    bool open(const std::string& path);
+
+    /// @brief 选择本帧绘制的节点, 上传已加载完成的节点, 为缺失的节点发起加载
+    /// @param viewport_height 像素高度, 与投影矩阵一起换算节点的屏幕尺寸
+    void update(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& camera_pos, int viewport_height);
+
+    // - 绘制 update 选中且已在显存的节点, shader 由调用方绑定 (位置 location 0, 颜色 location 7)
+    void draw();
+
+    const Stats& stats() const { return stats_; }
+
+public:
+    float point_size_{2.0f};
+    float min_node_pixels_{32.0f};    // 投影尺寸小于该值的节点及其子树不绘制
+
+private:
+    enum NodeState : unsigned char{
+        NODE_UNLOADED = 0,
+        NODE_LOADING,
+        NODE_RESIDENT
+    };
+
+    struct LoadedNode{
+        int32_t node;
+        std::vector<PointRecord> points;
+    };
+
+    void request_load(int32_t node);
+
+    void upload_loaded();
+
+    int acquire_slot();
+
+private:
+    PointOctree octree_;
+    size_t point_budget_;
+    unsigned int slot_count_;
+    unsigned int max_uploads_per_frame_;
+    size_t max_pending_loads_{32};
+
+    GlVertexArray vao_;
+    GlBuffer vbo_;
+
+    std::vector<NodeState> state_;
+    std::vector<int> slot_of_node_;
+    std::vector<int32_t> node_of_slot_;
+    std::vector<uint64_t> last_selected_;   // 节点最近一次被选中的帧号
+    uint64_t frame_{0};
+
+    std::vector<int32_t> selected_;
+    Stats stats_;
+
+    JobCounter loads_;      // 在途的加载任务, 析构时等待
+    std::mutex loaded_mutex_;
+    std::deque<LoadedNode> loaded_;
+    size_t pending_{0};
+};
+
+#endif
@@ -0,0 +1,136 @@
+#include "./ring_buffer.h"
+
+#include <iostream>
+
+namespace {
+
+size_t align_up(size_t value, size_t alignment){
+    if(alignment <= 1)
+        return value;
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+}
+
+RingBuffer::RingBuffer(GLenum target, size_t frame_size, unsigned int frame_count):
+    target_(target), frame_size_(frame_size), frame_count_(frame_count), fences_(frame_count, nullptr){
+
+    const size_t total_size = frame_size_ * frame_count_;
+
+    buffer_ = GlBuffer::create();
+    glBindBuffer(target_, buffer_);
+
+    if(GLAD_GL_VERSION_4_4){
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(target_, total_size, nullptr, flags);
+        mapped_ = static_cast<unsigned char*>(glMapBufferRange(target_, 0, total_size, flags));
+        persistent_ = mapped_ != nullptr;
+        if(!persistent_){
+            std::cout << "WARN: RingBuffer persistent map fail, fallback to glMapBufferRange" << std::endl;
+        }
+    }
+
+    if(!persistent_){
+        // - 不可变存储一旦创建就不能 glBufferData, 失败时重建 buffer
+        if(GLAD_GL_VERSION_4_4){
+            glBindBuffer(target_, 0);
+            buffer_ = GlBuffer::create();
+            glBindBuffer(target_, buffer_);
+        }
+        glBufferData(target_, total_size, nullptr, GL_STREAM_DRAW);
+        mapped_ = nullptr;
+    }
+
+    glBindBuffer(target_, 0);
+}
+
+RingBuffer::~RingBuffer(){
+    // - 可能晚于 context 销毁, 不调用 GL; buffer_ 析构时同样交给队列
+    for(size_t i=0; i<fences_.size(); i++)
+        GlDeletionQueue::instance().push_fence(fences_[i]);
+}
+
+void RingBuffer::wait_fence(GLsync& fence){
+    if(!fence)
+        return;
+
+    // - 先不 flush 地探测一次, 大多数情况下 GPU 早已完成
+    GLenum result = glClientWaitSync(fence, 0, 0);
+    while(result == GL_TIMEOUT_EXPIRED){
+        result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000); // 1ms
+    }
+    if(result == GL_WAIT_FAILED){
+        std::cout << "ERROR: RingBuffer glClientWaitSync fail" << std::endl;
+    }
+
+    glDeleteSync(fence);
+    fence = nullptr;
+}
+
+void RingBuffer::begin_frame(){
+    if(in_frame_){
+        end_frame();
+    }
+
+    frame_index_ = (frame_index_ + 1) % frame_count_;
+    wait_fence(fences_[frame_index_]);
+
+    head_ = 0;
+    in_frame_ = true;
+}
+
+void* RingBuffer::allocate(size_t size, size_t alignment, size_t& offset){
+    if(!in_frame_){
+        begin_frame();
+    }
+
+    const size_t frame_start = frame_index_ * frame_size_;
+    const size_t start = align_up(frame_start + head_, alignment) - frame_start;
+    if(start + size > frame_size_){
+        std::cout << "ERROR: RingBuffer out of space, frame_size " << frame_size_
+                  << ", request " << size << std::endl;
+        return nullptr;
+    }
+
+    offset = frame_start + start;
+    head_ = start + size;
+
+    if(persistent_){
+        return mapped_ + offset;
+    }
+
+    // - 非持久映射: 映射本帧剩余区间, 该段已由 fence 保护, 可以 UNSYNCHRONIZED
+    if(!mapped_){
+        mapped_start_ = offset;
+        glBindBuffer(target_, buffer_);
+        mapped_ = static_cast<unsigned char*>(glMapBufferRange(target_, mapped_start_, frame_start + frame_size_ - mapped_start_,
+                            GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT));
+        glBindBuffer(target_, 0);
+        if(!mapped_){
+            std::cout << "ERROR: RingBuffer glMapBufferRange fail" << std::endl;
+            return nullptr;
+        }
+    }
+    return mapped_ + (offset - mapped_start_);
+}
+
+void RingBuffer::flush(){
+    if(persistent_ || !mapped_)
+        return;
+
+    glBindBuffer(target_, buffer_);
+    glUnmapBuffer(target_);
+    glBindBuffer(target_, 0);
+    mapped_ = nullptr;
+}
+
+void RingBuffer::end_frame(){
+    if(!in_frame_)
+        return;
+
+    flush();
+    if(fences_[frame_index_])
+        glDeleteSync(fences_[frame_index_]);
+    fences_[frame_index_] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    in_frame_ = false;
+}
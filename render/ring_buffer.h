@@ -0,0 +1,64 @@
+#ifndef OPENGL_RENDER_RING_BUFFER_H_
+#define OPENGL_RENDER_RING_BUFFER_H_
+#include <cstddef>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "./gl_handle.h"
+
+/**
+ * 每帧动态数据(uniform / instance / 临时顶点)的环形分配器
+ * - GL 4.4+ : glBufferStorage + 持久映射(PERSISTENT | COHERENT), CPU 直接写入 GPU 可见内存
+ * - 低版本  : 按需 glMapBufferRange(UNSYNCHRONIZED), flush() 时 unmap
+ * 缓冲区被切成 frame_count 段, 每段在 end_frame() 时插入 fence,
+ * 下次轮到该段时 begin_frame() 等待 fence, 保证 GPU 已经用完再覆盖
+ * 析构不调用 GL: buffer 与 fence 交给 GlDeletionQueue, 删除 buffer 时隐式解除映射
+ */
+class RingBuffer{
+public:
+    RingBuffer(GLenum target, size_t frame_size, unsigned int frame_count = 3);
+    ~RingBuffer();
+
+    RingBuffer(const RingBuffer&) = delete;
+    RingBuffer& operator=(const RingBuffer&) = delete;
+
+    // - 切换到下一段, 必要时等待 GPU 释放该段
+    void begin_frame();
+
+    /// @brief 在当前帧段中分配 size 字节
+    /// @param offset 输出: 相对 buffer 起点的偏移, 用于 glBindBufferRange / 顶点指针
+    /// @return 可写指针, 空间不足时返回 nullptr
+    void* allocate(size_t size, size_t alignment, size_t& offset);
+
+    // - 非持久映射时需在 draw 之前调用, 持久映射为空操作
+    void flush();
+
+    // - 当前帧提交完毕, 插入 fence
+    void end_frame();
+
+    unsigned int buffer_id() const { return buffer_.id(); }
+    GLenum target() const { return target_; }
+    bool persistent() const { return persistent_; }
+    size_t frame_size() const { return frame_size_; }
+
+private:
+    void wait_fence(GLsync& fence);
+
+private:
+    GLenum target_;
+    GlBuffer buffer_;
+    size_t frame_size_;
+    unsigned int frame_count_;
+    bool persistent_{false};
+
+    unsigned char* mapped_{nullptr};   // 持久映射时为整个 buffer 的起点; 否则为当前映射区间起点
+    size_t mapped_start_{0};           // 非持久映射时, 当前映射区间的偏移
+
+    unsigned int frame_index_{0};
+    size_t head_{0};                   // 当前帧段内已用字节
+    bool in_frame_{false};
+    std::vector<GLsync> fences_;
+};
+
+#endif
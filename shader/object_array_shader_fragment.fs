@@ -0,0 +1,63 @@
+#version 430 core
+in vec3 arg_world_coord;
+in vec3 arg_world_normal;
+in vec2 arg_tex_coord;
+
+out vec4 FragColor;
+
+
+// 按角色打包的纹理数组, 由 Model::draw_batched 一次绑定
+uniform sampler2DArray tex_diffuse_array;
+uniform sampler2DArray tex_specular_array;
+uniform sampler2DArray tex_normal_array;
+uniform sampler2DArray tex_height_array;
+
+// layers: diffuse, specular, normal, height 的 layer 序号, -1 表示材质没有该贴图
+struct Material{
+    ivec4 layers;
+};
+
+layout (std430, binding = 1) readonly buffer MaterialBlock{
+    Material materials[];
+};
+
+uniform int material_index;
+
+layout (std140) uniform FrameBlock{
+    mat4 model_mat;
+    mat4 view_mat;
+    mat4 projection_mat;
+    mat4 normal_model_mat;
+    vec4 light_pos;
+    vec4 camera_pos;
+};
+
+
+vec4 sample_layer(sampler2DArray tex, int layer){
+    if(layer < 0)
+        return vec4(0.0);
+    return texture(tex, vec3(arg_tex_coord, float(layer)));
+}
+
+void main()
+{    
+    float ratio = 0.25;
+    ivec4 layers = materials[material_index].layers;
+    vec3 light_dir = normalize(light_pos.xyz - arg_world_coord);
+    vec3 camera_dir = normalize(camera_pos.xyz - arg_world_coord);
+
+
+    vec3 diffusion = vec3(sample_layer(tex_diffuse_array, layers.x)) * ratio;
+    diffusion *= max(dot(light_dir, normalize(arg_world_normal)), 0.0);
+
+    vec3 specular = vec3(sample_layer(tex_specular_array, layers.y)) * ratio;
+    vec3 ref_dir = reflect(light_dir, normalize(arg_world_normal));
+    specular *= pow(dot(ref_dir, camera_dir), 32);
+
+
+    
+    FragColor = vec4(diffusion, 1.0) + vec4(specular, 1.0) + 
+                sample_layer(tex_normal_array, layers.z) * ratio +
+                sample_layer(tex_height_array, layers.w) * ratio;
+
+}
@@ -0,0 +1,30 @@
+#version 430 core
+layout (location = 0) in vec3 in_pos;
+layout (location = 1) in vec3 in_normal;
+layout (location = 2) in vec2 in_tex_coord;
+
+
+out vec3 arg_world_coord;
+out vec3 arg_world_normal;
+out vec3 arg_normal;
+out vec2 arg_tex_coord;
+
+// 每帧数据, 由 RingBuffer 写入, 布局与 main.cpp 中 FrameUniforms 一致
+layout (std140) uniform FrameBlock{
+    mat4 model_mat;
+    mat4 view_mat;
+    mat4 projection_mat;
+    mat4 normal_model_mat;
+    vec4 light_pos;
+    vec4 camera_pos;
+};
+
+void main()
+{
+    arg_world_coord = vec3(normal_model_mat * vec4(in_pos, 1.0));
+    arg_world_normal = vec3(normal_model_mat * vec4(in_normal, 1.0));
+    arg_tex_coord = in_tex_coord;
+
+    gl_Position = projection_mat * view_mat * model_mat * vec4(in_pos, 1.0);
+    // gl_Position = vec4(in_pos, 1.0);
+}
\ No newline at end of file
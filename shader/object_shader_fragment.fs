@@ -12,8 +12,20 @@ uniform sampler2D tex_specular1;
 uniform sampler2D tex_normal1;
 uniform sampler2D tex_height1;
 
-uniform vec3 light_pos;
-uniform vec3 camera_pos;
+#ifdef PACKED_CHANNELS
+// 单通道贴图打包: packed_channels 为 specular / height 所在通道, -1 表示未打包
+uniform sampler2D tex_packed1;
+uniform ivec2 packed_channels;
+#endif
+
+layout (std140) uniform FrameBlock{
+    mat4 model_mat;
+    mat4 view_mat;
+    mat4 projection_mat;
+    mat4 normal_model_mat;
+    vec4 light_pos;
+    vec4 camera_pos;
+};
 
 
 
@@ -22,14 +34,24 @@ void main()
     float ratio = 0.25;
     // FragColor = texture(texture_diffuse1, TexCoords);
     // FragColor = vec4(1.0, 1.0, 1.0, 1.0);
-    vec3 light_dir = normalize(light_pos - arg_world_coord);
-    vec3 camera_dir = normalize(camera_pos - arg_world_coord);
+    vec3 light_dir = normalize(light_pos.xyz - arg_world_coord);
+    vec3 camera_dir = normalize(camera_pos.xyz - arg_world_coord);
 
 
     vec3 diffusion = vec3(texture(tex_diffuse1, arg_tex_coord)) * ratio;
     diffusion *= max(dot(light_dir, normalize(arg_world_normal)), 0.0);
 
-    vec3 specular = vec3(texture(tex_specular1, arg_tex_coord)) * ratio;
+    vec4 specular_tex = texture(tex_specular1, arg_tex_coord);
+    vec4 height_tex = texture(tex_height1, arg_tex_coord);
+#ifdef PACKED_CHANNELS
+    vec4 packed_tex = texture(tex_packed1, arg_tex_coord);
+    if(packed_channels.x >= 0)
+        specular_tex = vec4(vec3(packed_tex[packed_channels.x]), 1.0);
+    if(packed_channels.y >= 0)
+        height_tex = vec4(vec3(packed_tex[packed_channels.y]), 1.0);
+#endif
+
+    vec3 specular = vec3(specular_tex) * ratio;
     vec3 ref_dir = reflect(light_dir, normalize(arg_world_normal));
     specular *= pow(dot(ref_dir, camera_dir), 32);
 
@@ -37,6 +59,6 @@ void main()
     
     FragColor = vec4(diffusion, 1.0) + vec4(specular, 1.0) + 
                 texture(tex_normal1, arg_tex_coord) * ratio +
-                texture(tex_height1, arg_tex_coord) * ratio;
+                height_tex * ratio;
 
 }
\ No newline at end of file
@@ -9,10 +9,15 @@ out vec3 arg_world_normal;
 out vec3 arg_normal;
 out vec2 arg_tex_coord;
 
-uniform mat4 model_mat;
-uniform mat4 view_mat;
-uniform mat4 projection_mat;
-uniform mat4 normal_model_mat;
+// 每帧数据, 由 RingBuffer 写入, 布局与 main.cpp 中 FrameUniforms 一致
+layout (std140) uniform FrameBlock{
+    mat4 model_mat;
+    mat4 view_mat;
+    mat4 projection_mat;
+    mat4 normal_model_mat;
+    vec4 light_pos;
+    vec4 camera_pos;
+};
 
 void main()
 {
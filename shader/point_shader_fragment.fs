@@ -0,0 +1,9 @@
+#version 330 core
+in vec4 arg_color;
+
+out vec4 FragColor;
+
+void main()
+{
+    FragColor = vec4(arg_color.rgb, 1.0);
+}
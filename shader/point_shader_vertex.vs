@@ -0,0 +1,22 @@
+#version 330 core
+layout (location = 0) in vec3 in_pos;
+layout (location = 7) in vec4 in_color;
+
+out vec4 arg_color;
+
+// 每帧数据, 由 RingBuffer 写入, 布局与 main.cpp 中 FrameUniforms 一致
+layout (std140) uniform FrameBlock{
+    mat4 model_mat;
+    mat4 view_mat;
+    mat4 projection_mat;
+    mat4 normal_model_mat;
+    vec4 light_pos;
+    vec4 camera_pos;
+};
+
+void main()
+{
+    // 扫描点云已在世界坐标下, 不使用 model_mat, 与 PointCloudRenderer 的视锥裁剪一致
+    arg_color = in_color;
+    gl_Position = projection_mat * view_mat * vec4(in_pos, 1.0);
+}
@@ -1,23 +1,31 @@
 #include "./shader.h"
 
+#include <algorithm>
 #include <iostream>
-#include <fstream>
-#include <sstream>
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
+#include "../io/vfs.h"
+#include "../core/profiler.h"
+
 
 /// @brief Shader 初始化—————在这里初始化不是好策略，后调整到init 中；
 /// @param path_map 
-Shader::Shader(const PathMap& path_map){
+Shader::Shader(const PathMap& path_map, const std::vector<std::string>& defines){
     // - 读取 shader 源文件
     std::cout << "Read: " << path_map.at("vertex") << std::endl;
-    const std::string vertex_source = read_file(path_map.at("vertex"));
-    const char* c_vertex_source = vertex_source.c_str();
+    const std::string vertex_source = add_defines(read_file(path_map.at("vertex")), defines);
 
     std::cout << "Read: " << path_map.at("frag") << std::endl;
-    const std::string frag_source = read_file(path_map.at("frag"));    
+    const std::string frag_source = add_defines(read_file(path_map.at("frag")), defines);    
+
+    compile(vertex_source, frag_source);
+}
+
+void Shader::compile(const std::string& vertex_source, const std::string& frag_source){
+    PROFILE_ZONE("shader_compile");
+    const char* c_vertex_source = vertex_source.c_str();
     const char* c_frag_source = frag_source.c_str();
 
     // const char* c_vertex_source = "#version 330 core\n"
@@ -72,37 +80,52 @@ Shader::Shader(const PathMap& path_map){
         exit(-1);
     }
 
-    shader_program_ = shader_program;   
+    shader_program_.reset(shader_program);
+    packed_channels_location_ = glGetUniformLocation(shader_program, "packed_channels");
+    std::fill(packed_channels_, packed_channels_ + 2, 0);
 
     glDeleteShader(vertex_shader);
     glDeleteShader(frag_shader);
 }
 
 std::string Shader::read_file(const std::string& path){
-    std::ifstream fp;
-    fp.exceptions (std::ifstream::failbit | std::ifstream::badbit);
-    try{
-        fp.open(path);
-        std::stringstream shader_str;
-        shader_str << fp.rdbuf();
-        fp.close();
-        return shader_str.str();
-
-    }
-    catch(std::ifstream::failure& e){
-        std::cout << "ERROR: read shader file fail, info " << e.what() << std::endl;
+    // - 经 Vfs mmap 读取, path 可以是挂载点下的虚拟路径
+    MappedFile file = Vfs::instance().map(path);
+    if(!file.valid()){
+        std::cout << "ERROR: read shader file fail, path " << path << std::endl;
+        return "";
     }
+    return std::string(reinterpret_cast<const char*>(file.data()), file.size());
 }
 
 
 
+std::string Shader::add_defines(const std::string& source, const std::vector<std::string>& defines){
+    if(defines.empty())
+        return source;
+
+    std::string define_lines;
+    for(const std::string& define : defines)
+        define_lines += "#define " + define + "\n";
+
+    // - #version 必须是第一条语句, 宏放在其后
+    size_t pos = 0;
+    if(source.compare(0, 8, "#version") == 0){
+        pos = source.find('\n');
+        pos = pos == std::string::npos ? source.size() : pos + 1;
+    }
+    std::string out = source;
+    out.insert(pos, define_lines);
+    return out;
+}
+
 void Shader::use(){
     glUseProgram(shader_program_);
 }
 
 
+// - program 由 GlProgram 交给 GlDeletionQueue, 析构时不调用 GL, context 销毁后析构也安全
 Shader::~Shader(){
-    // glDeleteProgram(shader_program_); // segment_fault 
 }
 
 void Shader::set_bool(const std::string& name, const bool value){
@@ -123,4 +146,23 @@ void Shader::set_mat4(const std::string& name, const float* mat4){
 
 void Shader::set_vec3(const std::string& name, const float* vec3){
     glUniform3fv(glGetUniformLocation(shader_program_, name.c_str()), 1, vec3);
+}
+
+void Shader::set_packed_channels(const int specular, const int height){
+    if(packed_channels_location_ < 0)
+        return;
+    if(packed_channels_[0] == specular && packed_channels_[1] == height)
+        return;
+    glUniform2i(packed_channels_location_, specular, height);
+    packed_channels_[0] = specular;
+    packed_channels_[1] = height;
+}
+
+void Shader::bind_uniform_block(const std::string& name, const unsigned int binding){
+    unsigned int block_index = glGetUniformBlockIndex(shader_program_, name.c_str());
+    if(block_index == GL_INVALID_INDEX){
+        std::cout << "WARN: uniform block not found, name " << name << std::endl;
+        return;
+    }
+    glUniformBlockBinding(shader_program_, block_index, binding);
 }
\ No newline at end of file
@@ -1,16 +1,27 @@
 #ifndef OPENGL_INIT_SHADER_H_
 #define OPENGL_INIT_SHADER_H_
 #include <string>
+#include <vector>
 #include <unordered_map>
 
+#include "../render/gl_handle.h"
+
 class Shader{
 public:
     using PathMap = std::unordered_map<std::string, const std::string>;
 public:
-    Shader(const PathMap& path_map);
+    // - defines: shader 变体宏, 插入到 #version 之后, 例如 {"PACKED_CHANNELS"}
+    Shader(const PathMap& path_map, const std::vector<std::string>& defines = {});
+    // - 空 shader, 之后 compile(); 异步加载在其它线程读源码, 回到 GL 线程再编译
+    Shader(){}
     ~Shader();
-    
-    std::string read_file(const std::string& path);
+
+    // - 编译链接, 失败时退出; 需在 GL 线程
+    void compile(const std::string& vertex_source, const std::string& frag_source);
+
+    static std::string read_file(const std::string& path);
+
+    static std::string add_defines(const std::string& source, const std::vector<std::string>& defines);
 
     void use();
     void set_bool(const std::string& name, const bool value);
@@ -19,8 +30,18 @@ public:
     void set_mat4(const std::string& name, const float* mat4);
     void set_vec3(const std::string& name, const float* vec3);
 
+    // - 将 uniform block 绑定到 binding 点, 配合 glBindBufferRange 使用
+    void bind_uniform_block(const std::string& name, const unsigned int binding);
+
+    // - PACKED_CHANNELS 变体的 packed_channels, 位置在链接后查询一次, 值与上次相同时不调用 GL; 普通 shader 中没有该 uniform, 无效果
+    void set_packed_channels(const int specular, const int height);
+
 public:
-    unsigned int shader_program_;
+    GlProgram shader_program_;
+
+private:
+    int packed_channels_location_{-1};
+    int packed_channels_[2]{0, 0};   // - 链接后 uniform 的初值为 0
 
 };
 #endif
\ No newline at end of file
@@ -0,0 +1,98 @@
+#include "./atlas_packer.h"
+
+#include <limits>
+#include <algorithm>
+
+SkylinePacker::SkylinePacker(const int width, const int height):
+    width_(width), height_(height){
+    skyline_.push_back({0, 0, width_});
+}
+
+int SkylinePacker::fit(const size_t index, const int width, const int height) const{
+    int x = skyline_[index].x;
+    if(x + width > width_)
+        return -1;
+
+    // - 矩形跨越的所有节点中取最高的 y
+    int width_left = width;
+    int y = skyline_[index].y;
+    size_t i = index;
+    while(width_left > 0){
+        if(i >= skyline_.size())
+            return -1;
+        y = std::max(y, skyline_[i].y);
+        if(y + height > height_)
+            return -1;
+        width_left -= skyline_[i].width;
+        i++;
+    }
+    return y;
+}
+
+bool SkylinePacker::insert(const int width, const int height, AtlasRect& rect){
+    if(width <= 0 || height <= 0)
+        return false;
+
+    int best_y = std::numeric_limits<int>::max();
+    int best_width = std::numeric_limits<int>::max();
+    size_t best_index = skyline_.size();
+
+    // - bottom-left: y 最小优先, 相同时取节点宽度最小
+    for(size_t i=0; i<skyline_.size(); i++){
+        int y = fit(i, width, height);
+        if(y < 0)
+            continue;
+        if(y + height < best_y || (y + height == best_y && skyline_[i].width < best_width)){
+            best_y = y + height;
+            best_width = skyline_[i].width;
+            best_index = i;
+            rect.x = skyline_[i].x;
+            rect.y = y;
+        }
+    }
+
+    if(best_index == skyline_.size())
+        return false;
+
+    rect.width = width;
+    rect.height = height;
+    add_level(best_index, rect);
+
+    used_area_ += static_cast<size_t>(width) * height;
+    used_width_ = std::max(used_width_, rect.x + width);
+    used_height_ = std::max(used_height_, rect.y + height);
+    return true;
+}
+
+void SkylinePacker::add_level(const size_t index, const AtlasRect& rect){
+    skyline_.insert(skyline_.begin() + index, {rect.x, rect.y + rect.height, rect.width});
+
+    // - 裁掉被新节点覆盖的部分
+    for(size_t i = index + 1; i < skyline_.size(); i++){
+        SkylineNode& prev = skyline_[i - 1];
+        SkylineNode& node = skyline_[i];
+        if(node.x >= prev.x + prev.width)
+            break;
+
+        int shrink = prev.x + prev.width - node.x;
+        node.x += shrink;
+        node.width -= shrink;
+        if(node.width > 0)
+            break;
+        skyline_.erase(skyline_.begin() + i);
+        i--;
+    }
+
+    // - 合并同高度的相邻节点
+    for(size_t i = 0; i + 1 < skyline_.size(); i++){
+        if(skyline_[i].y == skyline_[i + 1].y){
+            skyline_[i].width += skyline_[i + 1].width;
+            skyline_.erase(skyline_.begin() + i + 1);
+            i--;
+        }
+    }
+}
+
+float SkylinePacker::occupancy() const{
+    return static_cast<float>(used_area_) / (static_cast<float>(width_) * height_);
+}
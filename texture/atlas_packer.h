@@ -0,0 +1,56 @@
+#ifndef OPENGL_TEXTURE_ATLAS_PACKER_H_
+#define OPENGL_TEXTURE_ATLAS_PACKER_H_
+
+#include <cstddef>
+#include <vector>
+
+struct AtlasRect{
+    int x{0};
+    int y{0};
+    int width{0};
+    int height{0};
+};
+
+/**
+ * skyline 装箱 (bottom-left), 用于把小贴图合并到一张 atlas
+ * 只负责计算位置, 不涉及像素与 GL
+ */
+class SkylinePacker{
+public:
+    SkylinePacker(const int width, const int height);
+
+    /// @brief 放入 width x height 的矩形, 失败(空间不足)返回 false
+    bool insert(const int width, const int height, AtlasRect& rect);
+
+    // - 已占用面积 / 总面积
+    float occupancy() const;
+
+    // - 实际用到的范围, 可用于裁剪 atlas
+    int used_width() const { return used_width_; }
+    int used_height() const { return used_height_; }
+
+    int width() const { return width_; }
+    int height() const { return height_; }
+
+private:
+    struct SkylineNode{
+        int x;
+        int y;
+        int width;
+    };
+
+    // - 以 index 节点为左端放置时的高度, 放不下返回 -1
+    int fit(const size_t index, const int width, const int height) const;
+
+    void add_level(const size_t index, const AtlasRect& rect);
+
+private:
+    int width_;
+    int height_;
+    size_t used_area_{0};
+    int used_width_{0};
+    int used_height_{0};
+    std::vector<SkylineNode> skyline_;
+};
+
+#endif
@@ -7,8 +7,7 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
-#define STB_IMAGE_IMPLEMENTATION
-#include "../io/stb_image.h"
+#include "./texture_manager.h"
 
 class Texture{
 public:
@@ -16,6 +15,9 @@ public:
 
     ~Texture();
 
+    Texture(const Texture&) = delete;
+    Texture& operator=(const Texture&) = delete;
+
     void use();
 
 public:
@@ -24,49 +26,14 @@ public:
 };
 
 
+// - 与 Model 共用 TextureManager: 格式按实际通道数决定, 相同内容只上传一次
 Texture::Texture(const std::string& img_path){
-    unsigned int texture;
-    glGenTextures(1, &texture);
-    glBindTexture(GL_TEXTURE_2D, texture);
-
-    // 设置纹理对象环绕、过滤方式
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-    unsigned int color_format;
-    if(img_path.rfind("jpg") != -1){
-        color_format = GL_RGB;
-    }
-    else if(img_path.rfind("png") != -1){
-        color_format = GL_RGBA;
-    }else{
-        std::cout << " error color_format " << img_path << std::endl;
-        exit(-1);
-    };
-
-    // 加载纹理
-    int width, height, nrChannels;
-    unsigned char *data = stbi_load(img_path.c_str(), &width, &height, &nrChannels, 0);
-    if(data){
-        glTexImage2D(GL_TEXTURE_2D, 0, color_format, width, height, 0, color_format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        std::cout << "Read " << img_path << ", width "<< width << ", height " << height << ", nrChannels" << nrChannels << std::endl;
-    }
-    else
-    {
-        std::cout << "ERROR: Read image fail, path " << img_path << std::endl;
-    }
-
-
-    stbi_image_free(data);
-    texture_ = texture;
-
+    texture_ = TextureManager::instance().acquire(img_path);
 }
 
 Texture::~Texture(){
+    if(texture_)
+        TextureManager::instance().release(texture_);
 }
 
 void Texture::use(){
@@ -0,0 +1,97 @@
+#include "./texture_array.h"
+
+#include <cmath>
+#include <algorithm>
+#include <iostream>
+
+namespace {
+
+int mip_levels(int width, int height){
+    int levels = 1;
+    int size = std::max(width, height);
+    while(size > 1){
+        size >>= 1;
+        levels++;
+    }
+    return levels;
+}
+
+}
+
+TextureArray::TextureArray(const int width, const int height, const int layers):
+    width_(width), height_(height), layers_(layers){
+
+    id_ = GlTexture::create();
+    glBindTexture(GL_TEXTURE_2D_ARRAY, id_);
+
+    // 设置纹理对象环绕、过滤方式
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    if(GLAD_GL_VERSION_4_2){
+        glTexStorage3D(GL_TEXTURE_2D_ARRAY, mip_levels(width_, height_), GL_RGBA8, width_, height_, layers_);
+    }else{
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, width_, height_, layers_, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    }
+
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+void TextureArray::upload_layer(const int layer, const unsigned char* rgba){
+    if(layer < 0 || layer >= layers_){
+        std::cout << "ERROR: TextureArray layer out of range " << layer << std::endl;
+        return;
+    }
+    glBindTexture(GL_TEXTURE_2D_ARRAY, id_);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, width_, height_, 1, GL_RGBA, GL_UNSIGNED_BYTE, rgba);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+void TextureArray::generate_mipmap(){
+    glBindTexture(GL_TEXTURE_2D_ARRAY, id_);
+    glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+void TextureArray::bind(const unsigned int unit) const{
+    glActiveTexture(GL_TEXTURE0 + unit);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, id_);
+}
+
+
+std::vector<unsigned char> resample_rgba8(const unsigned char* src, const int src_w, const int src_h,
+                                          const int dst_w, const int dst_h){
+    std::vector<unsigned char> dst(static_cast<size_t>(dst_w) * dst_h * 4);
+    const float scale_x = static_cast<float>(src_w) / dst_w;
+    const float scale_y = static_cast<float>(src_h) / dst_h;
+
+    for(int y=0; y<dst_h; y++){
+        // - 像素中心对齐
+        float fy = std::max((y + 0.5f) * scale_y - 0.5f, 0.0f);
+        int y0 = std::min(static_cast<int>(fy), src_h - 1);
+        int y1 = std::min(y0 + 1, src_h - 1);
+        float wy = fy - y0;
+
+        for(int x=0; x<dst_w; x++){
+            float fx = std::max((x + 0.5f) * scale_x - 0.5f, 0.0f);
+            int x0 = std::min(static_cast<int>(fx), src_w - 1);
+            int x1 = std::min(x0 + 1, src_w - 1);
+            float wx = fx - x0;
+
+            const unsigned char* p00 = src + (static_cast<size_t>(y0) * src_w + x0) * 4;
+            const unsigned char* p01 = src + (static_cast<size_t>(y0) * src_w + x1) * 4;
+            const unsigned char* p10 = src + (static_cast<size_t>(y1) * src_w + x0) * 4;
+            const unsigned char* p11 = src + (static_cast<size_t>(y1) * src_w + x1) * 4;
+            unsigned char* out = &dst[(static_cast<size_t>(y) * dst_w + x) * 4];
+            for(int c=0; c<4; c++){
+                float top = p00[c] + (p01[c] - p00[c]) * wx;
+                float bottom = p10[c] + (p11[c] - p10[c]) * wx;
+                out[c] = static_cast<unsigned char>(std::lround(top + (bottom - top) * wy));
+            }
+        }
+    }
+    return dst;
+}
@@ -0,0 +1,39 @@
+#ifndef OPENGL_TEXTURE_ARRAY_H_
+#define OPENGL_TEXTURE_ARRAY_H_
+
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "../render/gl_handle.h"
+
+/**
+ * GL_TEXTURE_2D_ARRAY 封装, 所有 layer 同尺寸、统一 RGBA8
+ * 用于把同一角色(diffuse / specular / normal / height)的贴图打包, 一次绑定服务多个材质
+ */
+class TextureArray{
+public:
+    TextureArray(const int width, const int height, const int layers);
+
+    TextureArray(const TextureArray&) = delete;
+    TextureArray& operator=(const TextureArray&) = delete;
+
+    // - rgba 为 width * height * 4 字节
+    void upload_layer(const int layer, const unsigned char* rgba);
+
+    void generate_mipmap();
+
+    void bind(const unsigned int unit) const;
+
+public:
+    GlTexture id_;
+    int width_;
+    int height_;
+    int layers_;
+};
+
+/// @brief 双线性重采样 RGBA8 图像, 用于尺寸不一致的贴图并入同一数组
+std::vector<unsigned char> resample_rgba8(const unsigned char* src, const int src_w, const int src_h,
+                                          const int dst_w, const int dst_h);
+
+#endif
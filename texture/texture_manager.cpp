@@ -0,0 +1,404 @@
+#include "./texture_manager.h"
+
+#include <cstring>
+#include <iostream>
+#include <algorithm>
+#include <sys/stat.h>
+
+#include <glad/glad.h>
+
+#include "../io/vfs.h"
+#include "../render/gl_handle.h"
+#include "../io/image_decoder.h"
+
+TextureManager& TextureManager::instance(){
+    static TextureManager manager;
+    return manager;
+}
+
+namespace {
+
+const uint64_t kPrime1 = 11400714785074694791ULL;
+const uint64_t kPrime2 = 14029467366897019727ULL;
+const uint64_t kPrime3 = 1609587929392839161ULL;
+const uint64_t kPrime4 = 9650029242287828579ULL;
+const uint64_t kPrime5 = 2870177450012600261ULL;
+
+uint64_t rotl64(const uint64_t value, const int bits){
+    return (value << bits) | (value >> (64 - bits));
+}
+
+// - 本机字节序读取, 不要求对齐
+uint64_t read64(const unsigned char* data){
+    uint64_t value;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+uint32_t read32(const unsigned char* data){
+    uint32_t value;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+uint64_t xxh64_round(uint64_t acc, const uint64_t input){
+    acc += input * kPrime2;
+    acc = rotl64(acc, 31);
+    return acc * kPrime1;
+}
+
+uint64_t xxh64_merge(uint64_t acc, const uint64_t value){
+    acc ^= xxh64_round(0, value);
+    return acc * kPrime1 + kPrime4;
+}
+
+GLenum channel_format(const int channels){
+    if(channels == 1)
+        return GL_RED;
+    if(channels == 2)
+        return GL_RG;
+    if(channels == 3)
+        return GL_RGB;
+    return GL_RGBA;
+}
+
+}
+
+uint64_t TextureManager::content_hash(const unsigned char* data, const size_t size){
+    const unsigned char* p = data;
+    const unsigned char* end = data + size;
+    uint64_t hash = 0;
+    if(size >= 32){
+        // - 4 路独立累加, 每轮 32 字节
+        uint64_t v1 = kPrime1 + kPrime2, v2 = kPrime2, v3 = 0, v4 = 0 - kPrime1;
+        const unsigned char* limit = end - 32;
+        do{
+            v1 = xxh64_round(v1, read64(p));
+            v2 = xxh64_round(v2, read64(p + 8));
+            v3 = xxh64_round(v3, read64(p + 16));
+            v4 = xxh64_round(v4, read64(p + 24));
+            p += 32;
+        }while(p <= limit);
+        hash = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+        hash = xxh64_merge(hash, v1);
+        hash = xxh64_merge(hash, v2);
+        hash = xxh64_merge(hash, v3);
+        hash = xxh64_merge(hash, v4);
+    }else{
+        hash = kPrime5;
+    }
+    hash += size;
+
+    for(; p + 8 <= end; p += 8){
+        hash ^= xxh64_round(0, read64(p));
+        hash = rotl64(hash, 27) * kPrime1 + kPrime4;
+    }
+    if(p + 4 <= end){
+        hash ^= read32(p) * kPrime1;
+        hash = rotl64(hash, 23) * kPrime2 + kPrime3;
+        p += 4;
+    }
+    for(; p < end; p++){
+        hash ^= *p * kPrime5;
+        hash = rotl64(hash, 11) * kPrime1;
+    }
+
+    hash ^= hash >> 33;
+    hash *= kPrime2;
+    hash ^= hash >> 29;
+    hash *= kPrime3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+unsigned int TextureManager::acquire(const std::string& img_path){
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // - 路径经 Vfs 解析, 同一文件的不同虚拟路径共用路径缓存
+    const std::string real_path = Vfs::instance().resolve(img_path);
+    struct stat file_stat;
+    if(stat(real_path.c_str(), &file_stat) != 0){
+        std::cout << "ERROR: Read image fail, path " << img_path << std::endl;
+        return 0;
+    }
+
+    // - 路径命中、文件未变且纹理正是由该文件加载的, 直接复用; 其它情况都要哈希并比较内容
+    auto path_it = by_path_.find(real_path);
+    if(path_it != by_path_.end() && path_it->second.size == file_stat.st_size
+       && path_it->second.mtime == file_stat.st_mtime){
+        auto hash_it = by_hash_.find(path_it->second.hash);
+        if(hash_it != by_hash_.end() && entries_[hash_it->second].source_path == real_path){
+            entries_[hash_it->second].ref_count++;
+            hit_count_++;
+            return hash_it->second;
+        }
+    }
+
+    // - mmap 后直接哈希与解码, 不再整文件拷贝
+    MappedFile file = MappedFile::open(real_path);
+    if(!file.valid() || file.size() == 0){
+        std::cout << "ERROR: Read image fail, path " << img_path << std::endl;
+        return 0;
+    }
+
+    const uint64_t hash = content_hash(file.data(), file.size());
+    by_path_[real_path] = {hash, static_cast<long long>(file_stat.st_size), static_cast<long long>(file_stat.st_mtime)};
+
+    const unsigned int reuse_id = find_locked(hash, file.data(), file.size());
+    if(reuse_id != 0){
+        entries_[reuse_id].ref_count++;
+        hit_count_++;
+        std::cout << "Reuse " << img_path << ", texture " << reuse_id << std::endl;
+        return reuse_id;
+    }
+
+    // 加载纹理
+    DecodedImage image;
+    if(!decode_image(file.data(), file.size(), 0, image)){
+        std::cout << "ERROR: Read image fail, path " << img_path << std::endl;
+        return 0;
+    }
+    return insert_locked(img_path, hash, image, real_path, file.data(), file.size());
+}
+
+unsigned int TextureManager::acquire_decoded(const std::string& img_path, const uint64_t hash, const unsigned char* data,
+                                             const size_t size, const DecodedImage& image){
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // - 内嵌图片没有对应文件, 之后比较用保留的编码数据
+    const std::string real_path = Vfs::instance().resolve(img_path);
+    struct stat file_stat;
+    const bool from_file = stat(real_path.c_str(), &file_stat) == 0 && static_cast<size_t>(file_stat.st_size) == size;
+    if(from_file)
+        by_path_[real_path] = {hash, static_cast<long long>(file_stat.st_size), static_cast<long long>(file_stat.st_mtime)};
+
+    const unsigned int reuse_id = find_locked(hash, data, size);
+    if(reuse_id != 0){
+        entries_[reuse_id].ref_count++;
+        hit_count_++;
+        return reuse_id;
+    }
+    if(image.pixels.empty()){
+        std::cout << "ERROR: Read image fail, path " << img_path << std::endl;
+        return 0;
+    }
+    return insert_locked(img_path, hash, image, from_file ? real_path : "", data, size);
+}
+
+bool TextureManager::contains(const uint64_t hash, const unsigned char* data, const size_t size) const{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return find_locked(hash, data, size) != 0;
+}
+
+unsigned int TextureManager::find_locked(const uint64_t hash, const unsigned char* data, const size_t size) const{
+    auto hash_it = by_hash_.find(hash);
+    if(hash_it == by_hash_.end())
+        return 0;
+    const Entry& entry = entries_.at(hash_it->second);
+    if(entry.source_size != size)
+        return 0;
+    if(!entry.source.empty())
+        return std::memcmp(entry.source.data(), data, size) == 0 ? entry.id : 0;
+    if(entry.source_path.empty())
+        return 0;
+    // - 源文件在此期间被改写时比较失败, 按不同内容处理
+    MappedFile file = MappedFile::open(entry.source_path);
+    if(!file.valid() || file.size() != size || std::memcmp(file.data(), data, size) != 0)
+        return 0;
+    return entry.id;
+}
+
+unsigned int TextureManager::insert_locked(const std::string& img_path, const uint64_t hash, const DecodedImage& image,
+                                           const std::string& source_path, const unsigned char* data, const size_t size){
+    const int width = image.width, height = image.height, nrChannels = image.channels;
+    unsigned int texture_id = upload(image.pixels.data(), width, height, nrChannels);
+    std::cout << "Read " << img_path << ", width "<< width << ", height " << height << ", nrChannels" << nrChannels << std::endl;
+
+    Entry entry;
+    entry.id = texture_id;
+    entry.hash = hash;
+    entry.ref_count = 1;
+    entry.bytes = static_cast<size_t>(width) * height * nrChannels * 4 / 3;  // 含 mipmap
+    entry.width = width;
+    entry.height = height;
+    entry.channels = nrChannels;
+    entry.source_path = source_path;
+    entry.source_size = size;
+    if(source_path.empty())
+        entry.source.assign(data, data + size);
+    // - 哈希已被内容不同的纹理占用(碰撞), 不登记, 两者各自使用
+    entry.has_hash = by_hash_.find(hash) == by_hash_.end();
+    if(entry.has_hash)
+        by_hash_[hash] = texture_id;
+    else
+        std::cout << "WARN: content hash collision, upload separately, path " << img_path << std::endl;
+    entries_[texture_id] = std::move(entry);
+    miss_count_++;
+    if(keep_decoded_)
+        decoded_[texture_id] = image;
+
+    return texture_id;
+}
+
+unsigned int TextureManager::upload(const unsigned char* data, const int width, const int height, const int channels, const int levels){
+    unsigned int texture_id;
+    glGenTextures(1, &texture_id);
+    glBindTexture(GL_TEXTURE_2D, texture_id);
+
+    // 设置纹理对象环绕、过滤方式
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    // - 按实际通道数决定格式, 不再按扩展名猜测
+    const GLenum format = channel_format(channels);
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    if(levels > 0){
+        // - 预生成的 mip 链逐层上传
+        const unsigned char* level_data = data;
+        for(int level=0; level<levels; level++){
+            const int level_width = std::max(1, width >> level);
+            const int level_height = std::max(1, height >> level);
+            glTexImage2D(GL_TEXTURE_2D, level, format, level_width, level_height, 0, format, GL_UNSIGNED_BYTE, level_data);
+            level_data += static_cast<size_t>(level_width) * level_height * channels;
+        }
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+    }else{
+        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+        glGenerateMipmap(GL_TEXTURE_2D);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+    return texture_id;
+}
+
+unsigned int TextureManager::acquire_mip_chain(const std::string& name, const uint64_t hash, const int width, const int height,
+                                               const int channels, const int levels, const unsigned char* data){
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // - 资源包里没有编码数据, 哈希命中时读回已有纹理的 level 0 比较
+    auto hash_it = by_hash_.find(hash);
+    if(hash_it != by_hash_.end()){
+        Entry& entry = entries_[hash_it->second];
+        if(entry.width == width && entry.height == height && entry.channels == channels){
+            std::vector<unsigned char> pixels(static_cast<size_t>(width) * height * channels);
+            glBindTexture(GL_TEXTURE_2D, entry.id);
+            glPixelStorei(GL_PACK_ALIGNMENT, 1);
+            glGetTexImage(GL_TEXTURE_2D, 0, channel_format(channels), GL_UNSIGNED_BYTE, pixels.data());
+            glBindTexture(GL_TEXTURE_2D, 0);
+            if(std::memcmp(pixels.data(), data, pixels.size()) == 0){
+                entry.ref_count++;
+                hit_count_++;
+                return entry.id;
+            }
+        }
+    }
+
+    unsigned int texture_id = upload(data, width, height, channels, levels);
+    std::cout << "Read " << name << " (bundle), width "<< width << ", height " << height << ", nrChannels" << channels
+              << ", levels " << levels << std::endl;
+
+    Entry entry;
+    entry.id = texture_id;
+    entry.hash = hash;
+    entry.ref_count = 1;
+    entry.bytes = static_cast<size_t>(width) * height * channels * 4 / 3;  // 含 mipmap
+    entry.width = width;
+    entry.height = height;
+    entry.channels = channels;
+    entry.has_hash = hash_it == by_hash_.end();
+    if(entry.has_hash)
+        by_hash_[hash] = texture_id;
+    else
+        std::cout << "WARN: content hash collision, upload separately, name " << name << std::endl;
+    entries_[texture_id] = std::move(entry);
+    miss_count_++;
+    if(keep_decoded_){
+        DecodedImage& image = decoded_[texture_id];
+        image.width = width;
+        image.height = height;
+        image.channels = channels;
+        image.pixels.assign(data, data + static_cast<size_t>(width) * height * channels);
+    }
+
+    return texture_id;
+}
+
+void TextureManager::adopt(const unsigned int texture_id, const size_t bytes){
+    std::lock_guard<std::mutex> lock(mutex_);
+    Entry& entry = entries_[texture_id];
+    entry.id = texture_id;
+    entry.ref_count++;
+    entry.bytes = bytes;
+}
+
+void TextureManager::retain(const unsigned int texture_id){
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(texture_id);
+    if(it == entries_.end()){
+        std::cout << "WARN: TextureManager retain unknown texture " << texture_id << std::endl;
+        return;
+    }
+    it->second.ref_count++;
+}
+
+void TextureManager::release(const unsigned int texture_id){
+    if(texture_id == 0)
+        return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(texture_id);
+    if(it == entries_.end()){
+        std::cout << "WARN: TextureManager release unknown texture " << texture_id << std::endl;
+        return;
+    }
+    if(--it->second.ref_count > 0)
+        return;
+
+    if(it->second.has_hash)
+        by_hash_.erase(it->second.hash);
+    decoded_.erase(it->second.id);
+    GlDeletionQueue::instance().push(GlObjectType::TEXTURE, it->second.id);
+    entries_.erase(it);
+}
+
+void TextureManager::keep_decoded(const bool keep){
+    std::lock_guard<std::mutex> lock(mutex_);
+    keep_decoded_ = keep;
+    if(!keep)
+        std::unordered_map<unsigned int, DecodedImage>().swap(decoded_);
+}
+
+bool TextureManager::take_decoded(const unsigned int texture_id, DecodedImage& image){
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = decoded_.find(texture_id);
+    if(it == decoded_.end())
+        return false;
+    image = std::move(it->second);
+    decoded_.erase(it);
+    return true;
+}
+
+size_t TextureManager::texture_count() const{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+}
+
+size_t TextureManager::texture_bytes() const{
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t bytes = 0;
+    for(const auto& item : entries_)
+        bytes += item.second.bytes;
+    return bytes;
+}
+
+void TextureManager::info() const{
+    size_t hit_count = 0, miss_count = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        hit_count = hit_count_;
+        miss_count = miss_count_;
+    }
+    std::cout << " - textures " << texture_count() << ", bytes " << texture_bytes()
+              << ", hit " << hit_count << ", miss " << miss_count << std::endl;
+}
@@ -0,0 +1,115 @@
+#ifndef OPENGL_TEXTURE_MANAGER_H_
+#define OPENGL_TEXTURE_MANAGER_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <unordered_map>
+
+#include "../io/image_decoder.h"
+
+/**
+ * 进程内全局纹理管理
+ * - 按文件内容哈希去重: 不同 Model 引用同一图片、或同一图片不同文件名, 只解码上传一次; 哈希命中后再逐字节比较, 碰撞时各自上传
+ * - 引用计数: acquire / release 配对, 计数归零时交给 GlDeletionQueue 延迟删除
+ * 所有调用需在持有 GL context 的线程
+ */
+class TextureManager{
+public:
+    static TextureManager& instance();
+
+    TextureManager(const TextureManager&) = delete;
+    TextureManager& operator=(const TextureManager&) = delete;
+
+    /// @brief 加载图片文件为 GL_TEXTURE_2D, 引用计数 +1
+    /// @return 纹理 id, 失败返回 0
+    unsigned int acquire(const std::string& img_path);
+
+    /// @brief 登记在其它线程读取、解码好的图片(批量预取), 引用计数 +1
+    /// @param hash data 的内容哈希; contains 返回 true 时 image 可为空
+    /// @param data 编码后的原始数据, 哈希命中时用于逐字节比较
+    unsigned int acquire_decoded(const std::string& img_path, const uint64_t hash, const unsigned char* data, const size_t size,
+                                 const DecodedImage& image);
+
+    /// @brief 上传预生成的完整 mip 链(资源包), 按源文件内容哈希去重, 引用计数 +1
+    /// @param data levels 层像素紧密排列, 第 i 层尺寸 max(1, width >> i) x max(1, height >> i)
+    unsigned int acquire_mip_chain(const std::string& name, const uint64_t hash, const int width, const int height,
+                                   const int channels, const int levels, const unsigned char* data);
+
+    // - 内容相同的纹理是否已存在(哈希与字节都相同), 预取时据此跳过解码
+    bool contains(const uint64_t hash, const unsigned char* data, const size_t size) const;
+
+    // - 登记运行时生成的纹理(atlas / 打包贴图等), 之后同样通过 release 释放
+    void adopt(const unsigned int texture_id, const size_t bytes);
+
+    void retain(const unsigned int texture_id);
+
+    void release(const unsigned int texture_id);
+
+    /**
+     * 打开后新上传的图片同时保留一份解码结果(资源包为 level 0), 加载后的打包步骤(atlas / 通道打包 / 纹理数组)取用, 不必再解码
+     * 关闭时丢弃尚未取走的结果
+    */
+    void keep_decoded(const bool keep);
+
+    // - 取走纹理保留的解码结果, 没有时返回 false
+    bool take_decoded(const unsigned int texture_id, DecodedImage& image);
+
+    size_t texture_count() const;
+    size_t texture_bytes() const;
+
+    void info() const;
+
+    // - XXH64, 按 8 字节一个字处理
+    static uint64_t content_hash(const unsigned char* data, const size_t size);
+
+private:
+    TextureManager(){}
+
+    struct Entry{
+        unsigned int id{0};
+        uint64_t hash{0};
+        size_t ref_count{0};
+        size_t bytes{0};
+        bool has_hash{false};       // 碰撞时为 false, 不登记到 by_hash_
+        int width{0};
+        int height{0};
+        int channels{0};
+        // - 哈希命中时比较的原始数据: 散文件只记路径, 没有文件的(内嵌图片)保留一份编码数据; 资源包两者都没有, 比较 level 0 像素
+        std::string source_path;
+        std::vector<unsigned char> source;
+        size_t source_size{0};
+    };
+
+    // - 路径缓存, 文件大小与修改时间不变时跳过读取与哈希
+    struct PathRecord{
+        uint64_t hash{0};
+        long long size{0};
+        long long mtime{0};
+    };
+
+    // - levels 为 0 时由 GL 生成 mipmap
+    unsigned int upload(const unsigned char* data, const int width, const int height, const int channels, const int levels = 0);
+
+    // - 以下需持有 mutex_
+    // - 哈希与原始数据都相同的已有纹理, 没有返回 0
+    unsigned int find_locked(const uint64_t hash, const unsigned char* data, const size_t size) const;
+
+    // - source_path 为空时保留一份 data
+    unsigned int insert_locked(const std::string& img_path, const uint64_t hash, const DecodedImage& image,
+                               const std::string& source_path, const unsigned char* data, const size_t size);
+
+private:
+    mutable std::mutex mutex_;
+    std::unordered_map<unsigned int, Entry> entries_;      // id -> entry
+    std::unordered_map<uint64_t, unsigned int> by_hash_;   // 内容哈希 -> id
+    std::unordered_map<std::string, PathRecord> by_path_;
+    bool keep_decoded_{false};
+    std::unordered_map<unsigned int, DecodedImage> decoded_;   // id -> 保留的解码结果
+
+    size_t hit_count_{0};
+    size_t miss_count_{0};
+};
+
+#endif
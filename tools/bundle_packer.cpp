@@ -0,0 +1,132 @@
+// 离线资源打包: 导入模型, 把预处理好的 mesh 与带完整 mip 链的贴图写成一个 .bundle
+// 用法: bundle_packer <model.obj> <out.bundle> [none|lz4|zstd|deflate] [level]
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <unordered_map>
+
+#include "../io/model.h"
+#include "../io/bundle.h"
+#include "../core/job_system.h"
+
+// - 2x2 box filter 逐级缩小到 1x1, 奇数边长时边缘像素重复采样
+void build_mip_chain(const DecodedImage& image, std::vector<unsigned char>& out, uint32_t& levels){
+    const int channels = image.channels;
+    std::vector<unsigned char> level(image.pixels.data(), image.pixels.data() + image.pixels.size());
+    int width = image.width, height = image.height;
+    levels = 1;
+    out.insert(out.end(), level.begin(), level.end());
+
+    while(width > 1 || height > 1){
+        const int next_width = std::max(1, width / 2), next_height = std::max(1, height / 2);
+        std::vector<unsigned char> next(static_cast<size_t>(next_width) * next_height * channels);
+        for(int y=0; y<next_height; y++){
+            const int y0 = std::min(y * 2, height - 1), y1 = std::min(y * 2 + 1, height - 1);
+            for(int x=0; x<next_width; x++){
+                const int x0 = std::min(x * 2, width - 1), x1 = std::min(x * 2 + 1, width - 1);
+                for(int c=0; c<channels; c++){
+                    const int sum = level[(static_cast<size_t>(y0) * width + x0) * channels + c]
+                                  + level[(static_cast<size_t>(y0) * width + x1) * channels + c]
+                                  + level[(static_cast<size_t>(y1) * width + x0) * channels + c]
+                                  + level[(static_cast<size_t>(y1) * width + x1) * channels + c];
+                    next[(static_cast<size_t>(y) * next_width + x) * channels + c] = static_cast<unsigned char>((sum + 2) / 4);
+                }
+            }
+        }
+        level.swap(next);
+        width = next_width;
+        height = next_height;
+        levels++;
+        out.insert(out.end(), level.begin(), level.end());
+    }
+}
+
+struct TextureChunk{
+    std::string name;
+    uint64_t hash{0};
+    std::vector<unsigned char> data;
+    bool ok{false};
+};
+
+int main(int argc, char** argv){
+    if(argc < 3){
+        std::cout << "usage: bundle_packer <model.obj> <out.bundle> [none|lz4|zstd|deflate] [level]" << std::endl;
+        return -1;
+    }
+    const std::string model_path = argv[1];
+    const std::string out_path = argv[2];
+    BundleCodec codec = bundle_default_codec();
+    if(argc > 3 && !bundle_codec_from_name(argv[3], codec)){
+        std::cout << "ERROR: codec " << argv[3] << " not available" << std::endl;
+        return -1;
+    }
+    const int level = argc > 4 ? std::atoi(argv[4]) : 0;
+
+    const auto start = std::chrono::steady_clock::now();
+    Model model(model_path, false);
+
+    // - 贴图并行解码与生成 mip, 顺序与首次出现顺序一致
+    std::vector<TextureChunk> textures;
+    std::unordered_map<std::string, size_t> texture_index;
+    for(const Mesh& mesh : model.meshes_){
+        for(const Texture& texture : mesh.textures_){
+            if(texture_index.emplace(texture.name, textures.size()).second){
+                TextureChunk chunk;
+                chunk.name = texture.name;
+                textures.push_back(chunk);
+            }
+        }
+    }
+    JobSystem& jobs = JobSystem::instance();
+    JobCounter counter;
+    for(TextureChunk& chunk : textures){
+        TextureChunk* out = &chunk;
+        const std::string img_path = model.directory_ + "/" + chunk.name;
+        jobs.run([out, img_path](){
+            MappedFile file = Vfs::instance().map(img_path);
+            DecodedImage image;
+            if(!file.valid() || !decode_image(file.data(), file.size(), 0, image)){
+                std::cout << "ERROR: Read image fail, path " << img_path << std::endl;
+                return;
+            }
+            out->hash = TextureManager::content_hash(file.data(), file.size());
+            BundleTextureHeader header{static_cast<uint32_t>(image.width), static_cast<uint32_t>(image.height),
+                                       static_cast<uint32_t>(image.channels), 0};
+            out->data.resize(sizeof(header));
+            build_mip_chain(image, out->data, header.levels);
+            std::memcpy(out->data.data(), &header, sizeof(header));
+            out->ok = true;
+        }, &counter, "texture_mip");
+    }
+    jobs.wait(counter);
+
+    BundleWriter writer(codec, level);
+    if(!writer.open(out_path))
+        return -1;
+
+    std::vector<unsigned char> manifest;
+    const uint32_t mesh_count = static_cast<uint32_t>(model.meshes_.size());
+    append_bytes(manifest, &mesh_count, sizeof(mesh_count));
+    bool ok = writer.add("model", BUNDLE_CHUNK_MODEL, manifest);
+    for(size_t i=0; i<model.meshes_.size() && ok; i++)
+        ok = writer.add("mesh/" + std::to_string(i), BUNDLE_CHUNK_MESH, serialize_mesh(model.meshes_[i]));
+    for(const TextureChunk& chunk : textures){
+        if(!ok)
+            break;
+        if(!chunk.ok)
+            continue;
+        ok = writer.add("texture/" + chunk.name, BUNDLE_CHUNK_TEXTURE, chunk.data, chunk.hash);
+    }
+    ok = writer.close() && ok;
+    if(!ok)
+        return -1;
+
+    const auto end = std::chrono::steady_clock::now();
+    std::cout << "OUT: bundle " << out_path << ", codec " << bundle_codec_name(codec)
+              << ", meshes " << model.meshes_.size() << ", textures " << textures.size()
+              << ", " << writer.raw_bytes() / (1024.0 * 1024.0) << " MB -> " << writer.packed_bytes() / (1024.0 * 1024.0)
+              << " MB, " << std::chrono::duration<double, std::milli>(end - start).count() << " ms" << std::endl;
+    return 0;
+}
@@ -0,0 +1,37 @@
+// 离线构建点云八叉树: 读取二进制 PLY, 写出 PointCloudRenderer 使用的 .octree
+// 用法: point_octree_builder <scan.ply> <out.octree> [points_per_node]
+
+#include <chrono>
+#include <string>
+#include <cstdlib>
+#include <iostream>
+
+#include "../io/ply.h"
+#include "../io/point_octree.h"
+
+int main(int argc, char** argv){
+    if(argc < 3){
+        std::cout << "usage: point_octree_builder <scan.ply> <out.octree> [points_per_node]" << std::endl;
+        return -1;
+    }
+    const std::string ply_path = argv[1];
+    const std::string out_path = argv[2];
+    const uint32_t points_per_node = argc > 3 ? static_cast<uint32_t>(std::atoi(argv[3])) : kPointOctreeDefaultNodePoints;
+
+    const auto start = std::chrono::steady_clock::now();
+    PlyFile file;
+    PlyData cloud;
+    if(!file.open(ply_path) || !file.read(cloud))
+        return -1;
+    // - 只用到顶点, 面片数据提前释放
+    std::vector<unsigned int>().swap(cloud.indices);
+    std::vector<float>().swap(cloud.normals);
+    std::vector<float>().swap(cloud.tex_coords);
+
+    if(!build_point_octree(cloud, out_path, points_per_node))
+        return -1;
+    const auto end = std::chrono::steady_clock::now();
+    std::cout << "OUT: " << out_path << " built in " << std::chrono::duration<double, std::milli>(end - start).count()
+              << " ms" << std::endl;
+    return 0;
+}